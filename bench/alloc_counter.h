@@ -0,0 +1,16 @@
+#ifndef STRATEGY_BENCH_ALLOC_COUNTER_H_
+#define STRATEGY_BENCH_ALLOC_COUNTER_H_
+
+#include <stddef.h>
+
+// counts of the global operator new/delete replaced in bench.cpp
+struct AllocCounter {
+  // allocations made by the calling thread so far
+  static size_t Allocs();
+  // heap bytes currently live, all threads
+  static long LiveBytes();
+  // resident set size from /proc/self/statm
+  static long RssBytes();
+};
+
+#endif  // STRATEGY_BENCH_ALLOC_COUNTER_H_
@@ -0,0 +1,114 @@
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libconfig.h++>
+
+#include <atomic>
+#include <new>
+
+#include "bench/alloc_counter.h"
+#include "bench/strategy_bench.h"
+#include "bench/kernel_bench.h"
+
+namespace {
+
+thread_local size_t t_allocs = 0;
+std::atomic<long> g_live_bytes(0);
+
+void* Allocate(size_t n) {
+  void* p = malloc(n == 0 ? 1 : n);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  t_allocs++;
+  g_live_bytes += malloc_usable_size(p);
+  return p;
+}
+
+void Release(void* p) {
+  if (p == nullptr) {
+    return;
+  }
+  g_live_bytes -= malloc_usable_size(p);
+  free(p);
+}
+
+}  // namespace
+
+void* operator new(size_t n) {
+  return Allocate(n);
+}
+
+void* operator new[](size_t n) {
+  return Allocate(n);
+}
+
+void operator delete(void* p) noexcept {
+  Release(p);
+}
+
+void operator delete[](void* p) noexcept {
+  Release(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  Release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  Release(p);
+}
+
+size_t AllocCounter::Allocs() {
+  return t_allocs;
+}
+
+long AllocCounter::LiveBytes() {
+  return g_live_bytes;
+}
+
+long AllocCounter::RssBytes() {
+  long pages = 0;
+  long resident = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (f == nullptr) {
+    return 0;
+  }
+  if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+    resident = 0;
+  }
+  fclose(f);
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// bench <config>
+// bench --kernels [window] [rounds]
+int main(int argc, char** argv) {
+  if (argc >= 2 && strcmp(argv[1], "--kernels") == 0) {
+    size_t window = argc > 2 ? strtoul(argv[2], nullptr, 10) : 50000;
+    int rounds = argc > 3 ? atoi(argv[3]) : 100;
+    KernelBench bench(window, rounds, 1);
+    bench.Run();
+    return 0;
+  }
+  if (argc != 2) {
+    printf("usage: %s <bench.config>\n       %s --kernels [window] [rounds]\n", argv[0], argv[0]);
+    return 1;
+  }
+  libconfig::Config cfg;
+  try {
+    cfg.readFile(argv[1]);
+  } catch (const libconfig::FileIOException &) {
+    printf("read %s failed\n", argv[1]);
+    return 1;
+  } catch (const libconfig::ParseException & e) {
+    printf("parse %s failed at line %d: %s\n", e.getFile(), e.getLine(), e.getError());
+    return 1;
+  }
+  StrategyBench bench(cfg.getRoot());
+  bench.Run();
+  return 0;
+}
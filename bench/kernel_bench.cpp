@@ -0,0 +1,64 @@
+#include <stdio.h>
+
+#include <chrono>
+#include <random>
+
+#include "util/rolling_stats.h"
+#include "bench/kernel_bench.h"
+
+namespace {
+
+inline int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// keeps a result alive across the timed loop
+volatile double g_sink;
+
+}  // namespace
+
+KernelBench::KernelBench(size_t window, int rounds, uint32_t seed)
+  : window_(window > 0 ? window : 1),
+    rounds_(rounds > 0 ? rounds : 1) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> step(0.0, 0.5);
+  double mid = 12.5;
+  v_.reserve(window_);
+  for (size_t i = 0; i < window_; i++) {
+    mid += step(rng);
+    v_.push_back(mid);
+  }
+}
+
+template <typename F>
+double KernelBench::TimeNs(F f) const {
+  int64_t begin = NowNs();
+  for (int r = 0; r < rounds_; r++) {
+    f();
+  }
+  return static_cast<double>(NowNs() - begin) / rounds_;
+}
+
+void KernelBench::Run() {
+  const StatKernels & best = StatKernels::Best();
+  const StatKernels & scalar = StatKernels::Scalar();
+  const double* v = v_.data();
+  size_t n = v_.size();
+  printf("window %zu, rounds %d, best isa %s\n", n, rounds_, best.isa);
+  double mean = n > 0 ? scalar.sum(v, n) / n : 0.0;
+  printf("%-12s %12s %12s\n", "kernel", "best_ns", "scalar_ns");
+  printf("%-12s %12.0lf %12.0lf\n", "sum", TimeNs([&]() { g_sink = best.sum(v, n); }), TimeNs([&]() { g_sink = scalar.sum(v, n); }));
+  printf("%-12s %12.0lf %12.0lf\n", "sum_sq_dev", TimeNs([&]() { g_sink = best.sum_sq_dev(v, n, mean); }), TimeNs([&]() { g_sink = scalar.sum_sq_dev(v, n, mean); }));
+
+  // a full window fed one by one, then resynced: the drift the O(1)
+  // updates left and what one recalibration now costs
+  RollingStats stats(static_cast<int>(n));
+  for (int pass = 0; pass < 2; pass++) {
+    for (double x : v_) {
+      stats.Add(x);
+    }
+  }
+  double rolling_std = stats.Std();
+  double resync_ns = TimeNs([&]() { stats.Resync(); });
+  printf("resync %.0lf ns, rolling std %.17g, exact std %.17g\n", resync_ns, rolling_std, stats.Std());
+}
@@ -0,0 +1,30 @@
+#ifndef STRATEGY_BENCH_KERNEL_BENCH_H_
+#define STRATEGY_BENCH_KERNEL_BENCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "util/stat_kernels.h"
+
+// times StatKernels::Best() against Scalar() on a random walk of `window`
+// mids, and a full RollingStats::Resync (the per-recalibration cost)
+// against feeding the window sample by sample. test/stat_kernels_test.cpp
+// checks that the two agree
+class KernelBench {
+ public:
+  KernelBench(size_t window, int rounds, uint32_t seed);
+
+  void Run();
+
+ private:
+  template <typename F>
+  double TimeNs(F f) const;
+
+  size_t window_;
+  int rounds_;
+  std::vector<double> v_;
+};
+
+#endif  // STRATEGY_BENCH_KERNEL_BENCH_H_
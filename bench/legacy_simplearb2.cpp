@@ -0,0 +1,376 @@
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <deque>
+
+#include "bench/legacy_simplearb2.h"
+
+LegacySimpleArb2::LegacySimpleArb2(const libconfig::Setting & param_setting, std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender, TimeController* tc, ContractWorker* cw, HistoryWorker* hw, const std::string & date, StrategyMode::Enum mode, std::ofstream* exchange_file)
+  : date_(date),
+    max_close_try_(10),
+    close_round_(0),
+    sample_head_(0),
+    sample_tail_(0),
+    no_close_today_(false),
+    exchange_file_(exchange_file) {
+  m_tc = tc;
+  m_cw = cw;
+  m_hw = hw;
+  SetStrategyMode(mode, exchange_file);
+  if (FillStratConfig(param_setting)) {
+    RunningSetup(ticker_strat_map, uisender, ordersender);
+  }
+}
+
+LegacySimpleArb2::~LegacySimpleArb2() {
+}
+
+void LegacySimpleArb2::RunningSetup(std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender) {
+  m_ui_sender = uisender;
+  m_order_sender = ordersender;
+  (*ticker_strat_map)[main_ticker_].emplace_back(this);
+  (*ticker_strat_map)[hedge_ticker_].emplace_back(this);
+  (*ticker_strat_map)["positionend"].emplace_back(this);
+  MarketSnapshot shot;
+  m_shot_map[main_ticker_] = shot;
+  m_shot_map[hedge_ticker_] = shot;
+  m_avgcost_map[main_ticker_] = 0.0;
+  m_avgcost_map[hedge_ticker_] = 0.0;
+  legs_.Bind(main_ticker_, hedge_ticker_, &m_shot_map, &m_next_shot_map, &m_position_map, &m_avgcost_map);
+}
+
+bool LegacySimpleArb2::FillStratConfig(const libconfig::Setting& param_setting) {
+  try {
+    std::string unique_name = param_setting["unique_name"];
+    const libconfig::Setting & contract_setting = m_cw->Lookup(unique_name);
+    m_strat_name = unique_name;
+    if (param_setting.exists("main_ticker") && param_setting.exists("hedge_ticker")) {
+      std::string m = param_setting["main_ticker"];
+      std::string h = param_setting["hedge_ticker"];
+      main_ticker_ = m;
+      hedge_ticker_ = h;
+    } else {
+      auto v = m_hw->GetAllTicker(unique_name);
+      if (v.size() < 2) {
+        SLOG_ERROR("no enough ticker for %s\n", unique_name.c_str());
+        return false;
+      }
+      main_ticker_ = v[1].first;
+      hedge_ticker_ = v[0].first;
+    }
+    max_pos_ = param_setting["max_position"];
+    train_samples_ = param_setting["train_samples"];
+    double m_r = param_setting["min_range"];
+    double m_p = param_setting["min_profit"];
+    min_price_move_ = contract_setting["min_price_move"];
+    min_profit_ = m_p * min_price_move_;
+    min_range_ = m_r * min_price_move_;
+    double spread_threshold_int = param_setting["spread_threshold"];
+    spread_threshold_ = spread_threshold_int*min_price_move_;
+    m_max_holding_sec = param_setting["max_holding_sec"];
+    range_width_ = param_setting["range_width"];
+    std::string con = GetCon(main_ticker_);
+    cancel_limit_ = contract_setting["cancel_limit"];
+    max_round_ = param_setting["max_round"];
+    if (param_setting.exists("no_close_today")) {
+      no_close_today_ = param_setting["no_close_today"];
+    }
+    int series_capacity = train_samples_;
+    if (param_setting.exists("series_capacity")) {
+      series_capacity = param_setting["series_capacity"];
+    }
+    mids_.Reset(std::max(series_capacity, train_samples_));
+    if (param_setting.exists("spill_file")) {
+      std::string spill_file = param_setting["spill_file"];
+      mids_.Spill(spill_file);
+    }
+  } catch(const libconfig::SettingNotFoundException &nfex) {
+    SLOG_ERROR("Setting '%s' is missing", nfex.getPath());
+    exit(1);
+  } catch(const libconfig::SettingTypeException &tex) {
+    SLOG_ERROR("Setting '%s' has the wrong type", tex.getPath());
+    exit(1);
+  } catch (const std::exception& ex) {
+    SLOG_ERROR("EXCEPTION: %s\n", ex.what());
+    exit(1);
+  }
+  mid_stats_.Reset(train_samples_);
+  soft_stats_.Reset(100);  // short window for SoftCloseLogic
+  return true;
+}
+
+void LegacySimpleArb2::Stop() {
+  CancelAll(main_ticker_);
+  m_ss = StrategyStatus::Stopped;
+}
+
+void LegacySimpleArb2::DoOperationAfterCancelled(Order* o) {
+  SLOG_INFO("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
+  if (m_cancel_map[o->ticker] > cancel_limit_) {
+    SLOG_ERROR("ticker %s hit cancel limit!\n", o->ticker);
+    Stop();
+  }
+}
+
+double LegacySimpleArb2::OrderPrice(const std::string & ticker, OrderSide::Enum side, bool control_price) {
+  Leg::Enum leg = legs_.LegOf(ticker);
+  if (leg == Leg::Unknown) {
+    SLOG_ERROR("error ticker %s\n", ticker.c_str());
+    return -1.0;
+  }
+  const LegState & hedge = legs_[Leg::Hedge];
+  if (m_mode == StrategyMode::NextTest) {
+    return (leg == Leg::Hedge) ? hedge.NextTake(side) : legs_[Leg::Main].Take(side);
+  } else {
+    if (leg == Leg::Hedge) {
+      return hedge.Take(side);
+    } else {
+      // price hunter mode
+      return (side == OrderSide::Buy) ? RoundPrice(hedge.Bid() + down_diff_, min_price_move_, 1) : RoundPrice(hedge.Ask() + up_diff_, min_price_move_, -1);
+    }
+  }
+}
+
+void LegacySimpleArb2::ForceFlat() {
+  int pos = *legs_[Leg::Main].pos;
+  if (pos == 0) {
+    return;
+  }
+  OrderSide::Enum side = (pos > 0) ? OrderSide::Sell : OrderSide::Buy;
+  for (int i = 0; i < max_close_try_; i++) {
+    if (Close(side)) {
+      break;
+    }
+    if (i == max_close_try_ - 1) {
+      SLOG_ERROR("[%s %s]try max_close times, cant close this order!\n", main_ticker_.c_str(), hedge_ticker_.c_str());
+      SLOG_ORDERS(LogLevel::Warn, m_order_map);
+      m_order_map.clear();  // it's a temp solution, TODO
+      Close(side);
+    }
+  }
+}
+
+bool LegacySimpleArb2::Close(OrderSide::Enum side) {
+  if (!m_order_map.empty()) {
+    SLOG_WARN("[%s %s]block order exsited! no close\n", main_ticker_.c_str(), hedge_ticker_.c_str());
+    SLOG_ORDERS(LogLevel::Warn, m_order_map);
+    return false;
+  }
+  double price = legs_[Leg::Main].Take(side);
+  int64_t size = (side == OrderSide::Buy) ? 1 : -1;
+  target_hedge_price_ = (side == OrderSide::Buy) ? legs_[Leg::Hedge].Bid() : legs_[Leg::Hedge].Ask();
+  Order* o = PlaceOrder(main_ticker_, price, size, no_close_today_, "close");
+  SLOG_ORDER(LogLevel::Info, o);
+  return true;
+}
+
+void LegacySimpleArb2::CloseLogic() {
+  int pos = *legs_[Leg::Main].pos;
+  if (pos == 0) {
+    return;
+  }
+  double mid = mids_.back();
+  if (pos > 0 && mid > mean_ + current_spread_/2) {
+    SLOG_INFO("[%s %s]CloseLogic: mid=%lf, mean=%lf, pos=%d, current_spread_=%lf\n", main_ticker_.c_str(), hedge_ticker_.c_str(), mid, mean_, pos, current_spread_);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Main].shot);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Hedge].shot);
+    Close(OrderSide::Sell);
+  } else if (pos < 0 && mid < mean_ - current_spread_/2) {
+    SLOG_INFO("[%s %s]CloseLogic: mid=%lf, mean=%lf, pos=%d\n", main_ticker_.c_str(), hedge_ticker_.c_str(), mid, mean_, pos);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Main].shot);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Hedge].shot);
+    Close(OrderSide::Buy);
+  }
+}
+
+void LegacySimpleArb2::SoftCloseLogic() {
+  int pos = *legs_[Leg::Main].pos;
+  if (pos == 0) {
+    return;
+  }
+  double mid = mids_.back();
+  double softmean = (soft_stats_.Mean() + mean_) / 2;
+  // double softmean = soft_stats_.Mean();
+  if (pos > 0 && mid > softmean + current_spread_/2) {
+    SLOG_INFO("[%s %s]CloseLogic: mid=%lf, softmean=%lf, pos=%d, current_spread_=%lf\n", main_ticker_.c_str(), hedge_ticker_.c_str(), mid, softmean, pos, current_spread_);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Main].shot);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Hedge].shot);
+    Close(OrderSide::Sell);
+  } else if (pos < 0 && mid < softmean - current_spread_/2) {
+    SLOG_INFO("[%s %s]CloseLogic: mid=%lf, softmean=%lf, pos=%d\n", main_ticker_.c_str(), hedge_ticker_.c_str(), mid, softmean, pos);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Main].shot);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Hedge].shot);
+    Close(OrderSide::Buy);
+  }
+}
+
+void LegacySimpleArb2::Flatting() {
+  if (IsAlign()) {
+    CloseLogic();
+  }
+}
+
+void LegacySimpleArb2::Open(OrderSide::Enum side) {
+  if (!m_order_map.empty()) {
+    SLOG_WARN("block order exsited! no open \n");
+    SLOG_ORDERS(LogLevel::Warn, m_order_map);
+    return;
+  }
+  double price = legs_[Leg::Main].Take(side);
+  int64_t size = (side == OrderSide::Buy) ? 1 : -1;
+  Order* o = PlaceOrder(main_ticker_, price, size, no_close_today_, "open");
+  target_hedge_price_ = (side == OrderSide::Buy) ? legs_[Leg::Hedge].Bid() : legs_[Leg::Hedge].Ask();
+  SLOG_ORDER(LogLevel::Info, o);
+}
+
+bool LegacySimpleArb2::OpenLogic() {
+  if (abs(*legs_[Leg::Main].pos) >= max_pos_ || !m_order_map.empty()) {
+    return false;
+  }
+  const MarketSnapshot & main_shot = *legs_[Leg::Main].shot;
+  const MarketSnapshot & hedge_shot = *legs_[Leg::Hedge].shot;
+  if (main_shot.asks[0] - hedge_shot.asks[0] >= up_diff_) {  // sell at high price
+    if (hedge_shot.ask_sizes[0] < 5) {  // filter those too thin oppounity
+      return false;
+    }
+    Order* o = PlaceOrder(main_ticker_, main_shot.asks[0], -1, no_close_today_, "open");
+    SLOG_ORDER(LogLevel::Info, o);
+  } else if (main_shot.bids[0] - hedge_shot.bids[0] <= down_diff_) {  // buy at low price
+    if (hedge_shot.bid_sizes[0] < 5) {  // filter those too thin oppounity
+      return false;
+    }
+    Order* o = PlaceOrder(main_ticker_, main_shot.bids[0], 1, no_close_today_, "open");
+    SLOG_ORDER(LogLevel::Info, o);
+  } else {
+    return false;
+  }
+  SLOG_SHOT(LogLevel::Info, main_shot);
+  SLOG_SHOT(LogLevel::Info, hedge_shot);
+  return true;
+}
+
+void LegacySimpleArb2::Run() {
+  if (!IsAlign() || close_round_ >= max_round_) {
+    return;
+  }
+  if (OpenLogic()) {
+    return;
+  }
+  CloseLogic();
+}
+
+void LegacySimpleArb2::UpdateParams(const std::string& tag) {
+  if (sample_tail_ < train_samples_) {
+    SLOG_ERROR("calparams wrong, exit\n");
+    exit(1);
+  }
+  SLOG_INFO("[%s %s] sample_tail_=%d, sample_head_=%d, train_samples_=%d\n", main_ticker_.c_str(), hedge_ticker_.c_str(), sample_tail_, sample_head_, train_samples_);
+  double avg = mid_stats_.Mean();
+  double std = mid_stats_.Std();
+  double main_mid = legs_[Leg::Main].Mid();
+  double hedge_mid = legs_[Leg::Hedge].Mid();
+  FeePoint main_point = m_cw->CalFeePoint(main_ticker_, main_mid, 1, main_mid, 1, no_close_today_);
+  FeePoint hedge_point = m_cw->CalFeePoint(hedge_ticker_, hedge_mid, 1, hedge_mid, 1, no_close_today_);
+  double round_fee_cost = main_point.open_fee_point + main_point.close_fee_point + hedge_point.open_fee_point + hedge_point.close_fee_point;
+  double margin = std::max(range_width_ * std, min_range_) + round_fee_cost;
+  up_diff_ = avg + margin;
+  down_diff_ = avg - margin;
+  mean_ = avg;
+  spread_threshold_ = margin - min_profit_ - round_fee_cost;
+  SLOG_INFO("[%s %s]%s cal done,mean is %lf, std is %lf, parmeters: [%lf,%lf], spread_threshold is %lf, min_profit is %lf, fee_point=%lf\n", main_ticker_.c_str(), hedge_ticker_.c_str(), tag.c_str(), avg, std, down_diff_, up_diff_, spread_threshold_, min_profit_, round_fee_cost);
+  sample_head_ = sample_tail_;
+}
+
+void LegacySimpleArb2::DoOperationAfterUpdateData(const MarketSnapshot& shot) {
+  legs_.OnShot(shot, kNoTicker);
+  current_spread_ = legs_[Leg::Main].Spread();
+  if (IsAlign()) {  // && Spread_Good()) {
+    mids_.push_back(legs_.MidDiff());
+    mid_stats_.Add(mids_.back());
+    soft_stats_.Add(mids_.back());
+    SLOG_DEBUG("[%s %s]mid_diff=%lf, head:%d, tail:%d\n", main_ticker_.c_str(), hedge_ticker_.c_str(), mids_.back(), sample_head_, sample_tail_);
+    if (++ sample_tail_ - sample_head_ > train_samples_) {
+      UpdateParams("[tail-head hit]");
+    }
+  }
+}
+
+void LegacySimpleArb2::Resume() {
+  sample_head_ = sample_tail_;
+}
+
+bool LegacySimpleArb2::Ready() {
+  return sample_tail_ - sample_head_ >= train_samples_;
+}
+
+void LegacySimpleArb2::ModerateOrders(const std::string & ticker) {
+  if (m_mode != StrategyMode::Real) {
+    return;
+  }
+  for (auto m : m_order_map) {
+    Order* o = m.second;
+    if (!o->Valid()) {
+      continue;
+    }
+    double reasonable_price = OrderPrice(o->ticker, o->side, false);
+    if (fabs(reasonable_price - o->price) < min_price_move_ / 2) {  // this tick is the order sent tick or tick price not changed
+      return;
+    }
+    Leg::Enum leg = legs_.LegOf(o->ticker);
+    if (leg == Leg::Main) {
+      if ((o->side == OrderSide::Buy && o->price - reasonable_price >= min_price_move_ / 2)  //  buy, order price > reasonable buy price, loss
+       || (o->side == OrderSide::Sell && o->price - reasonable_price <= min_price_move_ / 2)) {  // sell, order price < reasonable sell
+        CancelOrder(o);
+      }
+    } else if (leg == Leg::Hedge) {
+      ModOrder(o);
+    } else {
+      continue;
+    }
+  }
+}
+
+void LegacySimpleArb2::Start() {
+  AsyncLogger::Instance().Register();  // the log ring, before the first tick
+  UpdateParams("[start]");
+}
+
+void LegacySimpleArb2::DoOperationAfterFilled(Order* o, const ExchangeInfo& info) {
+    std::string tbd = o->tbd;
+  bool is_close = (tbd.find("close") != string::npos);
+  SLOG_ORDER(LogLevel::Info, o);
+  Leg::Enum leg = legs_.LegOf(info.ticker);
+  if (leg == Leg::Main) {
+    OrderSide::Enum hedge_side = (info.side == OrderSide::Buy) ? OrderSide::Sell : OrderSide::Buy;
+    double price = legs_[Leg::Hedge].Take(hedge_side);
+    if (m_mode == StrategyMode::NextTest) {
+      price = legs_[Leg::Hedge].NextTake(hedge_side);
+    }
+    int64_t size = (info.side == OrderSide::Buy) ? -1 : 1;
+    string orderinfo = is_close ? "close" : "open";
+    Order* o = PlaceOrder(hedge_ticker_, price, size, no_close_today_, orderinfo);
+    SLOG_ORDER(LogLevel::Info, o);
+  } else if (leg == Leg::Hedge) {
+    if (is_close) {
+      close_round_++;
+      UpdateParams("[close]");
+    } else {
+      sample_head_ = sample_tail_;
+    }
+  } else {
+  }
+}
+
+bool LegacySimpleArb2::Spread_Good() {
+  return current_spread_ <= spread_threshold_;
+}
+
+bool LegacySimpleArb2::IsAlign() {
+  const timeval & main_time = legs_[Leg::Main].shot->time;
+  const timeval & hedge_time = legs_[Leg::Hedge].shot->time;
+  if (main_time.tv_sec == hedge_time.tv_sec && abs(main_time.tv_usec - hedge_time.tv_usec) < 100000) {
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "simplearb/simplearb.h"
+#include "simplearb2/simplearb2.h"
+#include "coinarb/coinarb.h"
+#include "pairtrading/pairtrading.h"
+#include "multiarb/multiarb.h"
+#include "simplemaker/simplemaker.h"
+#include "util/async_logger.h"
+#include "bench/alloc_counter.h"
+#include "bench/legacy_simplearb2.h"
+#include "bench/strategy_bench.h"
+#include "bench/synthetic_feed.h"
+
+namespace {
+
+const int kSamples = 8;  // heap/rss samples per phase
+
+inline int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+StrategyBench::StrategyBench(const libconfig::Setting & root)
+  : root_(root),
+    ticks_(100000),
+    price_(3000.0),
+    seed_(1) {
+  try {
+    LoadWorkers(root, &workers_);
+    date_ = root["date"].c_str();
+    if (root.exists("bench")) {
+      const libconfig::Setting & bench = root["bench"];
+      if (bench.exists("ticks")) {
+        ticks_ = bench["ticks"];
+      }
+      if (bench.exists("rates")) {
+        for (int i = 0; i < bench["rates"].getLength(); i++) {
+          rates_.emplace_back(static_cast<double>(bench["rates"][i]));
+        }
+      }
+      if (bench.exists("price")) {
+        price_ = bench["price"];
+      }
+      if (bench.exists("seed")) {
+        seed_ = static_cast<int>(bench["seed"]);
+      }
+    }
+    if (rates_.empty()) {
+      rates_.emplace_back(100.0);
+    }
+  } catch (const libconfig::SettingException & e) {
+    printf("bench config error at %s: %s\n", e.getPath(), e.what());
+    exit(1);
+  }
+}
+
+template <typename S>
+void StrategyBench::Legs(const S* s, std::string* main, std::string* hedge, double* tick) {
+  *main = s->main_ticker_;
+  *hedge = s->hedge_ticker_;
+  *tick = s->min_price_move_;
+}
+
+template <>
+void StrategyBench::Legs<SimpleArb>(const SimpleArb* s, std::string* main, std::string* hedge, double* tick) {
+  *main = s->main_ticker;
+  *hedge = s->hedge_ticker;
+  *tick = s->min_price_move;
+}
+
+template <>
+void StrategyBench::Legs<SimpleMaker>(const SimpleMaker* s, std::string* main, std::string* hedge, double* tick) {
+  *main = s->main_ticker;
+  *hedge = s->hedge_ticker;
+  *tick = s->min_price;
+}
+
+template <>
+void StrategyBench::Legs<MultiArb>(const MultiArb* s, std::string* main, std::string* hedge, double* tick) {
+  *main = s->tickers[s->book.main_slot[0]];
+  *hedge = s->tickers[s->book.hedge_slot[0]];
+  *tick = s->book.min_price_move[0];
+}
+
+template <typename S>
+Order* StrategyBench::Send(S* s, const std::string & main, double price, OrderIntent intent, OrderSide::Enum side) {
+  return s->PlaceOrder(main, price, side == OrderSide::Buy ? 1 : -1, false, intent.Tag());
+}
+
+// only orders sent through Send belong to a pair
+template <>
+Order* StrategyBench::Send<MultiArb>(MultiArb* s, const std::string & main, double price, OrderIntent intent, OrderSide::Enum side) {
+  return s->Send(0, intent, side, 1);
+}
+
+template <typename S>
+S* StrategyBench::New(const libconfig::Setting & setting, const StrategyEnv & env) {
+  // type was matched by the caller, so the factory builds an S
+  return static_cast<S*>(NewStrategy(setting, env));
+}
+
+template <>
+LegacySimpleArb2* StrategyBench::New<LegacySimpleArb2>(const libconfig::Setting & setting, const StrategyEnv & env) {
+  return new LegacySimpleArb2(setting, env.ticker_strat_map, env.ui_sender, env.order_sender, env.tc, env.cw, env.hw, env.date, env.mode, env.exchange_file);
+}
+
+template <typename S>
+S* StrategyBench::Build(const libconfig::Setting & setting) {
+  StrategyEnv env;
+  env.ticker_strat_map = &ticker_strat_map_;
+  env.ui_sender = &ui_sender_;
+  env.order_sender = &order_sender_;
+  env.tc = workers_.tc.get();
+  env.cw = workers_.cw.get();
+  env.hw = workers_.hw.get();
+  env.date = date_;
+  env.mode = StrategyMode::Real;
+  env.exchange_file = nullptr;
+  S* s = New<S>(setting, env);
+  if (s == nullptr) {
+    exit(1);
+  }
+  SendPositionEnd(s);
+  // the backend calls Start once Ready, and a pair engine's Start
+  // calibrates, which needs a full window: the strategy trains on the
+  // bench ticks like on live ones. only the log ring is set up here
+  AsyncLogger::Instance().Register();
+  return s;
+}
+
+template <typename S>
+void StrategyBench::BenchStrategy(const libconfig::Setting & setting, double rate) {
+  static const char* kPhases[] = {"UpdateData", "DoOperationAfterUpdateData", "Run", "ModerateOrders", "DoOperationAfterFilled"};
+  std::vector<Phase> phases;
+  for (int p = 0; p < 5; p++) {
+    ticker_strat_map_.clear();
+    S* s = Build<S>(setting);
+    std::string main, hedge;
+    double tick;
+    Legs(s, &main, &hedge, &tick);
+    SyntheticFeed feed(main, hedge, tick, price_, rate, seed_);
+    Phase phase;
+    phase.name = kPhases[p];
+    phase.ns.reserve(ticks_);
+    phase.heap_begin = AllocCounter::LiveBytes();
+    phase.rss_begin = AllocCounter::RssBytes();
+    bool open = true;
+    for (int i = 0; i < ticks_; i++) {
+      const MarketSnapshot & shot = feed.Next();
+      if (p > 0) {  // what UpdateData does before dispatching
+        s->m_shot_map[shot.ticker] = shot;
+        s->m_last_shot = shot;
+      }
+      size_t allocs = AllocCounter::Allocs();
+      int64_t begin = 0;
+      int64_t end = 0;
+      switch (p) {
+        case 0:
+          begin = NowNs();
+          s->UpdateData(shot);
+          end = NowNs();
+          break;
+        case 1:
+          begin = NowNs();
+          s->DoOperationAfterUpdateData(shot);
+          end = NowNs();
+          break;
+        case 2:
+          s->DoOperationAfterUpdateData(shot);
+          allocs = AllocCounter::Allocs();
+          begin = NowNs();
+          s->Run();
+          end = NowNs();
+          break;
+        case 3:
+          s->DoOperationAfterUpdateData(shot);
+          s->Run();
+          allocs = AllocCounter::Allocs();
+          begin = NowNs();
+          s->ModerateOrders(shot.ticker);
+          end = NowNs();
+          break;
+        case 4: {
+          s->DoOperationAfterUpdateData(shot);
+          if (main != shot.ticker || !s->m_shot_map[hedge].IsGood()) {
+            continue;
+          }
+          // main leg fills, alternately opening and closing one lot
+          OrderIntent intent(open ? IntentKind::Open : IntentKind::Close, Leg::Main);
+          OrderSide::Enum side = open ? OrderSide::Buy : OrderSide::Sell;
+          Order* o = Send(s, main, open ? shot.asks[0] : shot.bids[0], intent, side);
+          double price = o->price;
+          ExchangeInfo info;
+          memset(&info, 0, sizeof(info));
+          info.shot_time = shot.time;
+          info.show_time = shot.time;
+          info.type = InfoType::Filled;
+          snprintf(info.ticker, sizeof(info.ticker), "%s", main.c_str());
+          snprintf(info.order_ref, sizeof(info.order_ref), "%s", o->order_ref);
+          info.trade_size = 1;
+          info.trade_price = price;
+          info.side = side;
+          s->UpdatePos(o, info);
+          open = !open;
+          allocs = AllocCounter::Allocs();
+          begin = NowNs();
+          s->DoOperationAfterFilled(o, info);
+          end = NowNs();
+          break;
+        }
+      }
+      phase.allocs += AllocCounter::Allocs() - allocs;
+      phase.ns.emplace_back(static_cast<uint32_t>(std::min<int64_t>(end - begin, UINT32_MAX)));
+      if ((i + 1) % std::max(1, ticks_ / kSamples) == 0) {
+        phase.heap.emplace_back(AllocCounter::LiveBytes() - phase.heap_begin);
+        phase.rss.emplace_back(AllocCounter::RssBytes() - phase.rss_begin);
+      }
+    }
+    s->Stop();
+    delete s;
+    phases.emplace_back(phase);
+  }
+  printf("== %s %s @ %.0f ticks/s per leg, %d ticks\n", setting["type"].c_str(), setting.exists("unique_name") ? setting["unique_name"].c_str() : "", rate, ticks_);
+  Report(phases);
+}
+
+void StrategyBench::Report(const std::vector<Phase> & phases) const {
+  printf("%-28s %9s %9s %9s %9s %9s %10s %11s %14s %14s\n", "callback", "calls", "mean_ns", "p50_ns", "p99_ns", "p999_ns", "max_ns", "allocs/call", "heap_growth", "rss_growth");
+  for (const Phase & phase : phases) {
+    std::vector<uint32_t> ns(phase.ns);
+    if (ns.empty()) {
+      printf("%-28s %9d\n", phase.name.c_str(), 0);
+      continue;
+    }
+    double sum = 0;
+    for (uint32_t v : ns) {
+      sum += v;
+    }
+    std::sort(ns.begin(), ns.end());
+    printf("%-28s %9zu %9.0lf %9u %9u %9u %10u %11.3lf %14ld %14ld\n", phase.name.c_str(), ns.size(), sum / ns.size(), ns[ns.size() / 2], ns[ns.size() * 99 / 100], ns[ns.size() * 999 / 1000], ns.back(), static_cast<double>(phase.allocs) / ns.size(), phase.heap.empty() ? 0 : phase.heap.back(), phase.rss.empty() ? 0 : phase.rss.back());
+    printf("%-28s heap over time:", "");
+    for (long b : phase.heap) {
+      printf(" %ld", b);
+    }
+    printf("\n");
+  }
+}
+
+void StrategyBench::Run() {
+  const libconfig::Setting & strategies = root_["strategy"];
+  for (int i = 0; i < strategies.getLength(); i++) {
+    const libconfig::Setting & setting = strategies[i];
+    std::string type = setting["type"];
+    for (double rate : rates_) {
+      if (type == "simplearb") {
+        BenchStrategy<SimpleArb>(setting, rate);
+      } else if (type == "simplearb2") {
+        BenchStrategy<SimpleArb2>(setting, rate);
+      } else if (type == "simplearb2_legacy") {
+        BenchStrategy<LegacySimpleArb2>(setting, rate);
+      } else if (type == "coinarb") {
+        BenchStrategy<CoinArb>(setting, rate);
+      } else if (type == "pairtrading") {
+        BenchStrategy<PairTrading>(setting, rate);
+      } else if (type == "simplemaker") {
+        BenchStrategy<SimpleMaker>(setting, rate);
+      } else if (type == "multiarb") {
+        BenchStrategy<MultiArb>(setting, rate);
+      } else {
+        printf("no bench for strategy type %s\n", type.c_str());
+        exit(1);
+      }
+    }
+  }
+}
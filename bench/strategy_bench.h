@@ -0,0 +1,82 @@
+#ifndef STRATEGY_BENCH_STRATEGY_BENCH_H_
+#define STRATEGY_BENCH_STRATEGY_BENCH_H_
+
+#include <libconfig.h++>
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "struct/market_snapshot.h"
+#include "struct/order.h"
+#include "struct/order_intent.h"
+#include "util/null_sender.h"
+#include "core/base_strategy.h"
+#include "replay/strategy_factory.h"
+
+// times the strategy callbacks one at a time over a SyntheticFeed.
+// config is a replay config (see replay/replayer.h, data and mode are
+// not used, strategies run in Real mode against NullSenders) plus
+//   bench = {
+//     ticks = 100000;    // per phase
+//     rates = [10, 100, 1000];  // snapshots per second per leg
+//     price = 3000.0;    // starting hedge mid
+//     seed = 1;
+//   };
+// every (strategy, rate, phase) gets a fresh strategy and the same ticks.
+// a multiarb is fed its first pair only. type "simplearb2_legacy" is
+// SimpleArb2 before PairEngine (bench/legacy_simplearb2.h), for A/B runs
+// against "simplearb2" on the same keys, see bench/ab.config
+class StrategyBench {
+ public:
+  explicit StrategyBench(const libconfig::Setting & root);
+
+  void Run();
+
+ private:
+  struct Phase {
+    Phase()
+      : allocs(0),
+        heap_begin(0),
+        rss_begin(0) {
+    }
+
+    std::string name;
+    std::vector<uint32_t> ns;
+    size_t allocs;
+    long heap_begin;
+    long rss_begin;
+    std::vector<long> heap;  // live heap sampled along the run
+    std::vector<long> rss;
+  };
+
+  template <typename S>
+  void BenchStrategy(const libconfig::Setting & setting, double rate);
+  template <typename S>
+  S* Build(const libconfig::Setting & setting);
+  // the strategy itself, by the factory unless S is bench-only
+  template <typename S>
+  static S* New(const libconfig::Setting & setting, const StrategyEnv & env);
+  // tickers and tick size the strategy resolved from its config
+  template <typename S>
+  static void Legs(const S* s, std::string* main, std::string* hedge, double* tick);
+  // a main leg order of intent, as the strategy would send it
+  template <typename S>
+  static Order* Send(S* s, const std::string & main, double price, OrderIntent intent, OrderSide::Enum side);
+  void Report(const std::vector<Phase> & phases) const;
+
+  const libconfig::Setting & root_;
+  StrategyWorkers workers_;
+  NullSender<MarketSnapshot> ui_sender_;
+  NullSender<Order> order_sender_;
+  std::unordered_map<std::string, std::vector<BaseStrategy*> > ticker_strat_map_;
+  std::string date_;
+  int ticks_;
+  std::vector<double> rates_;
+  double price_;
+  unsigned seed_;
+};
+
+#endif  // STRATEGY_BENCH_STRATEGY_BENCH_H_
@@ -0,0 +1,85 @@
+#ifndef STRATEGY_BENCH_SYNTHETIC_FEED_H_
+#define STRATEGY_BENCH_SYNTHETIC_FEED_H_
+
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include <random>
+#include <string>
+
+#include "struct/market_snapshot.h"
+
+// two cointegrated legs: the hedge mid is a random walk, the main mid is
+// hedge + an AR(1) spread, both snapped to the tick and quoted one tick
+// wide. legs alternate, `rate` snapshots per second per leg
+class SyntheticFeed {
+ public:
+  SyntheticFeed(const std::string & main_ticker, const std::string & hedge_ticker, double tick, double price, double rate, unsigned seed = 1)
+    : main_ticker_(main_ticker),
+      hedge_ticker_(hedge_ticker),
+      tick_(tick),
+      hedge_mid_(price),
+      spread_(0.0),
+      step_usec_(static_cast<int64_t>(1e6 / (2 * rate))),
+      usec_(0),
+      main_turn_(true),
+      rng_(seed),
+      normal_(0.0, 1.0) {
+    if (step_usec_ < 1) {
+      step_usec_ = 1;
+    }
+  }
+
+  // next snapshot, alternating main and hedge
+  const MarketSnapshot & Next() {
+    if (main_turn_) {
+      spread_ = kPhi * spread_ + kSpreadVol * tick_ * normal_(rng_);
+      Quote(main_ticker_, hedge_mid_ + spread_);
+    } else {
+      hedge_mid_ += kWalkVol * tick_ * normal_(rng_);
+      Quote(hedge_ticker_, hedge_mid_);
+    }
+    main_turn_ = !main_turn_;
+    usec_ += step_usec_;
+    return shot_;
+  }
+
+ private:
+  static constexpr double kPhi = 0.995;
+  static constexpr double kSpreadVol = 0.5;
+  static constexpr double kWalkVol = 0.3;
+
+  void Quote(const std::string & ticker, double mid) {
+    double bid = floor(mid / tick_) * tick_;
+    memset(shot_.ticker, 0, sizeof(shot_.ticker));
+    snprintf(shot_.ticker, sizeof(shot_.ticker), "%s", ticker.c_str());
+    shot_.bids[0] = bid;
+    shot_.asks[0] = bid + tick_;
+    shot_.bid_sizes[0] = 1 + rng_() % 50;
+    shot_.ask_sizes[0] = 1 + rng_() % 50;
+    shot_.last_trade = bid;
+    shot_.last_trade_size = 1;
+    shot_.volume++;
+    shot_.time.tv_sec = kStartSec + usec_ / 1000000;
+    shot_.time.tv_usec = usec_ % 1000000;
+    shot_.is_initialized = true;
+  }
+
+  // 2019-01-02 09:00:00 +0800, inside the trading day
+  static const time_t kStartSec = 1546390800;
+
+  std::string main_ticker_;
+  std::string hedge_ticker_;
+  double tick_;
+  double hedge_mid_;
+  double spread_;
+  int64_t step_usec_;
+  int64_t usec_;
+  bool main_turn_;
+  std::mt19937 rng_;
+  std::normal_distribution<double> normal_;
+  MarketSnapshot shot_;
+};
+
+#endif  // STRATEGY_BENCH_SYNTHETIC_FEED_H_
@@ -26,9 +26,9 @@ void DemoStrat::Run() {
 }
 
 void DemoStrat::DoOperationAfterCancelled(Order* o) {
-  printf("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
+  SLOG_INFO("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
   if (m_cancel_map[o->ticker] > 100) {
-    printf("ticker %s hit cancel limit!\n", o->ticker);
+    SLOG_ERROR("ticker %s hit cancel limit!\n", o->ticker);
     // Stop();
   }
 }
@@ -44,8 +44,8 @@ void DemoStrat::Start() {
   // start with two order
   // NewOrder(, OrderSide::Buy, 1, false, false);
   // NewOrder(main_ticker, OrderSide::Sell, 1000, false, false, "");
-  PlaceOrder(main_ticker, 392, 1, false, "test")->Show(stdout);
-  // o->Show(stdout);
+  Order* o = PlaceOrder(main_ticker, 392, 1, false, "test");
+  SLOG_ORDER(LogLevel::Info, o);
 }
 
 void DemoStrat::DoOperationAfterUpdateData(const MarketSnapshot& shot) {
@@ -55,7 +55,7 @@ void DemoStrat::DoOperationAfterUpdateData(const MarketSnapshot& shot) {
 void DemoStrat::ModerateOrders(const std::string & ticker) {
   for (std::unordered_map<std::string, Order*>::iterator it = m_order_map.begin(); it != m_order_map.end(); it++) {
     Order* o = it->second;
-    MarketSnapshot shot = m_shot_map[o->ticker];
+    const MarketSnapshot & shot = m_shot_map[o->ticker];
     if (o->Valid()) {
       if (o->side == OrderSide::Buy && fabs(o->price - shot.asks[0]) > 0.01) {
         // ModOrder(o);
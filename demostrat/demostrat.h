@@ -14,6 +14,7 @@
 #include "struct/exchange_info.h"
 #include "struct/order_status.h"
 #include "util/common_tools.h"
+#include "util/strat_log.h"
 #include "core/base_strategy.h"
 
 class DemoStrat : public BaseStrategy {
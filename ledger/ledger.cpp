@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util/trade_ledger.h"
+
+namespace {
+
+// one label's rounds, summed
+struct Summary {
+  Summary()
+    : rounds(0),
+      wins(0),
+      forced(0),
+      lots(0),
+      pnl(0.0),
+      fee_points(0.0),
+      open_slip(0.0),
+      close_slip(0.0),
+      holding_usec(0.0),
+      worst(0.0),
+      best(0.0) {
+  }
+
+  size_t rounds;
+  size_t wins;
+  size_t forced;
+  int64_t lots;
+  double pnl;
+  double fee_points;
+  double open_slip;
+  double close_slip;
+  double holding_usec;
+  double worst;
+  double best;
+};
+
+// straight loops over the columns of one block, no per round branching
+// beyond min/max, so they vectorize
+void Add(const LedgerBlock & b, Summary* s) {
+  size_t n = b.header->rounds;
+  const int64_t* open_usec = b.Column<int64_t>(LedgerColumn::OpenUsec);
+  const int64_t* close_usec = b.Column<int64_t>(LedgerColumn::CloseUsec);
+  const int32_t* size = b.Column<int32_t>(LedgerColumn::Size);
+  const uint8_t* forced = b.Column<uint8_t>(LedgerColumn::Forced);
+  const double* pnl = b.Column<double>(LedgerColumn::Pnl);
+  const double* fee = b.Column<double>(LedgerColumn::FeePoints);
+  const double* open_slip = b.Column<double>(LedgerColumn::OpenSlip);
+  const double* close_slip = b.Column<double>(LedgerColumn::CloseSlip);
+  size_t wins = 0;
+  size_t n_forced = 0;
+  int64_t lots = 0;
+  double sum_pnl = 0.0;
+  double sum_fee = 0.0;
+  double sum_open_slip = 0.0;
+  double sum_close_slip = 0.0;
+  double holding = 0.0;
+  double worst = s->rounds == 0 ? pnl[0] : s->worst;
+  double best = s->rounds == 0 ? pnl[0] : s->best;
+  for (size_t i = 0; i < n; i++) {
+    wins += pnl[i] > 0.0;
+    n_forced += forced[i];
+    lots += size[i];
+    sum_pnl += pnl[i];
+    sum_fee += fee[i];
+    sum_open_slip += open_slip[i];
+    sum_close_slip += close_slip[i];
+    holding += close_usec[i] - open_usec[i];
+    worst = std::min(worst, pnl[i]);
+    best = std::max(best, pnl[i]);
+  }
+  s->rounds += n;
+  s->wins += wins;
+  s->forced += n_forced;
+  s->lots += lots;
+  s->pnl += sum_pnl;
+  s->fee_points += sum_fee;
+  s->open_slip += sum_open_slip;
+  s->close_slip += sum_close_slip;
+  s->holding_usec += holding;
+  s->worst = worst;
+  s->best = best;
+}
+
+}  // namespace
+
+// ledger <file>...
+// per label totals of the round trips in TradeLedger files
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage: %s <ledger file>...\n", argv[0]);
+    return 1;
+  }
+  std::vector<std::unique_ptr<TradeLedgerFile> > files;
+  for (int i = 1; i < argc; i++) {
+    files.emplace_back(new TradeLedgerFile());
+    if (!files.back()->Open(argv[i])) {
+      return 1;
+    }
+  }
+  auto begin = std::chrono::steady_clock::now();
+  std::map<std::string, Summary> by_label;
+  size_t total = 0;
+  for (const auto & f : files) {
+    for (const LedgerBlock & b : f->Blocks()) {
+      if (b.header->rounds == 0) {
+        continue;
+      }
+      Add(b, &by_label[std::string(b.header->label, strnlen(b.header->label, sizeof(b.header->label)))]);
+      total += b.header->rounds;
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  printf("%-40s %9s %7s %7s %14s %12s %12s %12s %12s %12s %12s\n", "label", "rounds", "win%", "forced", "pnl", "pnl/round", "worst", "best", "fee/lot", "slip/round", "hold_sec");
+  for (const auto & m : by_label) {
+    const Summary & s = m.second;
+    double lots = s.lots > 0 ? s.lots : 1;
+    printf("%-40s %9zu %7.2lf %7zu %14.2lf %12.4lf %12.2lf %12.2lf %12.4lf %12.4lf %12.1lf\n", m.first.c_str(), s.rounds, 100.0 * s.wins / s.rounds, s.forced, s.pnl, s.pnl / s.rounds, s.worst, s.best, s.fee_points / lots, (s.open_slip + s.close_slip) / s.rounds, s.holding_usec / s.rounds / 1e6);
+  }
+  printf("%zu rounds in %zu files in %.3lfs, %.0lf rounds/s\n", total, files.size(), sec, sec > 0 ? total / sec : 0.0);
+  return 0;
+}
@@ -0,0 +1,789 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "util/as_of_aligner.h"
+#include "./multiarb.h"
+
+namespace {
+
+// the setting of one pair: its own value of key, else the enclosing one
+template <typename T>
+T PairValue(const libconfig::Setting & pair_setting, const libconfig::Setting & param_setting, const char* key) {
+  if (pair_setting.exists(key)) {
+    T v = pair_setting[key];
+    return v;
+  }
+  T v = param_setting[key];
+  return v;
+}
+
+// one fill on a leg of a pair, avgcost as in BaseStrategy::UpdatePos
+void ApplyFill(int* pos, double* avgcost, OrderSide::Enum side, int size, double price) {
+  int signed_size = (side == OrderSide::Buy) ? size : -size;
+  int next = *pos + signed_size;
+  if (next == 0) {
+    *avgcost = 0.0;
+  } else if (*pos == 0 || (*pos > 0) == (signed_size > 0)) {  // adding
+    *avgcost = (abs(*pos) * *avgcost + size * price) / abs(next);
+  } else if ((*pos > 0) != (next > 0)) {  // through zero
+    *avgcost = price;
+  }
+  *pos = next;
+}
+
+}  // namespace
+
+MultiArb::MultiArb(const libconfig::Setting & param_setting, std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender, TimeController* tc, ContractWorker* cw, HistoryWorker* hw, const std::string & date, StrategyMode::Enum mode, std::ofstream* exchange_file)
+  : date(date),
+    no_close_today(false),
+    max_close_try(10),
+    align_tolerance_usec(AsOfAligner::kDefaultToleranceUsec),
+    ui_publish_hz(10.0),
+    last_slot(-1),
+    sending_leg(Leg::Main),
+    aligned(0),
+    dropped(0),
+    repeated(0),
+    exchange_file(exchange_file) {
+  m_tc = tc;
+  m_cw = cw;
+  m_hw = hw;
+  SetStrategyMode(mode, exchange_file);
+  if (mode != StrategyMode::Real) {
+    exchange_journal.Reset(exchange_file);
+  }
+  if (FillStratConfig(param_setting)) {
+    RunningSetup(ticker_strat_map, uisender, ordersender);
+  }
+}
+
+MultiArb::~MultiArb() {
+}
+
+int MultiArb::Intern(const std::string & ticker) {
+  auto it = ticker_slot.find(ticker);
+  if (it != ticker_slot.end()) {
+    return it->second;
+  }
+  int slot = tickers.size();
+  ticker_slot[ticker] = slot;
+  tickers.push_back(ticker);
+  TickerId id = TickerTable::Intern(ticker);
+  if (id >= id_slot.size()) {
+    id_slot.resize(id + 1, -1);
+  }
+  id_slot[id] = slot;
+  return slot;
+}
+
+int MultiArb::SlotOf(const char* ticker) const {
+  auto it = ticker_slot.find(ticker);
+  return it == ticker_slot.end() ? -1 : it->second;
+}
+
+int MultiArb::SlotOf(const MarketSnapshot & shot) const {
+  if (routed_id_ == kNoTicker) {
+    return SlotOf(shot.ticker);
+  }
+  return routed_id_ < id_slot.size() ? id_slot[routed_id_] : -1;
+}
+
+bool MultiArb::AddPair(const libconfig::Setting& pair_setting, const libconfig::Setting& param_setting) {
+  std::string unique_name = pair_setting["unique_name"];
+  const libconfig::Setting & contract_setting = m_cw->Lookup(unique_name);
+  std::string main_ticker;
+  std::string hedge_ticker;
+  if (pair_setting.exists("main_ticker") && pair_setting.exists("hedge_ticker")) {
+    std::string m = pair_setting["main_ticker"];
+    std::string h = pair_setting["hedge_ticker"];
+    main_ticker = m;
+    hedge_ticker = h;
+  } else if (m_hw == nullptr) {
+    SLOG_ERROR("%s needs main_ticker and hedge_ticker without history_file\n", unique_name.c_str());
+    return false;
+  } else {
+    auto v = m_hw->GetAllTicker(unique_name);
+    if (v.size() < 2) {
+      SLOG_ERROR("no enough ticker for %s\n", unique_name.c_str());
+      return false;
+    }
+    main_ticker = v[1].first;
+    hedge_ticker = v[0].first;
+  }
+  std::string label = main_ticker + '|' + hedge_ticker;
+  if (main_ticker == hedge_ticker || std::find(book.label.begin(), book.label.end(), label) != book.label.end()) {
+    SLOG_ERROR("pair %s of %s is a repeat or has one leg, skipped\n", label.c_str(), unique_name.c_str());
+    return false;
+  }
+  int p = book.Size();
+  book.Resize(p + 1);
+  book.main_slot[p] = Intern(main_ticker);
+  book.hedge_slot[p] = Intern(hedge_ticker);
+  book.label[p] = label;
+  double min_price_move = contract_setting["min_price_move"];
+  book.min_price_move[p] = min_price_move;
+  book.cancel_limit[p] = contract_setting["cancel_limit"];
+  book.max_pos[p] = PairValue<int>(pair_setting, param_setting, "max_position");
+  book.train_samples[p] = PairValue<int>(pair_setting, param_setting, "train_samples");
+  book.min_range[p] = PairValue<double>(pair_setting, param_setting, "min_range") * min_price_move;
+  book.min_profit[p] = PairValue<double>(pair_setting, param_setting, "min_profit") * min_price_move;
+  book.increment[p] = PairValue<double>(pair_setting, param_setting, "add_margin") * min_price_move;
+  book.spread_threshold[p] = PairValue<double>(pair_setting, param_setting, "spread_threshold") * min_price_move;
+  book.stop_loss_margin[p] = PairValue<double>(pair_setting, param_setting, "stop_loss_margin");
+  book.max_loss_times[p] = PairValue<int>(pair_setting, param_setting, "max_loss_times");
+  book.max_holding_sec[p] = PairValue<int>(pair_setting, param_setting, "max_holding_sec");
+  book.range_width[p] = PairValue<double>(pair_setting, param_setting, "range_width");
+  book.max_round[p] = PairValue<int>(pair_setting, param_setting, "max_round");
+  book.build_time[p] = MAX_UNIX_TIME;
+  SLOG_INFO("pair %d %s main:%s hedge:%s\n", p, unique_name.c_str(), main_ticker.c_str(), hedge_ticker.c_str());
+  return true;
+}
+
+bool MultiArb::FillStratConfig(const libconfig::Setting& param_setting) {
+  try {
+    if (param_setting.exists("unique_name")) {
+      std::string unique_name = param_setting["unique_name"];
+      m_strat_name = unique_name;
+    } else {
+      m_strat_name = "multiarb";
+    }
+    if (param_setting.exists("no_close_today")) {
+      no_close_today = param_setting["no_close_today"];
+    }
+    if (param_setting.exists("align_tolerance_ms")) {
+      double ms = param_setting["align_tolerance_ms"];
+      align_tolerance_usec = static_cast<int64_t>(ms * 1000);
+    }
+    if (param_setting.exists("ui_publish_hz")) {
+      ui_publish_hz = param_setting["ui_publish_hz"];
+    }
+    if (param_setting.exists("ledger_file")) {
+      std::string file = param_setting["ledger_file"];
+      ledger_file = file;
+    }
+    const libconfig::Setting & pairs = param_setting["pairs"];
+    for (int i = 0; i < pairs.getLength(); i++) {
+      AddPair(pairs[i], param_setting);
+    }
+    fees.assign(tickers.size(), FeePointCache());
+    if (param_setting.exists("fee_mid_tolerance")) {
+      double fee_mid_tolerance = param_setting["fee_mid_tolerance"];
+      for (FeePointCache & f : fees) {
+        f.SetTolerance(fee_mid_tolerance);
+      }
+    }
+  } catch(const libconfig::SettingNotFoundException &nfex) {
+    SLOG_ERROR("Setting '%s' is missing", nfex.getPath());
+    exit(1);
+  } catch(const libconfig::SettingTypeException &tex) {
+    SLOG_ERROR("Setting '%s' has the wrong type", tex.getPath());
+    exit(1);
+  } catch (const std::exception& ex) {
+    SLOG_ERROR("EXCEPTION: %s\n", ex.what());
+    exit(1);
+  }
+  size_t n = book.Size();
+  if (n == 0) {
+    SLOG_ERROR("%s has no pair to trade\n", m_strat_name.c_str());
+    return false;
+  }
+  mid_stats.reset(new RollingStats[n]);
+  working_orders.reset(new OrderIndex[n]);
+  ui_channels.reset(new BandChannel[n]);
+  for (size_t p = 0; p < n; p++) {
+    mid_stats[p].Reset(book.train_samples[p]);
+  }
+  return true;
+}
+
+void MultiArb::RunningSetup(std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender) {
+  m_ui_sender = BandChannel::Share(uisender);  // ui_channels send on it from the publisher thread
+  m_order_sender = ordersender;
+  size_t n_slots = tickers.size();
+  bid.assign(n_slots, 0.0);
+  ask.assign(n_slots, 0.0);
+  bid_size.assign(n_slots, 0);
+  ask_size.assign(n_slots, 0);
+  quote_usec.assign(n_slots, static_cast<int64_t>(kNever));
+  quote_good.assign(n_slots, 0);
+  next_shot.assign(n_slots, nullptr);
+  MarketSnapshot shot;
+  for (size_t s = 0; s < n_slots; s++) {
+    (*ticker_strat_map)[tickers[s]].emplace_back(this);
+    m_shot_map[tickers[s]] = shot;
+    m_avgcost_map[tickers[s]] = 0.0;
+    next_shot[s] = &m_next_shot_map[tickers[s]];
+    fees[s].Bind(m_cw, tickers[s], no_close_today);
+  }
+  (*ticker_strat_map)["positionend"].emplace_back(this);
+
+  // pairs by ticker, flattened
+  size_t n = book.Size();
+  slot_begin.assign(n_slots + 1, 0);
+  for (size_t p = 0; p < n; p++) {
+    slot_begin[book.main_slot[p] + 1]++;
+    slot_begin[book.hedge_slot[p] + 1]++;
+  }
+  int widest = 0;
+  for (size_t s = 0; s < n_slots; s++) {
+    widest = std::max(widest, slot_begin[s + 1]);
+    slot_begin[s + 1] += slot_begin[s];
+  }
+  slot_pairs.assign(2 * n, 0);
+  std::vector<int> fill(slot_begin.begin(), slot_begin.end() - 1);
+  for (size_t p = 0; p < n; p++) {
+    slot_pairs[fill[book.main_slot[p]]++] = p;
+    slot_pairs[fill[book.hedge_slot[p]]++] = p;
+  }
+  lanes.Reserve(widest);
+  order_pair.Reset(n * OrderIndex::kCapacity);
+  kept_orders.reserve(n * OrderIndex::kCapacity);
+  for (size_t p = 0; p < n; p++) {
+    ui_channels[p].Open(book.label[p], m_ui_sender, ui_publish_hz);
+  }
+  rounds.assign(n, TradeRound());
+  if (!ledger_file.empty() && ledger.Open(ledger_file)) {
+    const std::vector<std::string> params = {"range_width", "min_profit", "min_range", "increment", "stop_loss_margin"};
+    for (size_t p = 0; p < n; p++) {
+      ledger_book.emplace_back(ledger.AddBook(m_strat_name + '|' + book.label[p], params));
+    }
+  }
+  SLOG_INFO("[%s]%zu pairs on %zu tickers, at most %d pairs per ticker\n", m_strat_name.c_str(), n, n_slots, widest);
+}
+
+void MultiArb::Stop() {
+  CancelAll();
+  m_ss = StrategyStatus::Stopped;
+  SLOG_INFO("[%s]aligned %lu, dropped %lu, repeated %lu\n", m_strat_name.c_str(), aligned, dropped, repeated);
+  exchange_journal.Flush();
+  ledger.Flush();
+}
+
+void MultiArb::StopPair(int p, const char* why) {
+  if (book.stopped[p]) {
+    return;
+  }
+  book.stopped[p] = 1;
+  SLOG_ERROR("[%s]%s, pair stopped\n", book.label[p].c_str(), why);
+  Order* working[OrderIndex::kCapacity];
+  int n = working_orders[p].CollectAll(working);
+  for (int i = 0; i < n; i++) {
+    CancelOrder(working[i]);
+  }
+}
+
+void MultiArb::DoOperationAfterUpdateData(const MarketSnapshot& shot) {
+  lanes.size = 0;
+  int s = SlotOf(shot);
+  last_slot = s;
+  if (s < 0) {
+    return;
+  }
+  int64_t usec = static_cast<int64_t>(shot.time.tv_sec) * 1000000 + shot.time.tv_usec;
+  bid[s] = shot.bids[0];
+  ask[s] = shot.asks[0];
+  bid_size[s] = shot.bid_sizes[0];
+  ask_size[s] = shot.ask_sizes[0];
+  quote_good[s] = shot.IsGood();
+  if (usec == quote_usec[s]) {  // not a new quote, pairs nothing, as in AsOfAligner
+    repeated += slot_begin[s + 1] - slot_begin[s];
+    return;
+  }
+  quote_usec[s] = usec;
+  for (int i = slot_begin[s]; i < slot_begin[s + 1]; i++) {
+    int p = slot_pairs[i];
+    int m = book.main_slot[p];
+    int h = book.hedge_slot[p];
+    int64_t other = quote_usec[m == s ? h : m];
+    if (other == kNever || llabs(usec - other) >= align_tolerance_usec) {
+      dropped++;
+      continue;
+    }
+    aligned++;
+    double diff = PairDiff(p);
+    double spread = (ask[m] - bid[m]) + (ask[h] - bid[h]);
+    mid_stats[p].Add(diff);
+    int num_sample = ++book.sample_tail[p] - book.sample_head[p];
+    int train_samples = book.train_samples[p];
+    if (!book.trained[p]) {
+      book.mean[p] = book.down[p] = book.up[p] = book.stop_down[p] = book.stop_up[p] = diff;
+      if (m_position_ready && quote_good[m] && quote_good[h] && num_sample >= train_samples) {
+        CalParams(p);
+        book.trained[p] = 1;
+      }
+    } else if (num_sample > train_samples && num_sample % train_samples == 1) {
+      CalParams(p);
+    }
+
+    size_t k = lanes.size++;
+    lanes.pair[k] = p;
+    lanes.diff[k] = diff;
+    lanes.spread[k] = spread;
+    lanes.mean[k] = book.mean[p];
+    lanes.up[k] = book.up[p];
+    lanes.down[k] = book.down[p];
+    lanes.stop_up[k] = book.stop_up[p];
+    lanes.stop_down[k] = book.stop_down[p];
+    lanes.spread_threshold[k] = book.spread_threshold[p];
+    lanes.pos[k] = book.pos[p];
+    lanes.max_pos[k] = book.max_pos[p];
+    lanes.live[k] = (book.trained[p] && !book.stopped[p]) ? 1.0 : 0.0;
+
+    BandState band;
+    band.time = shot.time;
+    band.mid = diff;
+    band.mean = book.mean[p];
+    band.spread = spread;
+    band.down = book.down[p];
+    band.up = book.up[p];
+    band.stop_loss_down = book.stop_down[p];
+    band.stop_loss_up = book.stop_up[p];
+    band.main_bid = bid[m];
+    band.main_ask = ask[m];
+    band.hedge_bid = bid[h];
+    band.hedge_ask = ask[h];
+    band.main_bid_size = bid_size[m];
+    band.main_ask_size = ask_size[m];
+    band.hedge_bid_size = bid_size[h];
+    band.hedge_ask_size = ask_size[h];
+    ui_channels[p].Post(band);
+  }
+}
+
+void MultiArb::Decide(bool allow_open) {
+  size_t n = lanes.size;
+  if (n == 0) {
+    return;
+  }
+  lanes.Scan();
+  lanes.size = 0;
+  for (size_t k = 0; k < n; k++) {
+    int p = lanes.pair[k];
+    int32_t signal = lanes.signal[k];
+    if (allow_open) {
+      if (book.close_round[p] >= book.max_round[p]) {
+        continue;
+      }
+      if (signal & (PairSignal::OpenSell | PairSignal::OpenBuy)) {
+        Open(p, (signal & PairSignal::OpenSell) ? OrderSide::Sell : OrderSide::Buy);
+        continue;
+      }
+    }
+    if (lanes.live[k] != 0.0) {
+      CloseLogic(p, signal);
+    }
+  }
+}
+
+void MultiArb::CloseLogic(int p, int32_t signal) {
+  if (signal & PairSignal::StopLoss) {
+    SLOG_INFO("[%s]hit stop loss, pos:%d diff:%lf stoplossline %lf-%lf\n", book.label[p].c_str(), book.pos[p], PairDiff(p), book.stop_down[p], book.stop_up[p]);
+    ForceFlat(p);
+    book.stop_loss_times[p]++;
+  }
+  if (book.stop_loss_times[p] >= book.max_loss_times[p]) {
+    StopPair(p, "stop loss times hit max");
+  }
+  if (book.pos[p] == 0) {
+    return;
+  }
+  if (TimeUp(p)) {
+    SLOG_INFO("[%s] holding time up, start from %ld, max_hold is %d close diff is %lf force to close position!\n", book.label[p].c_str(), book.build_time[p], book.max_holding_sec[p], PairDiff(p));
+    ForceFlat(p);
+    return;
+  }
+  if (signal & PairSignal::HitMean) {
+    SLOG_INFO("[%s] mean is %lf, this_mid is %lf, pos is %d\n", book.label[p].c_str(), book.mean[p], PairDiff(p), book.pos[p]);
+    Close(p);
+  }
+}
+
+bool MultiArb::TimeUp(int p) const {
+  if (book.build_time[p] == MAX_UNIX_TIME) {
+    return false;
+  }
+  int64_t now = (m_mode == StrategyMode::Real) ? m_tc->CurrentInt() : m_tc->TimevalInt(m_last_shot.time);
+  return now - book.build_time[p] >= book.max_holding_sec[p];
+}
+
+Order* MultiArb::Send(int p, OrderIntent intent, OrderSide::Enum side, int size) {
+  sending_leg = intent.GetLeg();
+  const std::string & ticker = tickers[sending_leg == Leg::Main ? book.main_slot[p] : book.hedge_slot[p]];
+  Order* o = NewOrder(ticker, side, size, false, false, intent.Tag(), no_close_today);
+  working_orders[p].Add(o, intent);
+  order_pair.Put(o, p);
+  SLOG_ORDER(LogLevel::Info, o);
+  return o;
+}
+
+void MultiArb::Forget(Order* o) {
+  int p = order_pair.Erase(o);
+  if (p >= 0) {
+    working_orders[p].Remove(o);
+  }
+}
+
+void MultiArb::SyncOrders() {
+  if (order_pair.Size() == m_order_map.size()) {
+    return;
+  }
+  // the backend dropped or rejected something: keep what is still working
+  kept_orders.clear();
+  for (const auto & m : m_order_map) {
+    int p = order_pair.Find(m.second);
+    if (p >= 0) {
+      kept_orders.emplace_back(m.second, p);
+    }
+  }
+  order_pair.Clear();
+  for (size_t p = 0; p < book.Size(); p++) {
+    working_orders[p].Clear();
+  }
+  for (const auto & m : kept_orders) {
+    int p = m.second;
+    Leg::Enum leg = SlotOf(m.first->ticker) == book.main_slot[p] ? Leg::Main : Leg::Hedge;
+    order_pair.Put(m.first, p);
+    working_orders[p].Add(leg, m.first);
+  }
+}
+
+void MultiArb::Open(int p, OrderSide::Enum side) {
+  if (working_orders[p].Size() != 0) {  // block order exsit, no open, possible reason: no enough margin
+    SLOG_WARN("[%s]block order exsited! no open\n", book.label[p].c_str());
+    return;
+  }
+  SLOG_INFO("[%s] open %s: pos is %d, diff is %lf\n", book.label[p].c_str(), OrderSide::ToString(side), book.pos[p], PairDiff(p));
+  int h = book.hedge_slot[p];
+  book.target_hedge_price[p] = (side == OrderSide::Buy) ? bid[h] : ask[h];
+  book.sample_head[p] = book.sample_tail[p];
+  if (book.pos[p] == 0) {
+    rounds[p] = TradeRound();
+    rounds[p].open_usec = static_cast<int64_t>(m_last_shot.time.tv_sec) * 1000000 + m_last_shot.time.tv_usec;
+  }
+  RecordSlip(p, book.main_slot[p], side, false);
+  HandleTestOrder(Send(p, OrderIntent(IntentKind::Open, Leg::Main), side, 1));
+}
+
+bool MultiArb::Close(int p, bool force_flat) {
+  int pos = book.pos[p];
+  if (pos == 0) {
+    return true;
+  }
+  if (working_orders[p].Size() != 0) {
+    SLOG_WARN("[%s]block order exsited! no close\n", book.label[p].c_str());
+    return false;
+  }
+  OrderSide::Enum close_side = pos > 0 ? OrderSide::Sell: OrderSide::Buy;
+  SLOG_INFO("[%s]close using %s: pos is %d %d, diff is %lf\n", book.label[p].c_str(), OrderSide::ToString(close_side), pos, book.hedge_pos[p], PairDiff(p));
+  int h = book.hedge_slot[p];
+  book.target_hedge_price[p] = (close_side == OrderSide::Buy) ? bid[h] : ask[h];
+  RecordSlip(p, book.main_slot[p], close_side, true);
+  HandleTestOrder(Send(p, OrderIntent(force_flat ? IntentKind::ForceFlat : IntentKind::Close, Leg::Main), close_side, abs(pos)));
+  return true;
+}
+
+void MultiArb::ForceFlat(int p) {
+  SLOG_INFO("[%s]force flat, pos:%d diff:%lf\n", book.label[p].c_str(), book.pos[p], PairDiff(p));
+  if (Close(p, true)) {
+    return;
+  }
+  // blocked by orders the exchange never answered: drop them, as SimpleArb does
+  SLOG_ERROR("[%s]cant close this order, dropping the working ones!\n", book.label[p].c_str());
+  Order* working[OrderIndex::kCapacity];
+  int n = working_orders[p].CollectAll(working);
+  for (int i = 0; i < n; i++) {
+    SLOG_ORDER(LogLevel::Warn, working[i]);
+    m_order_map.erase(working[i]->order_ref);
+    Forget(working[i]);
+  }
+  working_orders[p].Clear();
+  Close(p, true);
+}
+
+void MultiArb::ForceFlat() {
+  for (size_t p = 0; p < book.Size(); p++) {
+    if (book.pos[p] != 0) {
+      ForceFlat(p);
+    }
+  }
+}
+
+void MultiArb::CalParams(int p) {
+  if (book.sample_tail[p] < book.train_samples[p]) {
+    SLOG_ERROR("[%s]no enough mid data! tail is %d\n", book.label[p].c_str(), book.sample_tail[p]);
+    return;
+  }
+  RollingStats & stats = mid_stats[p];
+  stats.Resync();
+  double avg = stats.Mean();
+  double std = stats.Std();
+  int m = book.main_slot[p];
+  int h = book.hedge_slot[p];
+  double round_fee_cost = fees[m].RoundTrip(Mid(m)) + fees[h].RoundTrip(Mid(h));
+  double margin = std::max(book.range_width[p] * std, book.min_range[p]) + round_fee_cost;
+  book.up[p] = avg + margin;
+  book.down[p] = avg - margin;
+  book.stop_up[p] = book.up[p] + book.stop_loss_margin[p] * margin;
+  book.stop_down[p] = book.down[p] - book.stop_loss_margin[p] * margin;
+  book.mean[p] = avg;
+  book.spread_threshold[p] = margin - book.min_profit[p] - round_fee_cost;
+  SLOG_INFO("[%s]cal done,mean is %lf, std is %lf, parmeters: [%lf,%lf], spread_threshold is %lf, up_loss=%lf, down_loss=%lf fee_point=%lf\n", book.label[p].c_str(), avg, std, book.down[p], book.up[p], book.spread_threshold[p], book.stop_up[p], book.stop_down[p], round_fee_cost);
+  book.sample_head[p] = book.sample_tail[p];
+}
+
+void MultiArb::UpdateBound(int p, OrderSide::Enum side) {
+  int pos = book.pos[p];
+  if (pos == 0) {  // close operation filled, no update bound
+    return;
+  }
+  double increment = book.increment[p];
+  if (side == OrderSide::Sell) {
+    book.down[p] = PairDiff(p) - increment;
+    if (abs(pos) > 1) {
+      book.mean[p] -= increment/2;
+      book.stop_down[p] -= increment/2;
+    }
+  } else {
+    book.up[p] = PairDiff(p) + increment;
+    if (abs(pos) > 1) {
+      book.mean[p] += increment/2;
+      book.stop_up[p] += increment/2;
+    }
+  }
+  SLOG_INFO("[%s]next open will be %lf mean is %lf\n", book.label[p].c_str(), side == OrderSide::Sell ? book.down[p] : book.up[p], book.mean[p]);
+}
+
+void MultiArb::UpdateBuildPosTime(int p) {
+  int hedge_pos = book.hedge_pos[p];
+  if (hedge_pos == 0) {  // closed all position, reinitialize build_position_time
+    book.build_time[p] = MAX_UNIX_TIME;
+  } else if (abs(hedge_pos) == 1) {  // position 0->1, record build_time
+    book.build_time[p] = m_tc->TimevalInt(m_last_shot.time);
+  }
+}
+
+void MultiArb::RecordSlip(int p, int slot, OrderSide::Enum side, bool is_close) {
+  if (!ledger.IsOpen()) {
+    return;
+  }
+  const MarketSnapshot & next = *next_shot[slot];
+  double slip = (side == OrderSide::Buy) ? ask[slot] - next.asks[0] : next.bids[0] - bid[slot];
+  (is_close ? rounds[p].close_slip : rounds[p].open_slip) += slip;
+}
+
+void MultiArb::RecordPnl(int p, const Order* o, int size, double price, double main_cost, bool forced) {
+  OrderSide::Enum hedge_side = o->side == OrderSide::Sell ? OrderSide::Buy: OrderSide::Sell;
+  int m = book.main_slot[p];
+  int h = book.hedge_slot[p];
+  double hedge_price = Take(h, hedge_side);
+  double this_round_pnl = m_cw->CalNetPnl(tickers[m], main_cost, size, price, size, o->side, no_close_today) + m_cw->CalNetPnl(tickers[h], book.hedge_cost[p], size, hedge_price, size, hedge_side, no_close_today);
+  run_stats.pnl += this_round_pnl;
+  SLOG_INFO("recordpnl,%s,%lf\n", book.label[p].c_str(), this_round_pnl);
+  if (!ledger.IsOpen()) {
+    return;
+  }
+  TradeRound & r = rounds[p];
+  r.close_usec = static_cast<int64_t>(m_last_shot.time.tv_sec) * 1000000 + m_last_shot.time.tv_usec;
+  r.size = size;
+  r.dir = o->side == OrderSide::Sell ? 1 : -1;
+  r.forced = forced;
+  r.main_open = main_cost;
+  r.main_close = price;
+  r.hedge_open = book.hedge_cost[p];
+  r.hedge_close = hedge_price;
+  r.fee_points = (fees[m].RoundTrip(price) + fees[h].RoundTrip(hedge_price)) * size;
+  r.pnl = this_round_pnl;
+  r.mean = book.mean[p];
+  r.up = book.up[p];
+  r.down = book.down[p];
+  r.stop_up = book.stop_up[p];
+  r.stop_down = book.stop_down[p];
+  r.spread_threshold = book.spread_threshold[p];
+  const double params[] = {book.range_width[p], book.min_profit[p], book.min_range[p], book.increment[p], book.stop_loss_margin[p]};
+  ledger.Append(ledger_book[p], r, params);
+}
+
+void MultiArb::DoOperationAfterFilled(Order* o, const ExchangeInfo& info) {
+  run_stats.fills++;
+  int p = order_pair.Find(o);
+  if (p < 0) {
+    SLOG_ERROR("filled order %s of no pair\n", o->order_ref);
+    return;
+  }
+  OrderIntent intent = working_orders[p].Fill(o, info, Leg::Unknown);
+  if (info.type == InfoType::Filled) {
+    order_pair.Erase(o);
+  }
+  Leg::Enum leg = intent.GetLeg();
+  if (leg == Leg::Unknown) {  // the index lost it, intent is from the tag
+    leg = SlotOf(o->ticker) == book.main_slot[p] ? Leg::Main : Leg::Hedge;
+  }
+  if (leg == Leg::Main) {
+    double main_cost = book.main_cost[p];
+    ApplyFill(&book.pos[p], &book.main_cost[p], o->side, info.trade_size, info.trade_price);
+    // get hedged right now
+    OrderSide::Enum hedge_side = (o->side == OrderSide::Buy) ? OrderSide::Sell : OrderSide::Buy;
+    Order* hedge = Send(p, intent.Hedge(), hedge_side, info.trade_size);
+    // bookkeeping once the hedge is out, before a test fill moves hedge_cost
+    RecordSlip(p, book.hedge_slot[p], hedge_side, intent.Closes());  // before RecordPnl closes the round
+    if (intent.Closes()) {
+      book.close_round[p]++;
+      run_stats.rounds++;
+      RecordPnl(p, o, info.trade_size, info.trade_price, main_cost, intent.Kind() == IntentKind::ForceFlat);
+      CalParams(p);
+    }
+    HandleTestOrder(hedge);
+  } else {
+    ApplyFill(&book.hedge_pos[p], &book.hedge_cost[p], o->side, info.trade_size, info.trade_price);
+    UpdateBuildPosTime(p);
+    UpdateBound(p, o->side);
+  }
+}
+
+void MultiArb::DoOperationAfterCancelled(Order* o) {
+  int p = order_pair.Find(o);
+  Forget(o);
+  SLOG_INFO("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
+  if (p >= 0 && m_cancel_map[o->ticker] > book.cancel_limit[p]) {
+    StopPair(p, "hit cancel limit");
+  }
+}
+
+void MultiArb::DoOperationAfterUpdatePos(Order* o, const ExchangeInfo& info) {
+}
+
+double MultiArb::OrderPrice(const std::string & ticker, OrderSide::Enum side, bool control_price) {
+  int s = SlotOf(ticker.c_str());
+  if (s < 0) {
+    SLOG_ERROR("error ticker %s\n", ticker.c_str());
+    return -1.0;
+  }
+  if (m_mode == StrategyMode::NextTest && sending_leg == Leg::Hedge) {
+    return (side == OrderSide::Buy) ? next_shot[s]->asks[0] : next_shot[s]->bids[0];
+  }
+  return Take(s, side);
+}
+
+void MultiArb::ModerateOrders(const std::string & ticker) {
+  // just make sure the order filled
+  if (m_mode != StrategyMode::Real) {
+    return;
+  }
+  int s = SlotOf(ticker.c_str());
+  if (s < 0) {
+    return;
+  }
+  SyncOrders();
+  for (int i = slot_begin[s]; i < slot_begin[s + 1]; i++) {
+    int p = slot_pairs[i];
+    int h = book.hedge_slot[p];
+    Order* working[OrderIndex::kCapacity];
+    int n_main = working_orders[p].Collect(Leg::Main, working);
+    int n = n_main + working_orders[p].Collect(Leg::Hedge, working + n_main);
+    for (int j = 0; j < n; j++) {
+      Order* o = working[j];
+      if (!o->Valid()) {
+        continue;
+      }
+      Leg::Enum leg = j < n_main ? Leg::Main : Leg::Hedge;
+      double reasonable_price = Take(leg == Leg::Main ? book.main_slot[p] : h, o->side);
+      if (fabs(reasonable_price - o->price) < book.min_price_move[p]/2) {
+        continue;
+      }
+      double target = book.target_hedge_price[p];
+      if (leg == Leg::Main) {
+        if ((o->side == OrderSide::Buy && bid[h] - target < -1e-4) ||
+            (o->side == OrderSide::Sell && ask[h] - target > -1e-4)) {
+          SLOG_INFO("[%s]target hedge price is %s@%lf, now is %lf %lf\n", book.label[p].c_str(), OrderSide::ToString(o->side), target, bid[h], ask[h]);
+          CancelOrder(o);
+        }
+      } else {
+        sending_leg = Leg::Hedge;
+        ModOrder(o);
+      }
+    }
+  }
+}
+
+void MultiArb::HandleCommand(const Command& shot) {
+  SLOG_INFO("received command for %s! %lf %lf %lf %lf\n", shot.ticker, shot.vdouble[0], shot.vdouble[1], shot.vdouble[2], shot.vdouble[3]);
+  auto it = std::find(book.label.begin(), book.label.end(), shot.ticker);
+  if (it == book.label.end()) {
+    SLOG_WARN("no pair %s\n", shot.ticker);
+    return;
+  }
+  int p = it - book.label.begin();
+  if (fabs(shot.vdouble[0]) > MIN_DOUBLE_DIFF) {
+    book.up[p] = shot.vdouble[0];
+    return;
+  }
+  if (fabs(shot.vdouble[1]) > MIN_DOUBLE_DIFF) {
+    book.down[p] = shot.vdouble[1];
+    return;
+  }
+  if (fabs(shot.vdouble[2]) > MIN_DOUBLE_DIFF) {
+    book.stop_up[p] = shot.vdouble[2];
+    return;
+  }
+  if (fabs(shot.vdouble[3]) > MIN_DOUBLE_DIFF) {
+    book.stop_down[p] = shot.vdouble[3];
+    return;
+  }
+}
+
+void MultiArb::HandleTestOrder(Order* o) {
+  if (m_mode == StrategyMode::Real) {
+    return;
+  }
+  ExchangeInfo info;
+  MakeTestFill(*o, &info);
+  exchange_journal.Append(info);
+  UpdatePos(o, info);
+  DoOperationAfterFilled(o, info);
+}
+
+void MultiArb::Run() {
+  Decide(true);
+}
+
+void MultiArb::Flatting() {
+  Decide(false);
+}
+
+void MultiArb::UpdateData(TickerId id, const MarketSnapshot & shot) {
+  routed_id_ = id;
+  BaseStrategy::UpdateData(shot);
+  routed_id_ = kNoTicker;
+}
+
+void MultiArb::Start() {
+  AsyncLogger::Instance().Register();  // the log ring, before the first tick
+  // buckets for every order the pairs can have working, so the backend's
+  // inserts never rehash on the order path
+  m_order_map.reserve(book.Size() * OrderIndex::kCapacity);
+  Run();
+}
+
+bool MultiArb::Ready() {
+  if (!m_position_ready) {
+    SLOG_WARN("waiting position query finish!\n");
+    return false;
+  }
+  return true;
+}
+
+void MultiArb::Train() {
+}
+
+void MultiArb::Pause() {
+}
+
+void MultiArb::Resume() {
+  for (size_t p = 0; p < book.Size(); p++) {
+    book.sample_head[p] = book.sample_tail[p];
+  }
+}
@@ -0,0 +1,178 @@
+#ifndef STRATEGY_MULTIARB_MULTIARB_H_
+#define STRATEGY_MULTIARB_MULTIARB_H_
+
+#include <stdint.h>
+
+#include <unordered_map>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <libconfig.h++>
+
+#include "struct/market_snapshot.h"
+#include "struct/strategy_status.h"
+#include "struct/strategy_mode.h"
+#include "struct/order.h"
+#include "struct/command.h"
+#include "struct/exchange_info.h"
+#include "struct/order_status.h"
+#include "struct/pair_state.h"
+#include "struct/order_index.h"
+#include "struct/order_owners.h"
+#include "struct/order_intent.h"
+#include "struct/test_fill.h"
+#include "struct/run_stats.h"
+#include "util/time_controller.h"
+#include "util/zmq_sender.hpp"
+#include "util/history_worker.h"
+#include "util/contract_worker.h"
+#include "util/common_tools.h"
+#include "util/rolling_stats.h"
+#include "util/record_journal.h"
+#include "util/fee_point_cache.h"
+#include "util/band_channel.h"
+#include "util/trade_ledger.h"
+#include "util/strat_log.h"
+#include "util/ticker_table.h"
+#include "core/base_strategy.h"
+#include "core/routed_strategy.h"
+#include "multiarb/pair_book.h"
+
+// SimpleArb's band logic for every pair in the `pairs` list of one
+// setting, as one strategy: registered once per distinct ticker, pair
+// state in PairBook arrays, and each snapshot decided for all the pairs
+// it touches in one PairLanes::Scan. a list entry takes unique_name (and
+// optionally main_ticker/hedge_ticker), any other SimpleArb key missing
+// from it comes from the enclosing setting.
+class MultiArb: public BaseStrategy, public RoutedStrategy {
+ public:
+  explicit MultiArb(const libconfig::Setting & param_setting, std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender, TimeController* tc, ContractWorker* cw, HistoryWorker* hw, const std::string & date, StrategyMode::Enum mode = StrategyMode::Real, std::ofstream* exchange_file = nullptr);
+  ~MultiArb();
+
+  void Start() override;
+  void Stop() override;
+
+  using BaseStrategy::UpdateData;
+  void UpdateData(TickerId id, const MarketSnapshot & shot) override;
+
+  // vdouble[0..3] set up/down/stop up/stop down of the pair whose
+  // "main|hedge" label is the command's ticker
+  void HandleCommand(const Command& shot) override;
+
+  const RunStats & Stats() const {
+    return run_stats;
+  }
+
+  size_t Pairs() const {
+    return book.Size();
+  }
+
+ private:
+  friend class StrategyBench;  // bench/ times the callbacks one by one
+
+  static const int64_t kNever = INT64_MIN;
+
+  bool FillStratConfig(const libconfig::Setting& param_setting);
+  bool AddPair(const libconfig::Setting& pair_setting, const libconfig::Setting& param_setting);
+  void RunningSetup(std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender);
+  int Intern(const std::string & ticker);
+  int SlotOf(const char* ticker) const;
+  // by routed_id_ if the shot was routed under one
+  int SlotOf(const MarketSnapshot & shot) const;
+
+  void DoOperationAfterUpdateData(const MarketSnapshot& shot) override;
+  void DoOperationAfterUpdatePos(Order* o, const ExchangeInfo& info) override;
+  void DoOperationAfterFilled(Order* o, const ExchangeInfo& info) override;
+  void DoOperationAfterCancelled(Order* o) override;
+  void ModerateOrders(const std::string & contract) override;
+
+  bool Ready() override;
+  void Pause() override;
+  void Resume() override;
+  void Run() override;
+  void Train() override;
+  void Flatting() override;
+  void ForceFlat() override;
+
+  double OrderPrice(const std::string & contract, OrderSide::Enum side, bool control_price) override;
+
+  // scans the lanes of the last snapshot and acts on them, once
+  void Decide(bool allow_open);
+  void CloseLogic(int p, int32_t signal);
+  void Open(int p, OrderSide::Enum side);
+  bool Close(int p, bool force_flat = false);
+  void ForceFlat(int p);
+  void CalParams(int p);
+  void UpdateBound(int p, OrderSide::Enum side);
+  void UpdateBuildPosTime(int p);
+  bool TimeUp(int p) const;
+  void RecordPnl(int p, const Order* o, int size, double price, double main_cost, bool forced);
+  // slip of an order on slot for the round of p, as SimpleArb::RecordSlip
+  void RecordSlip(int p, int slot, OrderSide::Enum side, bool is_close);
+  void StopPair(int p, const char* why);
+
+  Order* Send(int p, OrderIntent intent, OrderSide::Enum side, int size);
+  void Forget(Order* o);
+  void SyncOrders();
+  void HandleTestOrder(Order* o);
+
+  inline double Mid(int slot) const {
+    return (bid[slot] + ask[slot]) / 2;
+  }
+
+  inline double PairDiff(int p) const {
+    return Mid(book.main_slot[p]) - Mid(book.hedge_slot[p]);
+  }
+
+  inline double Take(int slot, OrderSide::Enum side) const {
+    return (side == OrderSide::Buy) ? ask[slot] : bid[slot];
+  }
+
+  std::string date;
+  bool no_close_today;
+  int max_close_try;
+  int64_t align_tolerance_usec;
+  double ui_publish_hz;
+
+  // tickers, interned to slots in list order
+  std::unordered_map<std::string, int> ticker_slot;
+  std::vector<int> id_slot;  // TickerId -> slot, -1 if not ours
+  std::vector<std::string> tickers;
+  std::vector<double> bid;
+  std::vector<double> ask;
+  std::vector<int> bid_size;
+  std::vector<int> ask_size;
+  std::vector<int64_t> quote_usec;
+  std::vector<uint8_t> quote_good;
+  std::vector<const MarketSnapshot*> next_shot;
+  std::vector<FeePointCache> fees;
+  // pairs of slot s are slot_pairs[slot_begin[s], slot_begin[s + 1])
+  std::vector<int> slot_begin;
+  std::vector<int> slot_pairs;
+
+  PairBook book;
+  PairLanes lanes;
+  std::unique_ptr<RollingStats[]> mid_stats;  // per pair
+  std::unique_ptr<OrderIndex[]> working_orders;  // per pair
+  std::unique_ptr<BandChannel[]> ui_channels;  // per pair
+  OrderOwners order_pair;  // working order -> pair
+  std::vector<std::pair<Order*, int> > kept_orders;  // SyncOrders scratch
+
+  int last_slot;
+  Leg::Enum sending_leg;  // read by OrderPrice while Send is in NewOrder
+  uint64_t aligned;
+  uint64_t dropped;
+  uint64_t repeated;
+  RunStats run_stats;
+  std::ofstream* exchange_file;
+  RecordJournal exchange_journal;  // batches the test fills written to exchange_file
+  std::string ledger_file;
+  TradeLedger ledger;  // a book per pair
+  std::vector<int> ledger_book;  // per pair
+  std::vector<TradeRound> rounds;  // per pair, the round trip being built
+};
+
+#endif  // STRATEGY_MULTIARB_MULTIARB_H_
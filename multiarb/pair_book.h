@@ -0,0 +1,182 @@
+#ifndef STRATEGY_MULTIARB_PAIR_BOOK_H_
+#define STRATEGY_MULTIARB_PAIR_BOOK_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// what PairLanes::Scan found for one pair, as bits
+struct PairSignal {
+  enum {
+    OpenSell = 1,
+    OpenBuy = 2,
+    StopLoss = 4,
+    HitMean = 8
+  };
+};
+
+// per pair state of MultiArb, one array per field indexed by pair. the
+// tick path only touches the band and position arrays of the pairs a
+// snapshot hits; config is read on open/close/recalibration
+struct PairBook {
+  // grows (or shrinks) keeping the pairs already there
+  void Resize(size_t n) {
+    main_slot.resize(n, -1);
+    hedge_slot.resize(n, -1);
+    label.resize(n);
+    mean.resize(n, 0.0);
+    up.resize(n, 0.0);
+    down.resize(n, 0.0);
+    stop_up.resize(n, 0.0);
+    stop_down.resize(n, 0.0);
+    spread_threshold.resize(n, 0.0);
+    target_hedge_price.resize(n, 0.0);
+    pos.resize(n, 0);
+    hedge_pos.resize(n, 0);
+    main_cost.resize(n, 0.0);
+    hedge_cost.resize(n, 0.0);
+    sample_head.resize(n, 0);
+    sample_tail.resize(n, 0);
+    close_round.resize(n, 0);
+    stop_loss_times.resize(n, 0);
+    build_time.resize(n, 0);
+    trained.resize(n, 0);
+    stopped.resize(n, 0);
+    max_pos.resize(n, 0);
+    train_samples.resize(n, 0);
+    max_round.resize(n, 0);
+    max_loss_times.resize(n, 0);
+    max_holding_sec.resize(n, 0);
+    cancel_limit.resize(n, 0);
+    min_price_move.resize(n, 0.0);
+    min_profit.resize(n, 0.0);
+    min_range.resize(n, 0.0);
+    increment.resize(n, 0.0);
+    range_width.resize(n, 0.0);
+    stop_loss_margin.resize(n, 0.0);
+  }
+
+  size_t Size() const {
+    return main_slot.size();
+  }
+
+  // legs, as ticker slots of the owning strategy
+  std::vector<int> main_slot;
+  std::vector<int> hedge_slot;
+  std::vector<std::string> label;  // "main|hedge"
+
+  // bands, on main mid - hedge mid
+  std::vector<double> mean;
+  std::vector<double> up;
+  std::vector<double> down;
+  std::vector<double> stop_up;
+  std::vector<double> stop_down;
+  std::vector<double> spread_threshold;
+  std::vector<double> target_hedge_price;
+
+  // the pair's own position: legs may be shared with other pairs, so the
+  // per ticker m_position_map is not it
+  std::vector<int> pos;  // main leg
+  std::vector<int> hedge_pos;
+  std::vector<double> main_cost;
+  std::vector<double> hedge_cost;
+
+  std::vector<int> sample_head;
+  std::vector<int> sample_tail;
+  std::vector<int> close_round;
+  std::vector<int> stop_loss_times;
+  std::vector<int64_t> build_time;
+  std::vector<uint8_t> trained;
+  std::vector<uint8_t> stopped;
+
+  // config
+  std::vector<int> max_pos;
+  std::vector<int> train_samples;
+  std::vector<int> max_round;
+  std::vector<int> max_loss_times;
+  std::vector<int> max_holding_sec;
+  std::vector<int> cancel_limit;
+  std::vector<double> min_price_move;
+  std::vector<double> min_profit;
+  std::vector<double> min_range;
+  std::vector<double> increment;
+  std::vector<double> range_width;
+  std::vector<double> stop_loss_margin;
+};
+
+// decision inputs of the pairs one snapshot touched, gathered into dense
+// lanes so Scan is a single branch-free loop over contiguous arrays.
+// capacity is the most pairs any one ticker belongs to
+struct PairLanes {
+  PairLanes()
+    : size(0) {
+  }
+
+  void Reserve(size_t n) {
+    pair.assign(n, 0);
+    diff.assign(n, 0.0);
+    spread.assign(n, 0.0);
+    mean.assign(n, 0.0);
+    up.assign(n, 0.0);
+    down.assign(n, 0.0);
+    stop_up.assign(n, 0.0);
+    stop_down.assign(n, 0.0);
+    spread_threshold.assign(n, 0.0);
+    pos.assign(n, 0.0);
+    max_pos.assign(n, 0.0);
+    live.assign(n, 0.0);
+    signal.assign(n, 0);
+    size = 0;
+  }
+
+  // SimpleArb's open/stop/mean tests on every lane: open when the half
+  // spread adjusted diff leaves the band and the position has room, stop
+  // when a tight enough spread shows the diff past the stop line against
+  // the position, hit mean when it is back at the mean. lanes with live
+  // 0 (unaligned, untrained or stopped) signal nothing
+  void Scan() {
+    const double* __restrict d = diff.data();
+    const double* __restrict sp = spread.data();
+    const double* __restrict mn = mean.data();
+    const double* __restrict u = up.data();
+    const double* __restrict dn = down.data();
+    const double* __restrict su = stop_up.data();
+    const double* __restrict sd = stop_down.data();
+    const double* __restrict th = spread_threshold.data();
+    const double* __restrict p = pos.data();
+    const double* __restrict mp = max_pos.data();
+    const double* __restrict lv = live.data();
+    int32_t* __restrict out = signal.data();
+    for (size_t k = 0; k < size; k++) {
+      double lo = d[k] - sp[k] * 0.5;
+      double hi = d[k] + sp[k] * 0.5;
+      int32_t sell = lo > u[k];
+      int32_t buy = (hi < dn[k]) & (sell ^ 1);
+      int32_t room = (p[k] < mp[k]) & (p[k] > -mp[k]);
+      int32_t is_long = p[k] > 0.0;
+      int32_t is_short = p[k] < 0.0;
+      int32_t stop = (sp[k] <= th[k]) & ((is_long & (d[k] < sd[k])) | (is_short & (d[k] > su[k])));
+      int32_t back = (is_long & (lo >= mn[k])) | (is_short & (hi <= mn[k]));
+      int32_t bits = room * (sell * PairSignal::OpenSell + buy * PairSignal::OpenBuy) + stop * PairSignal::StopLoss + back * PairSignal::HitMean;
+      out[k] = bits * static_cast<int32_t>(lv[k]);
+    }
+  }
+
+  size_t size;
+  std::vector<int> pair;  // lane -> pair index
+  std::vector<double> diff;
+  std::vector<double> spread;  // sum of both legs
+  std::vector<double> mean;
+  std::vector<double> up;
+  std::vector<double> down;
+  std::vector<double> stop_up;
+  std::vector<double> stop_down;
+  std::vector<double> spread_threshold;
+  std::vector<double> pos;
+  std::vector<double> max_pos;
+  std::vector<double> live;
+  std::vector<int32_t> signal;
+};
+
+#endif  // STRATEGY_MULTIARB_PAIR_BOOK_H_
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libconfig.h++>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "regress/regression.h"
+#include "replay/replayer.h"
+#include "util/snapshot_tape.h"
+
+// regress <regress.config> [--update | --train]
+// replays every strategy of every session alone and checks it against the
+// golden file. config:
+//   sessions = ["regress/a.config", ...];  // replay configs with data, see replay/replay.cpp,
+//                                          // or with synthetic, see regress/regression.h
+//   golden_file = "regress/golden.txt";
+//   max_slowdown = 0.1;  // optional, fail under golden ticks/s by more than this
+//   pnl_tolerance = 1e-6;  // optional
+//   log_file = "/dev/null";  // optional, where the strategies log
+// --update writes the golden file from this run instead, and so does a
+// run without one. throughput is only comparable on the machine the
+// golden file was written on.
+// --train only replays each session in process, all strategies at once,
+// so an instrumented build writes its profile at exit (see wscript)
+int main(int argc, char** argv) {
+  bool update = (argc == 3 && strcmp(argv[2], "--update") == 0);
+  bool train = (argc == 3 && strcmp(argv[2], "--train") == 0);
+  if (argc != 2 && !update && !train) {
+    printf("usage: %s <regress.config> [--update | --train]\n", argv[0]);
+    return 1;
+  }
+  libconfig::Config cfg;
+  std::vector<std::string> sessions;
+  std::string golden_file;
+  double max_slowdown = 0.1;
+  double pnl_tolerance = 1e-6;
+  std::string log_file = "/dev/null";
+  try {
+    cfg.readFile(argv[1]);
+    const libconfig::Setting & root = cfg.getRoot();
+    const libconfig::Setting & s = root["sessions"];
+    for (int i = 0; i < s.getLength(); i++) {
+      sessions.emplace_back(s[i].c_str());
+    }
+    golden_file = root["golden_file"].c_str();
+    if (root.exists("max_slowdown")) {
+      max_slowdown = root["max_slowdown"];
+    }
+    if (root.exists("pnl_tolerance")) {
+      pnl_tolerance = root["pnl_tolerance"];
+    }
+    if (root.exists("log_file")) {
+      log_file = root["log_file"].c_str();
+    }
+  } catch (const libconfig::FileIOException &) {
+    printf("read %s failed\n", argv[1]);
+    return 1;
+  } catch (const libconfig::ParseException & e) {
+    printf("parse %s failed at line %d: %s\n", e.getFile(), e.getLine(), e.getError());
+    return 1;
+  } catch (const libconfig::SettingException & e) {
+    printf("regress config error at %s: %s\n", e.getPath(), e.what());
+    return 1;
+  }
+
+  std::vector<RegressResult> results;
+  bool failed = false;
+  if (!train) {
+    printf("%-32s %-24s %12s %12s %10s %10s %12s\n", "session", "strategy", "ticks/s", "orders/s", "rss MB", "cpu s", "pnl");
+  }
+  for (const std::string & session : sessions) {
+    libconfig::Config session_cfg;
+    try {
+      session_cfg.readFile(session.c_str());
+    } catch (const libconfig::FileIOException &) {
+      printf("read %s failed\n", session.c_str());
+      return 1;
+    } catch (const libconfig::ParseException & e) {
+      printf("parse %s failed at line %d: %s\n", e.getFile(), e.getLine(), e.getError());
+      return 1;
+    }
+    libconfig::Setting & root = session_cfg.getRoot();
+    if ((!root.exists("data") && !root.exists("synthetic")) || !root.exists("strategy")) {
+      printf("no data, synthetic or strategy in %s\n", session.c_str());
+      return 1;
+    }
+    SnapshotTape tape;
+    if (root.exists("data")) {
+      const libconfig::Setting & data = root["data"];
+      for (int i = 0; i < data.getLength(); i++) {
+        std::string path = data[i];
+        if (!tape.Add(path)) {
+          return 1;
+        }
+      }
+    }
+    if (root.exists("synthetic") && !AddSynthetic(root, &tape)) {
+      return 1;
+    }
+    tape.Build();
+    if (train) {
+      Replayer replayer(root);
+      size_t ticks = replayer.Run(tape);
+      printf("%-32s trained on %zu ticks, %ld orders\n", session.c_str(), ticks, replayer.OrdersSent());
+      continue;
+    }
+    int n = root["strategy"].getLength();
+    for (int k = 0; k < n; k++) {
+      const libconfig::Setting & s = root["strategy"][k];
+      RegressResult r;
+      r.session = session;
+      r.strategy = s.exists("unique_name") ? s["unique_name"].c_str() : s["type"].c_str();
+      if (!RunIsolated(root, k, tape, log_file, &r)) {
+        failed = true;
+        continue;
+      }
+      printf("%-32s %-24s %12.0lf %12.0lf %10.1lf %10.3lf %12.4lf\n", r.session.c_str(), r.strategy.c_str(), r.ticks_per_sec, r.seconds > 0 ? r.orders / r.seconds : 0.0, r.peak_rss_kb / 1024.0, r.cpu_seconds, r.stats.pnl);
+      results.emplace_back(r);
+    }
+  }
+
+  if (train) {
+    return 0;
+  }
+  bool first_run = access(golden_file.c_str(), F_OK) != 0;
+  if (update || first_run) {
+    if (failed || !WriteGolden(golden_file, results)) {
+      printf("golden file %s not written\n", golden_file.c_str());
+      return 1;
+    }
+    printf("%zu results written to %s%s\n", results.size(), golden_file.c_str(), first_run ? ", the first run on this machine: later runs are checked against it" : "");
+    return 0;
+  }
+  std::vector<RegressResult> golden;
+  if (!ReadGolden(golden_file, &golden)) {
+    printf("golden file %s unreadable, run with --update (make golden) to rewrite it\n", golden_file.c_str());
+    return 1;
+  }
+  std::map<std::string, const RegressResult*> by_key;
+  for (const RegressResult & g : golden) {
+    by_key[g.session + ' ' + g.strategy] = &g;
+  }
+  for (const RegressResult & r : results) {
+    auto it = by_key.find(r.session + ' ' + r.strategy);
+    if (it == by_key.end()) {
+      printf("FAIL %s %s: not in golden file\n", r.session.c_str(), r.strategy.c_str());
+      failed = true;
+      continue;
+    }
+    std::string why = Compare(r, *it->second, pnl_tolerance, max_slowdown);
+    if (!why.empty()) {
+      printf("FAIL %s %s: %s\n", r.session.c_str(), r.strategy.c_str(), why.c_str());
+      failed = true;
+    }
+    by_key.erase(it);
+  }
+  for (auto & kv : by_key) {
+    printf("FAIL %s: in golden file, not run\n", kv.first.c_str());
+    failed = true;
+  }
+  printf("%s: %zu runs against %s\n", failed ? "FAILED" : "passed", results.size(), golden_file.c_str());
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "bench/synthetic_feed.h"
+#include "replay/replayer.h"
+#include "regress/regression.h"
+#include "util/async_logger.h"
+
+namespace {
+
+// what the child writes back, one pipe write
+struct ChildReport {
+  uint64_t ticks;
+  int64_t orders;
+  uint64_t digest;
+  double pnl;
+  int32_t rounds;
+  int32_t fills;
+  double seconds;
+};
+
+double Seconds(const timeval & t) {
+  return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+void RunChild(libconfig::Setting & root, int k, const SnapshotTape & tape, const std::string & log_file, int fd) {
+  AsyncLogger::Instance().Open(log_file);
+  libconfig::Setting & strategies = root["strategy"];
+  for (int i = strategies.getLength() - 1; i >= 0; i--) {
+    if (i != k) {
+      strategies.remove(static_cast<unsigned int>(i));
+    }
+  }
+  ChildReport report;
+  {
+    Replayer replayer(root);
+    auto begin = std::chrono::steady_clock::now();
+    report.ticks = replayer.Run(tape);
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    report.orders = replayer.OrdersSent();
+    report.digest = replayer.OrderDigest();
+    const RunStats & s = *replayer.Stats()[0];
+    report.pnl = s.pnl;
+    report.rounds = s.rounds;
+    report.fills = s.fills;
+  }
+  AsyncLogger::Instance().Flush();
+  ssize_t n = write(fd, &report, sizeof(report));
+  // no exit(): the stdio buffers and atexit handlers are the parent's
+  _exit(n == static_cast<ssize_t>(sizeof(report)) ? 0 : 1);
+}
+
+}  // namespace
+
+bool RunIsolated(libconfig::Setting & root, int k, const SnapshotTape & tape, const std::string & log_file, RegressResult* result) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    return false;
+  }
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    RunChild(root, k, tape, log_file, fds[1]);
+  }
+  close(fds[1]);
+  ChildReport report;
+  ssize_t n = read(fds[0], &report, sizeof(report));
+  close(fds[0]);
+  int status = 0;
+  rusage usage;
+  if (wait4(pid, &status, 0, &usage) != pid) {
+    perror("wait4");
+    return false;
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || n != static_cast<ssize_t>(sizeof(report))) {
+    printf("%s %s: replay failed\n", result->session.c_str(), result->strategy.c_str());
+    return false;
+  }
+  result->ticks = report.ticks;
+  result->orders = report.orders;
+  result->digest = report.digest;
+  result->stats.pnl = report.pnl;
+  result->stats.rounds = report.rounds;
+  result->stats.fills = report.fills;
+  result->seconds = report.seconds;
+  result->cpu_seconds = Seconds(usage.ru_utime) + Seconds(usage.ru_stime);
+  result->peak_rss_kb = usage.ru_maxrss;
+  result->ticks_per_sec = report.seconds > 0 ? report.ticks / report.seconds : 0.0;
+  return true;
+}
+
+bool ReadGolden(const std::string & path, std::vector<RegressResult>* golden) {
+  std::ifstream in(path.c_str());
+  if (!in.is_open()) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    RegressResult g;
+    std::string digest;
+    if (!(fields >> g.session >> g.strategy >> g.ticks >> g.orders >> digest >> g.stats.pnl >> g.stats.rounds >> g.stats.fills >> g.ticks_per_sec)) {
+      printf("bad golden line in %s: %s\n", path.c_str(), line.c_str());
+      return false;
+    }
+    g.digest = strtoull(digest.c_str(), nullptr, 16);
+    golden->emplace_back(g);
+  }
+  return true;
+}
+
+bool WriteGolden(const std::string & path, const std::vector<RegressResult> & results) {
+  FILE* f = fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    printf("open %s failed\n", path.c_str());
+    return false;
+  }
+  fprintf(f, "# session strategy ticks orders digest pnl rounds fills ticks_per_sec\n");
+  for (const RegressResult & r : results) {
+    fprintf(f, "%s %s %zu %ld %016" PRIx64 " %.17g %d %d %.0lf\n", r.session.c_str(), r.strategy.c_str(), r.ticks, r.orders, r.digest, r.stats.pnl, r.stats.rounds, r.stats.fills, r.ticks_per_sec);
+  }
+  return fclose(f) == 0;
+}
+
+std::string Compare(const RegressResult & r, const RegressResult & g, double pnl_tolerance, double max_slowdown) {
+  char why[256];
+  if (r.ticks != g.ticks) {
+    snprintf(why, sizeof(why), "ticks %zu, golden %zu", r.ticks, g.ticks);
+  } else if (r.orders != g.orders || r.digest != g.digest) {
+    snprintf(why, sizeof(why), "order stream differs: %ld orders %016" PRIx64 ", golden %ld %016" PRIx64, r.orders, r.digest, g.orders, g.digest);
+  } else if (r.stats.rounds != g.stats.rounds || r.stats.fills != g.stats.fills) {
+    snprintf(why, sizeof(why), "%d rounds %d fills, golden %d %d", r.stats.rounds, r.stats.fills, g.stats.rounds, g.stats.fills);
+  } else if (fabs(r.stats.pnl - g.stats.pnl) > pnl_tolerance) {
+    snprintf(why, sizeof(why), "pnl %lf, golden %lf", r.stats.pnl, g.stats.pnl);
+  } else if (r.ticks_per_sec < g.ticks_per_sec * (1.0 - max_slowdown)) {
+    snprintf(why, sizeof(why), "%.0lf ticks/s, %.1lf%% under golden %.0lf", r.ticks_per_sec, 100.0 * (1.0 - r.ticks_per_sec / g.ticks_per_sec), g.ticks_per_sec);
+  } else {
+    return "";
+  }
+  return why;
+}
+
+bool AddSynthetic(const libconfig::Setting & root, SnapshotTape* tape) {
+  int ticks = 200000;
+  double rate = 100.0;
+  double tick = 1.0;
+  double price = 3000.0;
+  int seed = 1;
+  std::vector<std::string> tickers;
+  try {
+    const libconfig::Setting & s = root["synthetic"];
+    s.lookupValue("ticks", ticks);
+    s.lookupValue("rate", rate);
+    s.lookupValue("tick", tick);
+    s.lookupValue("price", price);
+    s.lookupValue("seed", seed);
+    Replayer probe(root);  // only for what its strategies subscribe to
+    tickers = probe.Tickers();
+  } catch (const libconfig::SettingException & e) {
+    printf("synthetic config error at %s: %s\n", e.getPath(), e.what());
+    return false;
+  }
+  if (tickers.empty() || ticks <= 0 || rate <= 0 || tick <= 0) {
+    printf("synthetic session needs subscribed tickers and positive ticks, rate and tick\n");
+    return false;
+  }
+  for (size_t i = 0; i < tickers.size(); i += 2) {
+    // an odd last ticker is quoted against a nameless hedge, whose
+    // snapshots are dropped
+    std::string hedge = (i + 1 < tickers.size()) ? tickers[i] : std::string();
+    std::string main = (i + 1 < tickers.size()) ? tickers[i + 1] : tickers[i];
+    SyntheticFeed feed(main, hedge, tick, price, rate, seed + i);
+    std::vector<MarketSnapshot> records;
+    records.reserve(ticks);
+    for (int k = 0; k < ticks; k++) {
+      const MarketSnapshot & shot = feed.Next();
+      if (shot.ticker[0] != '\0') {
+        records.emplace_back(shot);
+      }
+    }
+    tape->Add(std::move(records));
+  }
+  return true;
+}
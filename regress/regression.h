@@ -0,0 +1,65 @@
+#ifndef STRATEGY_REGRESS_REGRESSION_H_
+#define STRATEGY_REGRESS_REGRESSION_H_
+
+#include <stdint.h>
+
+#include <libconfig.h++>
+
+#include <string>
+#include <vector>
+
+#include "struct/run_stats.h"
+#include "util/snapshot_tape.h"
+
+// what one strategy replayed alone over one session came to
+struct RegressResult {
+  RegressResult()
+    : ticks(0),
+      orders(0),
+      digest(0),
+      seconds(0.0),
+      cpu_seconds(0.0),
+      peak_rss_kb(0),
+      ticks_per_sec(0.0) {
+  }
+
+  std::string session;
+  std::string strategy;  // unique_name, the type if it has none
+  size_t ticks;
+  long orders;
+  uint64_t digest;  // of the order stream, see util/order_digest.h
+  RunStats stats;
+  double seconds;  // wall, the replay alone
+  double cpu_seconds;  // user + system of the child, setup included
+  long peak_rss_kb;  // of the child, the tape it shares with the parent included
+  double ticks_per_sec;
+};
+
+// replays strategy k of the replay config root over tape in a forked
+// child, so cpu time and peak rss are that strategy's alone. the child's
+// strategy logs go to log_file. false (and a message) if the child failed
+bool RunIsolated(libconfig::Setting & root, int k, const SnapshotTape & tape, const std::string & log_file, RegressResult* result);
+
+// a session without recordings: the tickers the replay config's
+// strategies subscribe to, sorted, are paired up (so contracts of one
+// product go together, an odd last one is quoted alone) and each pair
+// gets a bench/synthetic_feed.h feed. synthetic = {
+//   ticks = 200000;  // snapshots per pair, the legs alternate
+//   rate = 100.0;    // snapshots per second per leg
+//   tick = 1.0;      // price step of the quotes
+//   price = 3000.0;  // starting hedge mid
+//   seed = 1;
+// };
+bool AddSynthetic(const libconfig::Setting & root, SnapshotTape* tape);
+
+// golden files are a line per result:
+//   session strategy ticks orders digest pnl rounds fills ticks_per_sec
+bool ReadGolden(const std::string & path, std::vector<RegressResult>* golden);
+bool WriteGolden(const std::string & path, const std::vector<RegressResult> & results);
+
+// why r does not match its golden g, empty if it does. ticks, orders,
+// digest, rounds and fills must be equal, pnl within pnl_tolerance, and
+// ticks/s no more than max_slowdown (a fraction) under g's
+std::string Compare(const RegressResult & r, const RegressResult & g, double pnl_tolerance, double max_slowdown);
+
+#endif  // STRATEGY_REGRESS_REGRESSION_H_
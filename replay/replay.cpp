@@ -0,0 +1,54 @@
+#include <stdio.h>
+
+#include <libconfig.h++>
+
+#include <chrono>
+#include <string>
+
+#include "replay/replayer.h"
+#include "util/snapshot_tape.h"
+
+// replay <config>
+// config: the Replayer keys plus data = ["a.dat", "b.dat", ...], raw
+// MarketSnapshot recordings merged by time
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    printf("usage: %s <replay.config>\n", argv[0]);
+    return 1;
+  }
+  libconfig::Config cfg;
+  try {
+    cfg.readFile(argv[1]);
+  } catch (const libconfig::FileIOException &) {
+    printf("read %s failed\n", argv[1]);
+    return 1;
+  } catch (const libconfig::ParseException & e) {
+    printf("parse %s failed at line %d: %s\n", e.getFile(), e.getLine(), e.getError());
+    return 1;
+  }
+  const libconfig::Setting & root = cfg.getRoot();
+  if (!root.exists("data")) {
+    printf("no data in %s\n", argv[1]);
+    return 1;
+  }
+  SnapshotTape tape;
+  const libconfig::Setting & data = root["data"];
+  for (int i = 0; i < data.getLength(); i++) {
+    std::string path = data[i];
+    if (!tape.Add(path)) {
+      return 1;
+    }
+  }
+  tape.Build();
+  printf("%zu snapshots of %zu tickers loaded\n", tape.size(), tape.Tickers().size());
+  Replayer replayer(root);
+  auto begin = std::chrono::steady_clock::now();
+  size_t ticks = replayer.Run(tape);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  printf("replayed %zu ticks of %zu in %.3lfs, %.0lf ticks/s\n", ticks, tape.size(), sec, sec > 0 ? ticks / sec : 0.0);
+  for (size_t i = 0; i < replayer.Stats().size(); i++) {
+    const RunStats & s = *replayer.Stats()[i];
+    printf("strategy %zu: pnl %lf, %d rounds, %d fills\n", i, s.pnl, s.rounds, s.fills);
+  }
+  return 0;
+}
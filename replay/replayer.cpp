@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <algorithm>
+
+#include "replay/replayer.h"
+
+Replayer::Replayer(const libconfig::Setting & root)
+  : Replayer(root, root["strategy"]) {
+}
+
+Replayer::Replayer(const libconfig::Setting & root, const libconfig::Setting & strategies)
+  : mode_(StrategyMode::NextTest) {
+  try {
+    std::string mode = root["mode"];
+    if (mode == "NextTest") {
+      mode_ = StrategyMode::NextTest;
+    } else if (mode == "PlainTest") {
+      mode_ = StrategyMode::PlainTest;
+    } else {
+      printf("replay mode must be NextTest or PlainTest, got %s\n", mode.c_str());
+      exit(1);
+    }
+    date_ = root["date"].c_str();
+    LoadWorkers(root, &workers_);
+    if (root.exists("exchange_file")) {
+      std::string exchange_file = root["exchange_file"];
+      exchange_file_.reset(new std::ofstream(exchange_file.c_str(), std::ios::out | std::ios::binary));
+    }
+    StrategyEnv env;
+    env.ticker_strat_map = &ticker_strat_map_;
+    env.ui_sender = &ui_sender_;
+    env.order_sender = &order_sender_;
+    env.tc = workers_.tc.get();
+    env.cw = workers_.cw.get();
+    env.hw = workers_.hw.get();
+    env.date = date_;
+    env.mode = mode_;
+    env.exchange_file = exchange_file_.get();
+    for (int i = 0; i < strategies.getLength(); i++) {
+      const RunStats* stats = nullptr;
+      BaseStrategy* s = NewStrategy(strategies[i], env, &stats);
+      if (s == nullptr) {
+        exit(1);
+      }
+      strategies_.emplace_back(s);
+      stats_.emplace_back(stats);
+    }
+    router_.Subscribe(ticker_strat_map_);
+    router_.Freeze();
+  } catch (const libconfig::SettingException & e) {
+    printf("replay config error at %s: %s\n", e.getPath(), e.what());
+    exit(1);
+  }
+}
+
+Replayer::~Replayer() {
+  for (auto s : strategies_) {
+    delete s;
+  }
+  if (exchange_file_) {
+    exchange_file_->close();
+  }
+}
+
+std::vector<std::string> Replayer::Tickers() const {
+  std::vector<std::string> tickers;
+  for (auto & kv : ticker_strat_map_) {
+    if (kv.first != "positionend" && !kv.second.empty()) {
+      tickers.emplace_back(kv.first);
+    }
+  }
+  std::sort(tickers.begin(), tickers.end());
+  return tickers;
+}
+
+void Replayer::SendPositionEnd() {
+  for (auto s : router_.Subscribers(TickerTable::Find("positionend"))) {
+    ::SendPositionEnd(s);
+  }
+}
+
+size_t Replayer::Run(const SnapshotTape & tape) {
+  SendPositionEnd();
+  for (auto s : strategies_) {
+    s->Start();
+  }
+  // tape ticker ids to interned ids once, kNoTicker for tickers nobody trades
+  std::vector<TickerId> route;
+  route.reserve(tape.Tickers().size());
+  for (const std::string & ticker : tape.Tickers()) {
+    route.emplace_back(TickerTable::Find(ticker));
+  }
+  bool next_test = (mode_ == StrategyMode::NextTest);
+  size_t ticks = 0;
+  for (size_t i = 0; i < tape.size(); i++) {
+    TickerId id = route[tape.TickerId(i)];
+    if (id == kNoTicker) {
+      continue;
+    }
+    const MarketSnapshot* next = next_test ? tape.Next(i) : nullptr;
+    if (router_.Deliver(id, tape[i], next) > 0) {
+      ticks++;
+    }
+  }
+  for (auto s : strategies_) {
+    s->Stop();
+  }
+  return ticks;
+}
@@ -0,0 +1,86 @@
+#ifndef STRATEGY_REPLAY_REPLAYER_H_
+#define STRATEGY_REPLAY_REPLAYER_H_
+
+#include <libconfig.h++>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "struct/market_snapshot.h"
+#include "struct/order.h"
+#include "struct/strategy_mode.h"
+#include "struct/run_stats.h"
+#include "util/time_controller.h"
+#include "util/history_worker.h"
+#include "util/contract_worker.h"
+#include "util/null_sender.h"
+#include "util/order_digest.h"
+#include "util/snapshot_tape.h"
+#include "core/base_strategy.h"
+#include "core/ticker_router.h"
+#include "replay/strategy_factory.h"
+
+// drives the strategies of one config over a SnapshotTape in virtual time,
+// no sockets and no sleeping, orders are matched by the strategies' own
+// test mode. config keys:
+//   date, mode ("NextTest" or "PlainTest"), contract_config,
+//   history_file (optional), exchange_file (optional),
+//   time_controller { sleep_time, close_time, force_close_time, time_zone_diff },
+//   strategy ( { type = "simplearb"; ... }, ... )
+class Replayer {
+ public:
+  explicit Replayer(const libconfig::Setting & root);
+  // same, with the strategy list given apart from root
+  Replayer(const libconfig::Setting & root, const libconfig::Setting & strategies);
+  ~Replayer();
+
+  Replayer(const Replayer&) = delete;
+  Replayer& operator=(const Replayer&) = delete;
+
+  // feed every record of tape, returns the number of ticks delivered
+  size_t Run(const SnapshotTape & tape);
+
+  const std::vector<BaseStrategy*> & Strategies() const {
+    return strategies_;
+  }
+
+  // the market tickers the strategies subscribed to, sorted
+  std::vector<std::string> Tickers() const;
+
+  // parallel to Strategies()
+  const std::vector<const RunStats*> & Stats() const {
+    return stats_;
+  }
+
+  // every order the strategies sent, and the digest of the stream
+  long OrdersSent() const {
+    return order_sender_.Sent();
+  }
+
+  uint64_t OrderDigest() const {
+    return order_sender_.Digest();
+  }
+
+  StrategyMode::Enum Mode() const {
+    return mode_;
+  }
+
+ private:
+  void SendPositionEnd();
+
+  StrategyMode::Enum mode_;
+  std::string date_;
+  StrategyWorkers workers_;
+  std::unique_ptr<std::ofstream> exchange_file_;
+  NullSender<MarketSnapshot> ui_sender_;
+  OrderDigestSender order_sender_;
+  std::unordered_map<std::string, std::vector<BaseStrategy*> > ticker_strat_map_;
+  TickerRouter router_;  // ticker_strat_map_ by id, frozen once the strategies are built
+  std::vector<BaseStrategy*> strategies_;
+  std::vector<const RunStats*> stats_;
+};
+
+#endif  // STRATEGY_REPLAY_REPLAYER_H_
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "simplearb/simplearb.h"
+#include "simplearb2/simplearb2.h"
+#include "coinarb/coinarb.h"
+#include "pairtrading/pairtrading.h"
+#include "multiarb/multiarb.h"
+#include "simplemaker/simplemaker.h"
+#include "replay/strategy_factory.h"
+
+namespace {
+
+std::vector<std::string> ReadStrings(const libconfig::Setting & s) {
+  std::vector<std::string> v;
+  for (int i = 0; i < s.getLength(); i++) {
+    v.emplace_back(s[i].c_str());
+  }
+  return v;
+}
+
+template <typename T>
+BaseStrategy* Built(T* s, const RunStats** stats) {
+  if (stats != nullptr) {
+    *stats = &s->Stats();
+  }
+  return s;
+}
+
+// simplemaker predates the config constructors: tickers and size come
+// from unique_name, main_ticker, hedge_ticker and max_position, the tick
+// from the contract config
+BaseStrategy* NewSimpleMaker(const libconfig::Setting & param_setting, const StrategyEnv & env, const RunStats** stats) {
+  std::string unique_name = param_setting["unique_name"];
+  std::string main_ticker = param_setting["main_ticker"];
+  std::string hedge_ticker = param_setting["hedge_ticker"];
+  int max_pos = param_setting["max_position"];
+  double min_price_move = env.cw->Lookup(unique_name)["min_price_move"];
+  SimpleMaker* s = new SimpleMaker(main_ticker, hedge_ticker, max_pos, min_price_move, *env.tc, 1, unique_name, env.ticker_strat_map, false, false);
+  s->Attach(env.ui_sender, env.order_sender, env.cw, env.mode, env.exchange_file);
+  return Built(s, stats);
+}
+
+}  // namespace
+
+void LoadWorkers(const libconfig::Setting & root, StrategyWorkers* workers) {
+  const libconfig::Setting & tc_setting = root["time_controller"];
+  std::string force_close_time = tc_setting["force_close_time"];
+  int time_zone_diff = tc_setting["time_zone_diff"];
+  workers->tc.reset(new TimeController(ReadStrings(tc_setting["sleep_time"]), ReadStrings(tc_setting["close_time"]), force_close_time, time_zone_diff));
+  std::string contract_config = root["contract_config"];
+  workers->cw.reset(new ContractWorker(contract_config));
+  if (root.exists("history_file")) {
+    std::string history_file = root["history_file"];
+    workers->hw.reset(new HistoryWorker(history_file));
+  }
+}
+
+void SendPositionEnd(BaseStrategy* s) {
+  ExchangeInfo info;
+  memset(&info, 0, sizeof(info));
+  info.type = InfoType::Position;
+  snprintf(info.ticker, sizeof(info.ticker), "%s", "positionend");
+  s->UpdateExchangeInfo(info);
+}
+
+BaseStrategy* NewStrategy(const libconfig::Setting & param_setting, const StrategyEnv & env, const RunStats** stats) {
+  std::string type = param_setting["type"];
+  if (type == "simplemaker") {
+    return NewSimpleMaker(param_setting, env, stats);
+  }
+  bool named = param_setting.exists("main_ticker") && param_setting.exists("hedge_ticker");
+  if ((type == "simplearb" || type == "simplearb2") && !named && env.hw == nullptr) {
+    printf("%s needs main_ticker and hedge_ticker or a history_file\n", type.c_str());
+    return nullptr;
+  }
+  if (type == "simplearb") {
+    return Built(new SimpleArb(param_setting, env.ticker_strat_map, env.ui_sender, env.order_sender, env.tc, env.cw, env.hw, env.date, env.mode, env.exchange_file), stats);
+  } else if (type == "simplearb2") {
+    return Built(new SimpleArb2(param_setting, env.ticker_strat_map, env.ui_sender, env.order_sender, env.tc, env.cw, env.hw, env.date, env.mode, env.exchange_file), stats);
+  } else if (type == "coinarb") {
+    return Built(new CoinArb(param_setting, env.ticker_strat_map, env.ui_sender, env.order_sender, env.tc, env.cw, env.date, env.mode, env.exchange_file), stats);
+  } else if (type == "pairtrading") {
+    return Built(new PairTrading(param_setting, env.ticker_strat_map, env.ui_sender, env.order_sender, env.tc, env.cw, env.date, env.mode, env.exchange_file), stats);
+  } else if (type == "multiarb") {
+    return Built(new MultiArb(param_setting, env.ticker_strat_map, env.ui_sender, env.order_sender, env.tc, env.cw, env.hw, env.date, env.mode, env.exchange_file), stats);
+  }
+  printf("unknown strategy type %s\n", type.c_str());
+  return nullptr;
+}
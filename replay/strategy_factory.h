@@ -0,0 +1,56 @@
+#ifndef STRATEGY_REPLAY_STRATEGY_FACTORY_H_
+#define STRATEGY_REPLAY_STRATEGY_FACTORY_H_
+
+#include <unordered_map>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libconfig.h++>
+
+#include "struct/market_snapshot.h"
+#include "struct/order.h"
+#include "struct/run_stats.h"
+#include "struct/strategy_mode.h"
+#include "util/time_controller.h"
+#include "util/zmq_sender.hpp"
+#include "util/history_worker.h"
+#include "util/contract_worker.h"
+#include "core/base_strategy.h"
+
+// what every offline driver hands a strategy constructor
+struct StrategyEnv {
+  std::unordered_map<std::string, std::vector<BaseStrategy*> >* ticker_strat_map;
+  BaseSender<MarketSnapshot>* ui_sender;
+  BaseSender<Order>* order_sender;
+  TimeController* tc;
+  ContractWorker* cw;
+  HistoryWorker* hw;
+  std::string date;
+  StrategyMode::Enum mode;
+  std::ofstream* exchange_file;
+};
+
+// the backend workers of an offline run, from the config keys
+// time_controller, contract_config and the optional history_file
+struct StrategyWorkers {
+  std::unique_ptr<TimeController> tc;
+  std::unique_ptr<ContractWorker> cw;
+  std::unique_ptr<HistoryWorker> hw;
+};
+
+// throws libconfig::SettingException on a missing or mistyped key
+void LoadWorkers(const libconfig::Setting & root, StrategyWorkers* workers);
+
+// what the backend sends once the position snapshot is complete
+void SendPositionEnd(BaseStrategy* s);
+
+// builds the strategy named by param_setting["type"]: simplearb,
+// simplearb2, coinarb, pairtrading, multiarb or simplemaker. nullptr for
+// an unknown type.
+// *stats, if given, is pointed at the strategy's RunStats
+BaseStrategy* NewStrategy(const libconfig::Setting & param_setting, const StrategyEnv & env, const RunStats** stats = nullptr);
+
+#endif  // STRATEGY_REPLAY_STRATEGY_FACTORY_H_
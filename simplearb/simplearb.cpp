@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include <iostream>
 #include <string>
 #include <algorithm>
@@ -6,11 +8,9 @@
 
 #include "./simplearb.h"
 void PrintDeque(const std::deque<double> & d) {
-  std::cout << "start print deque: ";
-  for (auto i : d) {
-    std::cout << i << " ";
+  for (size_t i = 0; i < d.size(); i++) {
+    SLOG_INFO("deque[%zu/%zu]: %lf\n", i, d.size(), d[i]);
   }
-  std::cout << "end print" << std::endl;
 }
 
 SimpleArb::SimpleArb(const libconfig::Setting & param_setting, std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender, TimeController* tc, ContractWorker* cw, HistoryWorker* hw, const std::string & date, StrategyMode::Enum mode, std::ofstream* exchange_file)
@@ -23,11 +23,19 @@ SimpleArb::SimpleArb(const libconfig::Setting & param_setting, std::unordered_ma
     close_round(0),
     sample_head(0),
     sample_tail(0),
-    exchange_file(exchange_file) {
+    ui_publish_hz(10.0),
+    checkpoint_max_age_sec(600),
+    checkpoint_tried(false),
+    exchange_file(exchange_file),
+    ledger_book(-1),
+    round() {
   m_tc = tc;
   m_cw = cw;
   m_hw = hw;
   SetStrategyMode(mode, exchange_file);
+  if (mode != StrategyMode::Real) {
+    exchange_journal.Reset(exchange_file);
+  }
   if (FillStratConfig(param_setting)) {
     RunningSetup(ticker_strat_map, uisender, ordersender);
   }
@@ -37,7 +45,7 @@ SimpleArb::~SimpleArb() {
 }
 
 void SimpleArb::RunningSetup(std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender) {
-  m_ui_sender = uisender;
+  m_ui_sender = BandChannel::Share(uisender);  // ui_channel sends on it from the publisher thread
   m_order_sender = ordersender;
   (*ticker_strat_map)[main_ticker].emplace_back(this);
   (*ticker_strat_map)[hedge_ticker].emplace_back(this);
@@ -47,6 +55,16 @@ void SimpleArb::RunningSetup(std::unordered_map<std::string, std::vector<BaseStr
   m_shot_map[hedge_ticker] = shot;
   m_avgcost_map[main_ticker] = 0.0;
   m_avgcost_map[hedge_ticker] = 0.0;
+  legs.Bind(main_ticker, hedge_ticker, &m_shot_map, &m_next_shot_map, &m_position_map, &m_avgcost_map);
+  fees[Leg::Main].Bind(m_cw, main_ticker, no_close_today);
+  fees[Leg::Hedge].Bind(m_cw, hedge_ticker, no_close_today);
+  ui_channel.Open(main_ticker + '|' + hedge_ticker, m_ui_sender, ui_publish_hz);
+  if (!checkpoint_file.empty()) {
+    checkpoint.Open(checkpoint_file, m_strat_name + '|' + main_ticker + '|' + hedge_ticker, 1, train_samples, kBands);
+  }
+  if (!ledger_file.empty() && ledger.Open(ledger_file)) {
+    ledger_book = ledger.AddBook(m_strat_name + '|' + main_ticker + '|' + hedge_ticker, {"range_width", "min_profit", "min_range", "increment", "stop_loss_margin"});
+  }
 }
 
 bool SimpleArb::FillStratConfig(const libconfig::Setting& param_setting) {
@@ -54,14 +72,21 @@ bool SimpleArb::FillStratConfig(const libconfig::Setting& param_setting) {
     std::string unique_name = param_setting["unique_name"];
     const libconfig::Setting & contract_setting = m_cw->Lookup(unique_name);
     m_strat_name = unique_name;
-    auto v = m_hw->GetAllTicker(unique_name);
-    if (v.size() < 2) {
-      printf("no enough ticker for %s\n", unique_name.c_str());
-      // PrintVector(v);
-      return false;
+    if (param_setting.exists("main_ticker") && param_setting.exists("hedge_ticker")) {
+      std::string m = param_setting["main_ticker"];
+      std::string h = param_setting["hedge_ticker"];
+      main_ticker = m;
+      hedge_ticker = h;
+    } else {
+      auto v = m_hw->GetAllTicker(unique_name);
+      if (v.size() < 2) {
+        SLOG_ERROR("no enough ticker for %s\n", unique_name.c_str());
+        // PrintVector(v);
+        return false;
+      }
+      main_ticker = v[1].first;
+      hedge_ticker = v[0].first;
     }
-    main_ticker = v[1].first;
-    hedge_ticker = v[0].first;
     max_pos = param_setting["max_position"];
     train_samples = param_setting["train_samples"];
     double m_r = param_setting["min_range"];
@@ -81,19 +106,56 @@ bool SimpleArb::FillStratConfig(const libconfig::Setting& param_setting) {
     cancel_limit = contract_setting["cancel_limit"];
     max_round = param_setting["max_round"];
     split_num = param_setting["split_num"];
+    if (param_setting.exists("align_tolerance_ms")) {
+      double ms = param_setting["align_tolerance_ms"];
+      aligner.SetTolerance(static_cast<int64_t>(ms * 1000));
+    }
+    if (param_setting.exists("fee_mid_tolerance")) {
+      double fee_mid_tolerance = param_setting["fee_mid_tolerance"];
+      fees[Leg::Main].SetTolerance(fee_mid_tolerance);
+      fees[Leg::Hedge].SetTolerance(fee_mid_tolerance);
+    }
+    if (param_setting.exists("ui_publish_hz")) {
+      ui_publish_hz = param_setting["ui_publish_hz"];
+    }
     if (param_setting.exists("no_close_today")) {
       no_close_today = param_setting["no_close_today"];
     }
+    int series_capacity = train_samples;
+    if (param_setting.exists("series_capacity")) {
+      series_capacity = param_setting["series_capacity"];
+    }
+    map_vector.Reset(std::max(series_capacity, train_samples));
+    if (param_setting.exists("spill_file")) {
+      std::string spill_file = param_setting["spill_file"];
+      map_vector.Spill(spill_file);
+    }
+    if (param_setting.exists("checkpoint_file")) {
+      std::string file = param_setting["checkpoint_file"];
+      checkpoint_file = file;
+    }
+    if (param_setting.exists("ledger_file")) {
+      std::string file = param_setting["ledger_file"];
+      ledger_file = file;
+    }
+    if (param_setting.exists("checkpoint_interval_sec")) {
+      int interval = param_setting["checkpoint_interval_sec"];
+      checkpoint.SetInterval(interval);
+    }
+    if (param_setting.exists("checkpoint_max_age_sec")) {
+      checkpoint_max_age_sec = param_setting["checkpoint_max_age_sec"];
+    }
   } catch(const libconfig::SettingNotFoundException &nfex) {
-    printf("Setting '%s' is missing", nfex.getPath());
+    SLOG_ERROR("Setting '%s' is missing", nfex.getPath());
     exit(1);
   } catch(const libconfig::SettingTypeException &tex) {
-    printf("Setting '%s' has the wrong type", tex.getPath());
+    SLOG_ERROR("Setting '%s' has the wrong type", tex.getPath());
     exit(1);
   } catch (const std::exception& ex) {
-    printf("EXCEPTION: %s\n", ex.what());
+    SLOG_ERROR("EXCEPTION: %s\n", ex.what());
     exit(1);
   }
+  mid_stats.Reset(train_samples);
   up_diff = 0.0;
   down_diff = 0.0;
   stop_loss_up_line = 0.0;
@@ -104,13 +166,14 @@ bool SimpleArb::FillStratConfig(const libconfig::Setting& param_setting) {
 void SimpleArb::Stop() {
   CancelAll(main_ticker);
   m_ss = StrategyStatus::Stopped;
+  SLOG_INFO("[%s %s]aligned %lu, dropped %lu, repeated %lu\n", main_ticker.c_str(), hedge_ticker.c_str(), aligner.Matched(), aligner.Dropped(), aligner.Repeated());
+  DumpLatency(stdout);
+  exchange_journal.Flush();
+  ledger.Flush();
 }
 
 inline bool SimpleArb::IsAlign() {
-  if (m_shot_map[main_ticker].time.tv_sec == m_shot_map[hedge_ticker].time.tv_sec && abs(m_shot_map[main_ticker].time.tv_usec-m_shot_map[hedge_ticker].time.tv_usec) < 100000) {
-    return true;
-  }
-  return false;
+  return aligner.Aligned();
 }
 
 OrderSide::Enum SimpleArb::OpenLogicSide() {
@@ -119,10 +182,10 @@ OrderSide::Enum SimpleArb::OpenLogicSide() {
   // m_shot_map[main_ticker].Show(stdout);
   // m_shot_map[hedge_ticker].Show(stdout);
   if (mid - current_spread/2 > up_diff) {
-    printf("[%s %s]sell condition hit, as diff id %f\n",  main_ticker.c_str(), hedge_ticker.c_str(), mid);
+    SLOG_INFO("[%s %s]sell condition hit, as diff id %f\n",  main_ticker.c_str(), hedge_ticker.c_str(), mid);
     return OrderSide::Sell;
   } else if (mid + current_spread/2 < down_diff) {
-    printf("[%s %s]buy condition hit, as diff id %f\n", main_ticker.c_str(), hedge_ticker.c_str(), mid);
+    SLOG_INFO("[%s %s]buy condition hit, as diff id %f\n", main_ticker.c_str(), hedge_ticker.c_str(), mid);
     return OrderSide::Buy;
   } else {
     return OrderSide::Unknown;
@@ -130,74 +193,43 @@ OrderSide::Enum SimpleArb::OpenLogicSide() {
 }
 
 void SimpleArb::DoOperationAfterCancelled(Order* o) {
-  printf("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
+  working_orders.Remove(o);
+  SLOG_INFO("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
   if (m_cancel_map[o->ticker] > cancel_limit) {
-    printf("ticker %s hit cancel limit!\n", o->ticker);
+    SLOG_ERROR("ticker %s hit cancel limit!\n", o->ticker);
     Stop();
   }
 }
 
 double SimpleArb::OrderPrice(const std::string & ticker, OrderSide::Enum side, bool control_price) {
-  if (m_mode == StrategyMode::NextTest) {
-    // double slip = (side == OrderSide::Buy)? m_shot_map[ticker].asks[0] - m_next_shot_map[ticker].asks[0] : m_next_shot_map[ticker].bids[0] - m_shot_map[ticker].bids[0];
-    if (ticker == hedge_ticker) {
-      // printf("Slip hedge[%s] %s: %lf %lf ->> %lf %lf pnl:%lf\n", ticker.c_str(), OrderSide::ToString(side), m_shot_map[ticker].asks[0], m_shot_map[ticker].bids[0], m_next_shot_map[ticker].asks[0], m_next_shot_map[ticker].bids[0], slip);
-      return (side == OrderSide::Buy)?m_next_shot_map[ticker].asks[0]:m_next_shot_map[ticker].bids[0];
-    } else if (ticker == main_ticker) {
-      // printf("Slip main[%s] %s: %lf %lf ->> %lf %lf pnl:%lf\n", ticker.c_str(), OrderSide::ToString(side), m_shot_map[ticker].asks[0], m_shot_map[ticker].bids[0], m_next_shot_map[ticker].asks[0], m_next_shot_map[ticker].bids[0], slip);
-      // return (side == OrderSide::Buy)?m_next_shot_map[ticker].asks[0]:m_next_shot_map[ticker].bids[0];
-      return (side == OrderSide::Buy)?m_shot_map[ticker].asks[0]:m_shot_map[ticker].bids[0];
-    } else {
-      printf("error ticker %s\n", ticker.c_str());
-      return -1.0;
-    }
-  } else {
-    if (ticker == hedge_ticker) {
-      return (side == OrderSide::Buy)?m_shot_map[hedge_ticker].asks[0]:m_shot_map[hedge_ticker].bids[0];
-    } else if (ticker == main_ticker) {
-      return (side == OrderSide::Buy)?m_shot_map[main_ticker].asks[0]:m_shot_map[main_ticker].bids[0];
-    } else {
-      printf("error ticker %s\n", ticker.c_str());
-      return -1.0;
-    }
-  }
-}
-
-std::tuple<double, double> SimpleArb::CalMeanStd(const std::vector<double> & v, int head, int num) {
-  std::vector<double> cal_v(v.begin() + head, v.begin() + head + num);
-  double mean = 0.0;
-  double std = 0.0;
-  for (auto i : cal_v) {
-    mean += i;
+  Leg::Enum leg = legs.LegOf(ticker);
+  if (leg == Leg::Unknown) {
+    SLOG_ERROR("error ticker %s\n", ticker.c_str());
+    return -1.0;
   }
-  mean /= num;
-  for (auto i : cal_v) {
-    std += (i-mean) * (i-mean);
+  if (m_mode == StrategyMode::NextTest && leg == Leg::Hedge) {
+    return legs[leg].NextTake(side);
   }
-  std /= num;
-  std = sqrt(std);
-  return std::tie(mean, std);
+  return legs[leg].Take(side);
 }
 
 void SimpleArb::CalParams() {
   // int num_sample = sample_tail - sample_head;
   if (sample_tail < train_samples) {
-    printf("[%s %s]no enough mid data! tail is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), sample_tail);
+    SLOG_ERROR("[%s %s]no enough mid data! tail is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), sample_tail);
     exit(1);
   }
   param_v.clear();
-  auto r = CalMeanStd(map_vector, sample_tail - train_samples, train_samples);
-  double avg = std::get<0>(r);
-  double std = std::get<1>(r);
+  mid_stats.Resync();
+  double avg = mid_stats.Mean();
+  double std = mid_stats.Std();
   /*
   unsigned int head = map_vector.size() - train_samples;
   for (int i = 0; i < split_num; ++i) {
     param_v.push_back(std::get<0>(CalMeanStd(map_vector, head+i*train_samples/split_num, train_samples/split_num)));
   }
   */
-  FeePoint main_point = m_cw->CalFeePoint(main_ticker, GetMid(main_ticker), 1, GetMid(main_ticker), 1, no_close_today);
-  FeePoint hedge_point = m_cw->CalFeePoint(hedge_ticker, GetMid(hedge_ticker), 1, GetMid(hedge_ticker), 1, no_close_today);
-  double round_fee_cost = main_point.open_fee_point + main_point.close_fee_point + hedge_point.open_fee_point + hedge_point.close_fee_point;
+  double round_fee_cost = fees[Leg::Main].RoundTrip(legs[Leg::Main].Mid()) + fees[Leg::Hedge].RoundTrip(legs[Leg::Hedge].Mid());
   double margin = std::max(range_width * std, min_range) + round_fee_cost;
   up_diff = avg + margin;
   down_diff = avg - margin;
@@ -206,7 +238,7 @@ void SimpleArb::CalParams() {
   // down_diff = std::min(avg - range_width * std, avg-min_profit);
   mean = avg;
   spread_threshold = margin - min_profit - round_fee_cost;
-  printf("[%s %s]cal done,mean is %lf, std is %lf, parmeters: [%lf,%lf], spread_threshold is %lf, min_profit is %lf, up_loss=%lf, down_loss=%lf fee_point=%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), avg, std, down_diff, up_diff, spread_threshold, min_profit, stop_loss_up_line, stop_loss_down_line, round_fee_cost);
+  SLOG_INFO("[%s %s]cal done,mean is %lf, std is %lf, parmeters: [%lf,%lf], spread_threshold is %lf, min_profit is %lf, up_loss=%lf, down_loss=%lf fee_point=%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), avg, std, down_diff, up_diff, spread_threshold, min_profit, stop_loss_up_line, stop_loss_down_line, round_fee_cost);
   // char buffer[1024];
   // snprintf(buffer, sizeof(buffer), "CalParams %d->%d", sample_head, sample_tail);
   // tcr.EndTimer(buffer);
@@ -215,71 +247,72 @@ void SimpleArb::CalParams() {
 
 bool SimpleArb::HitMean() {
   double this_mid = GetPairMid();
-  int pos = m_position_map[main_ticker];
+  int pos = *legs[Leg::Main].pos;
   if (pos > 0 && this_mid - current_spread/2 >= mean) {  // buy position
-    printf("[%s %s] mean is %lf, this_mid is %lf, current_spread is %lf, pos is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), mean, this_mid, current_spread, pos);
+    SLOG_INFO("[%s %s] mean is %lf, this_mid is %lf, current_spread is %lf, pos is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), mean, this_mid, current_spread, pos);
     return true;
   } else if (pos < 0 && this_mid + current_spread/2 <= mean) {  // sell position
-    printf("[%s %s] mean is %lf, this_mid is %lf, current_spread is %lf, pos is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), mean, this_mid, current_spread, pos);
+    SLOG_INFO("[%s %s] mean is %lf, this_mid is %lf, current_spread is %lf, pos is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), mean, this_mid, current_spread, pos);
     return true;
   }
   return false;
 }
 
 void SimpleArb::ForceFlat() {
-  printf("%ld [%s %s]this round hit stop_loss condition, pos:%d current_mid:%lf, current_spread:%lf stoplossline %lf-%lf forceflat\n", m_shot_map[hedge_ticker].time.tv_sec, main_ticker.c_str(), hedge_ticker.c_str(), m_position_map[main_ticker], GetPairMid(), current_spread, stop_loss_down_line, stop_loss_up_line);
-  m_shot_map[main_ticker].Show(stdout);
-  m_shot_map[hedge_ticker].Show(stdout);
+  SLOG_INFO("%ld [%s %s]this round hit stop_loss condition, pos:%d current_mid:%lf, current_spread:%lf stoplossline %lf-%lf forceflat\n", legs[Leg::Hedge].shot->time.tv_sec, main_ticker.c_str(), hedge_ticker.c_str(), *legs[Leg::Main].pos, GetPairMid(), current_spread, stop_loss_down_line, stop_loss_up_line);
+  SLOG_SHOT(LogLevel::Info, *legs[Leg::Main].shot);
+  SLOG_SHOT(LogLevel::Info, *legs[Leg::Hedge].shot);
   for (int i = 0; i < max_close_try; i++) {
     if (Close(true)) {
       break;
     }
     if (i == max_close_try - 1) {
-      printf("[%s %s]try max_close times, cant close this order!\n", main_ticker.c_str(), hedge_ticker.c_str());
-      PrintMap(m_order_map);
+      SLOG_ERROR("[%s %s]try max_close times, cant close this order!\n", main_ticker.c_str(), hedge_ticker.c_str());
+      SLOG_ORDERS(LogLevel::Warn, m_order_map);
       m_order_map.clear();  // it's a temp solution, TODO
+      working_orders.Clear();
       Close();
     }
   }
 }
 
-void SimpleArb::RecordSlip(const std::string & ticker, OrderSide::Enum side, bool is_close) {
-    double slip = (side == OrderSide::Buy)? m_shot_map[ticker].asks[0] - m_next_shot_map[ticker].asks[0] : m_next_shot_map[ticker].bids[0] - m_shot_map[ticker].bids[0];
-  if (ticker == hedge_ticker) {
-    printf("Slip%s hedge[%s] %s: %lf %lf ->> %lf %lf pnl:%lf\n", is_close ? " close" : " open", ticker.c_str(), OrderSide::ToString(side), m_shot_map[ticker].asks[0], m_shot_map[ticker].bids[0], m_next_shot_map[ticker].asks[0], m_next_shot_map[ticker].bids[0], slip);
-  } else if (ticker == main_ticker) {
-    printf("Slip%s main[%s] %s: %lf %lf ->> %lf %lf pnl:%lf\n", is_close ? " close" : " open", ticker.c_str(), OrderSide::ToString(side), m_shot_map[ticker].asks[0], m_shot_map[ticker].bids[0], m_next_shot_map[ticker].asks[0], m_next_shot_map[ticker].bids[0], slip);
-  } else {
-    printf("error ticker %s\n", ticker.c_str());
-  }
+void SimpleArb::RecordSlip(Leg::Enum leg, OrderSide::Enum side, bool is_close) {
+  const MarketSnapshot & shot = *legs[leg].shot;
+  const MarketSnapshot & next_shot = *legs[leg].next_shot;
+  double slip = (side == OrderSide::Buy)? shot.asks[0] - next_shot.asks[0] : next_shot.bids[0] - shot.bids[0];
+  (is_close ? round.close_slip : round.open_slip) += slip;
+  SLOG_DEBUG("Slip%s %s[%s] %s: %lf %lf ->> %lf %lf pnl:%lf\n", is_close ? " close" : " open", leg == Leg::Hedge ? "hedge" : "main", legs[leg].ticker, OrderSide::ToString(side), shot.asks[0], shot.bids[0], next_shot.asks[0], next_shot.bids[0], slip);
 }
 
 bool SimpleArb::Close(bool force_flat) {
-  int pos = m_position_map[main_ticker];
+  int pos = *legs[Leg::Main].pos;
   if (pos == 0) {
     return true;
   }
   // OrderSide::Enum pos_side = pos > 0 ? OrderSide::Buy: OrderSide::Sell;
   OrderSide::Enum close_side = pos > 0 ? OrderSide::Sell: OrderSide::Buy;
   if (NewHigh(close_side)) {
-    printf("[%s %s]%s block orders bc new high appear!\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(close_side));
+    SLOG_WARN("[%s %s]%s block orders bc new high appear!\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(close_side));
     PrintDeque(hedge_ask);
     PrintDeque(hedge_bid);
     return true;
   }
   // double hedge_price = pos > 0 ? m_shot_map[hedge_ticker].asks[0] : m_shot_map[hedge_ticker].bids[0];
-  printf("close using %s: pos is %d, diff is %lf\n", OrderSide::ToString(close_side), pos, GetPairMid());
-  PrintMap(m_position_map);
+  SLOG_INFO("close using %s: pos is %d, diff is %lf\n", OrderSide::ToString(close_side), pos, GetPairMid());
+  SLOG_INFO("[%s %s]pos %d %d\n", main_ticker, hedge_ticker, pos, *legs[Leg::Hedge].pos);
   // printf("spread is %lf %lf min_profit is %lf\n", m_shot_map[main_ticker].asks[0]-m_shot_map[main_ticker].bids[0], m_shot_map[hedge_ticker].asks[0]-m_shot_map[hedge_ticker].bids[0], min_profit);
   if (m_order_map.empty()) {
-    PrintMap(m_avgcost_map);
-    Order* o = NewOrder(main_ticker, close_side, abs(pos), false, false, force_flat ? "force_flat_close" : "close", no_close_today);  // close
-    RecordSlip(main_ticker, o->side, true);
+    SLOG_INFO("[%s %s]avgcost %lf %lf\n", main_ticker, hedge_ticker, *legs[Leg::Main].avgcost, *legs[Leg::Hedge].avgcost);
+    OrderIntent intent(force_flat ? IntentKind::ForceFlat : IntentKind::Close, Leg::Main);
+    Order* o = NewOrder(main_ticker, close_side, abs(pos), false, false, intent.Tag(), no_close_today);  // close
+    working_orders.Add(o, intent);
+    LATENCY_RECORD(latency.tick_to_order[Leg::Main], latency.tick_stamp);
+    RecordSlip(Leg::Main, o->side, true);
     // double slip = (o->side == OrderSide::Buy)? m_shot_map[main_ticker].asks[0] - m_next_shot_map[main_ticker].asks[0] : m_next_shot_map[main_ticker].bids[0] - m_shot_map[main_ticker].bids[0];
     // printf("Slip close main[%s] %s: %lf %lf ->> %lf %lf pnl:%lf\n", main_ticker.c_str(), OrderSide::ToString(o->side), m_shot_map[main_ticker].asks[0], m_shot_map[main_ticker].bids[0], m_next_shot_map[main_ticker].asks[0], m_next_shot_map[main_ticker].bids[0], slip);
-    o->Show(stdout);
+    SLOG_ORDER(LogLevel::Info, o);
     HandleTestOrder(o);
-    target_hedge_price = (close_side == OrderSide::Buy) ? m_shot_map[hedge_ticker].bids[0] : m_shot_map[hedge_ticker].asks[0];
+    target_hedge_price = (close_side == OrderSide::Buy) ? legs[Leg::Hedge].Bid() : legs[Leg::Hedge].Ask();
     if (m_mode == StrategyMode::Real) {
       // RecordPnl(o);
       /*
@@ -292,21 +325,60 @@ bool SimpleArb::Close(bool force_flat) {
     }
     return true;
   } else {
-    printf("[%s %s]block order exsited! no close\n", main_ticker.c_str(), hedge_ticker.c_str());
-    PrintMap(m_order_map);
+    SLOG_WARN("[%s %s]block order exsited! no close\n", main_ticker.c_str(), hedge_ticker.c_str());
+    SLOG_ORDERS(LogLevel::Warn, m_order_map);
     return false;
   }
 }
 
+void SimpleArb::GetBands(double* bands) const {
+  bands[0] = mean;
+  bands[1] = up_diff;
+  bands[2] = down_diff;
+  bands[3] = stop_loss_up_line;
+  bands[4] = stop_loss_down_line;
+  bands[5] = spread_threshold;
+}
+
+void SimpleArb::Checkpoint(int64_t now_sec) {
+  RollingStats* series[1] = {&mid_stats};
+  double bands[kBands];
+  if (!checkpoint_tried) {
+    checkpoint_tried = true;
+    size_t n = checkpoint.Restore(now_sec, checkpoint_max_age_sec, series, bands);
+    if (n > 0) {
+      mean = bands[0];
+      up_diff = bands[1];
+      down_diff = bands[2];
+      stop_loss_up_line = bands[3];
+      stop_loss_down_line = bands[4];
+      spread_threshold = bands[5];
+      const RingBuffer<double> & w = mid_stats.Samples();
+      for (size_t i = 0; i < w.size(); i++) {
+        map_vector.push_back(w[i]);
+      }
+      // a full window was calibrated when saved: put the count one past
+      // where Ready() calibrates, so the restored bands are the current ones
+      sample_tail = n;
+      sample_head = (static_cast<int>(n) >= train_samples) ? sample_tail - train_samples - 1 : 0;
+      SLOG_INFO("[%s %s]warm start from checkpoint, %zu samples\n", main_ticker.c_str(), hedge_ticker.c_str(), n);
+    }
+  }
+  if (checkpoint.Due(now_sec)) {
+    GetBands(bands);
+    checkpoint.Save(now_sec, series, bands);
+  }
+}
+
 double SimpleArb::GetPairMid() {
-  return GetMid(main_ticker) - GetMid(hedge_ticker);
+  return legs.MidDiff();
 }
 
 void SimpleArb::StopLossLogic() {
   if (!Spread_Good()) {
     return;
   }
-  int pos = m_position_map[main_ticker];
+  int pos = *legs[Leg::Main].pos;
   double this_mid = GetPairMid();
   if (pos > 0) {  // buy position
     if (this_mid < stop_loss_down_line) {  // stop condition meets
@@ -321,19 +393,19 @@ void SimpleArb::StopLossLogic() {
   }
   if (stop_loss_times >= max_loss_times) {
     m_ss = StrategyStatus::Stopped;
-    printf("stop loss times hit max!\n");
+    SLOG_ERROR("stop loss times hit max!\n");
   }
 }
 
 void SimpleArb::CloseLogic() {
   StopLossLogic();
-  int pos = m_position_map[main_ticker];
+  int pos = *legs[Leg::Main].pos;
   if (pos == 0) {
     return;
   }
 
   if (TimeUp()) {
-    printf("[%s %s] holding time up, start from %ld, now is %ld, max_hold is %d close diff is %lf force to close position!\n", main_ticker.c_str(), hedge_ticker.c_str(), m_build_position_time, m_mode != StrategyMode::Real ? m_shot_map[main_ticker].time.tv_sec : m_tc->CurrentInt(), m_max_holding_sec, GetPairMid());
+    SLOG_INFO("[%s %s] holding time up, start from %ld, now is %ld, max_hold is %d close diff is %lf force to close position!\n", main_ticker.c_str(), hedge_ticker.c_str(), m_build_position_time, m_mode != StrategyMode::Real ? legs[Leg::Main].shot->time.tv_sec : m_tc->CurrentInt(), m_max_holding_sec, GetPairMid());
     ForceFlat();
     return;
   }
@@ -353,7 +425,7 @@ void SimpleArb::Flatting() {
 bool SimpleArb::NewHigh(OrderSide::Enum side) {
   return false;
   if (hedge_bid.size() < 6) {
-    printf("no enough data in deque\n");
+    SLOG_ERROR("no enough data in deque\n");
     return true;
   }
   if (side == OrderSide::Buy) {  // main side buy, hedgeside sell, should be bid
@@ -384,24 +456,31 @@ bool SimpleArb::NewHigh(OrderSide::Enum side) {
 
 void SimpleArb::Open(OrderSide::Enum side) {
   if (NewHigh(side)) {
-    printf("[%s %s]%s block orders bc new high appear!\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(side));
+    SLOG_WARN("[%s %s]%s block orders bc new high appear!\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(side));
     PrintDeque(hedge_ask);
     PrintDeque(hedge_bid);
     return;
   }
-  int pos = m_position_map[main_ticker];
-  printf("[%s %s] open %s: pos is %d, diff is %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(side), pos, GetPairMid());
+  int pos = *legs[Leg::Main].pos;
+  SLOG_INFO("[%s %s] open %s: pos is %d, diff is %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(side), pos, GetPairMid());
   if (m_order_map.empty()) {  // no block order, can add open
-    Order* o = NewOrder(main_ticker, side, 1, false, false, "open", no_close_today);
-    RecordSlip(main_ticker, o->side);
-    o->Show(stdout);
+    if (pos == 0) {
+      round = TradeRound();
+      round.open_usec = static_cast<int64_t>(m_last_shot.time.tv_sec) * 1000000 + m_last_shot.time.tv_usec;
+    }
+    OrderIntent intent(IntentKind::Open, Leg::Main);
+    Order* o = NewOrder(main_ticker, side, 1, false, false, intent.Tag(), no_close_today);
+    working_orders.Add(o, intent);
+    LATENCY_RECORD(latency.tick_to_order[Leg::Main], latency.tick_stamp);
+    RecordSlip(Leg::Main, o->side);
+    SLOG_ORDER(LogLevel::Info, o);
     // printf("spread is %lf %lf min_profit is %lf, next open will be %lf\n", m_shot_map[main_ticker].asks[0]-m_shot_map[main_ticker].bids[0], m_shot_map[hedge_ticker].asks[0]-m_shot_map[hedge_ticker].bids[0], min_profit, side == OrderSide::Buy ? down_diff: up_diff);
     HandleTestOrder(o);
-    target_hedge_price = (side == OrderSide::Buy) ? m_shot_map[hedge_ticker].bids[0] : m_shot_map[hedge_ticker].asks[0];
+    target_hedge_price = (side == OrderSide::Buy) ? legs[Leg::Hedge].Bid() : legs[Leg::Hedge].Ask();
     sample_head = sample_tail;
   } else {  // block order exsit, no open, possible reason: no enough margin
-    printf("block order exsited! no open \n");
-    PrintMap(m_order_map);
+    SLOG_WARN("block order exsited! no open \n");
+    SLOG_ORDERS(LogLevel::Warn, m_order_map);
     // exit(1);
   }
 }
@@ -412,7 +491,7 @@ bool SimpleArb::OpenLogic() {
     return false;
   }
   // do meet the logic
-  int pos = m_position_map[main_ticker];
+  int pos = *legs[Leg::Main].pos;
   if (abs(pos) == max_pos) {
     // hit max, still update bound
     // UpdateBound(side == OrderSide::Buy ? OrderSide::Sell : OrderSide::Buy);
@@ -432,8 +511,13 @@ void SimpleArb::Run() {
 }
 
 void SimpleArb::DoOperationAfterUpdateData(const MarketSnapshot& shot) {
-  mid_map[shot.ticker] = (shot.bids[0]+shot.asks[0]) / 2;  // mid_map saved the newest mid, no matter it is aligned or not
-  if (strcmp(shot.ticker, hedge_ticker.c_str()) == 0) {
+  LATENCY_STAMP(latency.tick_stamp);
+  if (checkpoint.IsOpen()) {
+    Checkpoint(shot.time.tv_sec);
+  }
+  Leg::Enum leg = legs.OnShot(shot, routed_id_);
+  aligner.Update(leg, shot.time);
+  if (leg == Leg::Hedge) {
     hedge_ask.push_back(shot.asks[0]);
     hedge_bid.push_back(shot.bids[0]);
     if (hedge_ask.size() > 8) {
@@ -441,48 +525,50 @@ void SimpleArb::DoOperationAfterUpdateData(const MarketSnapshot& shot) {
       hedge_bid.pop_front();
     }
   }
-  current_spread = m_shot_map[main_ticker].asks[0] - m_shot_map[main_ticker].bids[0] + m_shot_map[hedge_ticker].asks[0] - m_shot_map[hedge_ticker].bids[0];
+  current_spread = legs.SpreadSum();
   if (IsAlign()) {
     double mid = GetPairMid();
-    map_vector.emplace_back(mid);  // map_vector saved the aligned mid, all the elements here are safe to trade
+    map_vector.push_back(mid);  // map_vector saved the aligned mid, all the elements here are safe to trade
+    mid_stats.Add(mid);
     int num_sample = ++sample_tail - sample_head;
     if (num_sample > train_samples && num_sample % (train_samples) == 1) {
       CalParams();
     }
     // if (m_mode == StrategyMode::Real) {
-      printf("%ld [%s, %s]mid_diff is %lf\n", shot.time.tv_sec, main_ticker.c_str(), hedge_ticker.c_str(), mid_map[main_ticker]-mid_map[hedge_ticker]);
+      SLOG_DEBUG("%ld [%s, %s]mid_diff is %lf\n", shot.time.tv_sec, main_ticker.c_str(), hedge_ticker.c_str(), mid);
     // }
-    if (m_ss == StrategyStatus::Training) {
+    if (m_ss == StrategyStatus::Training && num_sample < train_samples) {  // not over restored bands
       mean = down_diff = up_diff = stop_loss_down_line = stop_loss_up_line = mid;
     }
-    MarketSnapshot shot;
-    snprintf(shot.ticker, sizeof(shot.ticker), "['%s', '%s']", main_ticker.c_str(), hedge_ticker.c_str());
-    shot.time = m_shot_map[hedge_ticker].time;
-    shot.bids[0] = down_diff - current_spread/2;
-    shot.bids[1] = stop_loss_down_line;
-    shot.bids[2] = mean - current_spread/2;
-    shot.asks[0] = up_diff + current_spread/2;
-    shot.asks[1] = stop_loss_up_line;
-    shot.asks[2] = mean + current_spread/2;
-    shot.bids[3] = m_shot_map[main_ticker].bids[0];
-    shot.asks[3] = m_shot_map[main_ticker].asks[0];
-    shot.bids[4] = m_shot_map[hedge_ticker].bids[0];
-    shot.asks[4] = m_shot_map[hedge_ticker].asks[0];
-    shot.bid_sizes[3] = m_shot_map[main_ticker].bid_sizes[0];
-    shot.ask_sizes[3] = m_shot_map[main_ticker].ask_sizes[0];
-    shot.bid_sizes[4] = m_shot_map[hedge_ticker].bid_sizes[0];
-    shot.ask_sizes[4] = m_shot_map[hedge_ticker].ask_sizes[0];
-    shot.open_interest = mean;
-    std::string label = main_ticker + '|' + hedge_ticker;
-    snprintf(shot.ticker, sizeof(shot.ticker), "%s", label.c_str());
-    shot.last_trade = mid;
-    m_ui_sender->Send(shot);
+    const L1Quote & main_quote = *legs[Leg::Main].quote;
+    const L1Quote & hedge_quote = *legs[Leg::Hedge].quote;
+    BandState band;
+    band.time = hedge_quote.time;
+    band.mid = mid;
+    band.mean = mean;
+    band.spread = current_spread;
+    band.down = down_diff;
+    band.up = up_diff;
+    band.stop_loss_down = stop_loss_down_line;
+    band.stop_loss_up = stop_loss_up_line;
+    band.main_bid = main_quote.bid;
+    band.main_ask = main_quote.ask;
+    band.hedge_bid = hedge_quote.bid;
+    band.hedge_ask = hedge_quote.ask;
+    band.main_bid_size = main_quote.bid_size;
+    band.main_ask_size = main_quote.ask_size;
+    band.hedge_bid_size = hedge_quote.bid_size;
+    band.hedge_ask_size = hedge_quote.ask_size;
+    ui_channel.Post(band);
   }
 }
 
 void SimpleArb::HandleCommand(const Command& shot) {
-  printf("received command!\n");
-  shot.Show(stdout);
+  if (strcmp(shot.ticker, "latency") == 0) {
+    DumpLatency(stdout);
+    return;
+  }
+  SLOG_INFO("received command! %lf %lf %lf %lf\n", shot.vdouble[0], shot.vdouble[1], shot.vdouble[2], shot.vdouble[3]);
   if (abs(shot.vdouble[0]) > MIN_DOUBLE_DIFF) {
     up_diff = shot.vdouble[0];
     return;
@@ -513,7 +599,7 @@ void SimpleArb::Resume() {
 
 bool SimpleArb::Ready() {
   int num_sample = sample_tail - sample_head;
-  if (m_position_ready && m_shot_map[main_ticker].IsGood() && m_shot_map[hedge_ticker].IsGood() && num_sample >= train_samples) {
+  if (m_position_ready && legs[Leg::Main].shot->IsGood() && legs[Leg::Hedge].shot->IsGood() && num_sample >= train_samples) {
     if (num_sample == train_samples) {
       // first cal params
       CalParams();
@@ -521,7 +607,7 @@ bool SimpleArb::Ready() {
     return true;
   }
   if (!m_position_ready) {
-    printf("waiting position query finish!\n");
+    SLOG_WARN("waiting position query finish!\n");
   }
   return false;
 }
@@ -529,23 +615,27 @@ bool SimpleArb::Ready() {
 void SimpleArb::ModerateOrders(const std::string & ticker) {
   // just make sure the order filled
   if (m_mode == StrategyMode::Real) {
-    for (auto m : m_order_map) {
-      Order* o = m.second;
+    working_orders.Sync(m_order_map, legs);
+    Order* working[OrderIndex::kCapacity];
+    int n_main = working_orders.Collect(Leg::Main, working);
+    int n = n_main + working_orders.Collect(Leg::Hedge, working + n_main);
+    for (int i = 0; i < n; i++) {
+      Order* o = working[i];
       if (o->Valid()) {
-        std::string ticker = o->ticker;
-        MarketSnapshot shot = m_shot_map[ticker];
-        double reasonable_price = (o->side == OrderSide::Buy ? shot.asks[0] : shot.bids[0]);
+        Leg::Enum leg = i < n_main ? Leg::Main : Leg::Hedge;
+        double reasonable_price = legs[leg].Take(o->side);
         bool is_price_move = (fabs(reasonable_price - o->price) >= min_price_move/2);
         if (!is_price_move) {
           continue;
         }
-        if (ticker == main_ticker) {
-          if ((o->side == OrderSide::Buy && m_shot_map[hedge_ticker].bids[0] - this->target_hedge_price < -1e-4) ||
-          (o->side == OrderSide::Sell && m_shot_map[hedge_ticker].asks[0] - this->target_hedge_price > -1e-4) ) {
-            printf("[%s %s]target hedge price is %s@%lf, now is %lf %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(o->side), target_hedge_price, m_shot_map[hedge_ticker].bids[0], m_shot_map[hedge_ticker].asks[0]);
+        const LegState & hedge = legs[Leg::Hedge];
+        if (leg == Leg::Main) {
+          if ((o->side == OrderSide::Buy && hedge.Bid() - this->target_hedge_price < -1e-4) ||
+          (o->side == OrderSide::Sell && hedge.Ask() - this->target_hedge_price > -1e-4) ) {
+            SLOG_INFO("[%s %s]target hedge price is %s@%lf, now is %lf %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(o->side), target_hedge_price, hedge.Bid(), hedge.Ask());
             CancelOrder(o);
           }
-        } else if (ticker == hedge_ticker) {
+        } else {
           // printf("[%s %s]Slip point for :modify %s order %s: %lf->%lf mpv=%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), OrderSide::ToString(o->side), o->order_ref, o->price, reasonable_price, min_price_move);
           /*
           if (m_shot_map[hedge_ticker].time.tv_sec - o->shot_time.tv_sec >= 3) {
@@ -555,8 +645,7 @@ void SimpleArb::ModerateOrders(const std::string & ticker) {
           }
           */
           ModOrder(o);
-        } else {
-          continue;
+          LATENCY_RECORD(latency.tick_to_order[Leg::Hedge], latency.tick_stamp);
         }
       }
     }
@@ -566,11 +655,22 @@ void SimpleArb::ModerateOrders(const std::string & ticker) {
 void SimpleArb::ClearPositionRecord() {
   m_avgcost_map.clear();
   m_position_map.clear();
+  legs.BindPosition(&m_position_map, &m_avgcost_map);
+}
+
+void SimpleArb::UpdateData(TickerId id, const MarketSnapshot & shot) {
+  routed_id_ = id;
+  BaseStrategy::UpdateData(shot);
+  routed_id_ = kNoTicker;
 }
 
 void SimpleArb::Start() {
   if (!is_started) {
+    AsyncLogger::Instance().Register();  // the log ring, before the first tick
     ClearPositionRecord();
+    // buckets for every order working_orders can hold, so the backend's
+    // inserts never rehash on the order path
+    m_order_map.reserve(OrderIndex::kCapacity);
     is_started = true;
   }
   Run();
@@ -580,8 +680,8 @@ void SimpleArb::DoOperationAfterUpdatePos(Order* o, const ExchangeInfo& info) {
 }
 
 void SimpleArb::UpdateBound(OrderSide::Enum side) {
-  printf("Entering UpdateBound\n");
-  int pos = m_position_map[main_ticker];
+  SLOG_INFO("Entering UpdateBound\n");
+  int pos = *legs[Leg::Main].pos;
   if (pos == 0) {  // close operation filled, no update bound
     return;
   }
@@ -600,7 +700,7 @@ void SimpleArb::UpdateBound(OrderSide::Enum side) {
       stop_loss_up_line += increment/2;
     }
   }
-  printf("spread is %lf %lf min_profit is %lf, next open will be %lf mean is %lf\n", m_shot_map[main_ticker].asks[0]-m_shot_map[main_ticker].bids[0], m_shot_map[hedge_ticker].asks[0]-m_shot_map[hedge_ticker].bids[0], min_profit, side == OrderSide::Sell ? down_diff: up_diff, mean);
+  SLOG_INFO("spread is %lf %lf min_profit is %lf, next open will be %lf mean is %lf\n", legs[Leg::Main].Spread(), legs[Leg::Hedge].Spread(), min_profit, side == OrderSide::Sell ? down_diff: up_diff, mean);
 }
 
 void SimpleArb::HandleTestOrder(Order* o) {
@@ -608,29 +708,19 @@ void SimpleArb::HandleTestOrder(Order* o) {
     return;
   }
   ExchangeInfo info;
-  info.shot_time = o->shot_time;
-  info.show_time = o->shot_time;
-  info.type = InfoType::Filled;
-  info.trade_size = o->size;
-  info.trade_price = o->price;
-  info.side = o->side;
-  snprintf(info.order_ref, sizeof(info.order_ref), "%s", o->order_ref);
-  snprintf(info.ticker, sizeof(info.ticker), "%s", o->ticker);
-  snprintf(info.reason, sizeof(info.reason), "%s", "test");
+  MakeTestFill(*o, &info);
   // m_position_map[o->ticker] += o->side == OrderSide::Buy ? o->size : -o->size;
-  exchange_file->write(reinterpret_cast<char*>(&info), sizeof(info));
-  exchange_file->flush();
+  exchange_journal.Append(info);
   // info.Show(stdout);
   UpdatePos(o, info);
   // m_order_map.clear();
-  PrintMap(m_position_map);
-  PrintMap(m_avgcost_map);
+  SLOG_DEBUG("[%s %s]pos %d %d, avgcost %lf %lf\n", main_ticker, hedge_ticker, *legs[Leg::Main].pos, *legs[Leg::Hedge].pos, *legs[Leg::Main].avgcost, *legs[Leg::Hedge].avgcost);
   DoOperationAfterFilled(o, info);
 }
 
 
 void SimpleArb::UpdateBuildPosTime() {
-  int hedge_pos = m_position_map[hedge_ticker];
+  int hedge_pos = *legs[Leg::Hedge].pos;
   if (hedge_pos == 0) {  // closed all position, reinitialize build_position_time
     m_build_position_time = MAX_UNIX_TIME;
   } else if (hedge_pos == 1) {  // position 0->1, record build_time
@@ -642,26 +732,44 @@ void SimpleArb::RecordPnl(Order* o, bool force_flat) {
   int pos = o->size;
   OrderSide::Enum pos_side = o->side == OrderSide::Sell ? OrderSide::Buy: OrderSide::Sell;
   OrderSide::Enum close_side = o->side;
-  double hedge_price = pos > 0 ? m_shot_map[hedge_ticker].asks[0] : m_shot_map[hedge_ticker].bids[0];
+  double hedge_price = pos > 0 ? legs[Leg::Hedge].Ask() : legs[Leg::Hedge].Bid();
   // cout << "main pnl param:" << main_ticker <<" " <<  m_avgcost_map[main_ticker]<< " " <<  abs(pos) << " " << o->price << " " << abs(pos) << endl;
   // cout << "hedge pnl param:" << hedge_ticker <<" " <<  m_avgcost_map[hedge_ticker]<< " " <<  abs(pos) << " " << hedge_price << " " << abs(pos) << endl;
-  double this_round_pnl = m_cw->CalNetPnl(main_ticker, m_avgcost_map[main_ticker], abs(pos), o->price, abs(pos), close_side, no_close_today) + m_cw->CalNetPnl(hedge_ticker, m_avgcost_map[hedge_ticker], abs(pos), hedge_price, abs(pos), pos_side, no_close_today);
+  double this_round_pnl = m_cw->CalNetPnl(main_ticker, *legs[Leg::Main].avgcost, abs(pos), o->price, abs(pos), close_side, no_close_today) + m_cw->CalNetPnl(hedge_ticker, *legs[Leg::Hedge].avgcost, abs(pos), hedge_price, abs(pos), pos_side, no_close_today);
+  run_stats.pnl += this_round_pnl;
   /*
   Fee main_fee = m_cal.CalFee(main_ticker, m_avgcost_map[main_ticker], abs(pos), m_shot_map[main_ticker].  bids[0], abs(pos), no_close_today);
   Fee hedge_fee = m_cal.CalFee(hedge_ticker, m_avgcost_map[hedge_ticker], abs(pos), hedge_price, abs(pos), no_close_today);
   double this_round_fee = main_fee.open_fee + main_fee.close_fee + hedge_fee.open_fee + hedge_fee.close_fee;
   */
-  std::string str = GetCon(main_ticker);
-  std::string split_c = ",";
-  char buffer[32];
-  snprintf(buffer, sizeof(buffer), "%lf", this_round_pnl);
-  str += split_c + buffer;
-  for (auto i : param_v) {
-    snprintf(buffer, sizeof(buffer), "%lf", i);
-    str += split_c + buffer;
+  // same line as before the ledger: contract, pnl, then the calibration params
+  char split[128] = "";
+  int len = 0;
+  for (size_t i = 0; i < param_v.size() && len < static_cast<int>(sizeof(split)); i++) {
+    len += snprintf(split + len, sizeof(split) - len, ",%lf", param_v[i]);
+  }
+  SLOG_INFO("recordpnl,%s,%lf%s\n", GetCon(main_ticker), this_round_pnl, split);
+  if (ledger_book < 0) {
+    return;
   }
-  str += "\n";
-  cout << "recordpnl," << str;
+  round.close_usec = static_cast<int64_t>(m_last_shot.time.tv_sec) * 1000000 + m_last_shot.time.tv_usec;
+  round.size = abs(pos);
+  round.dir = close_side == OrderSide::Sell ? 1 : -1;
+  round.forced = force_flat;
+  round.main_open = *legs[Leg::Main].avgcost;
+  round.main_close = o->price;
+  round.hedge_open = *legs[Leg::Hedge].avgcost;
+  round.hedge_close = hedge_price;
+  round.fee_points = (fees[Leg::Main].RoundTrip(o->price) + fees[Leg::Hedge].RoundTrip(hedge_price)) * abs(pos);
+  round.pnl = this_round_pnl;
+  round.mean = mean;
+  round.up = up_diff;
+  round.down = down_diff;
+  round.stop_up = stop_loss_up_line;
+  round.stop_down = stop_loss_down_line;
+  round.spread_threshold = spread_threshold;
+  const double params[] = {range_width, min_profit, min_range, increment, stop_loss_margin};
+  ledger.Append(ledger_book, round, params);
   /*
   printf("%ld [%s %s]%sThis round close pnl: %lf, fee_cost: %lf pos is %d, holding second is %ld, param is ", m_shot_map[hedge_ticker].time.tv_sec, main_ticker.c_str(), hedge_ticker.c_str(), force_flat ? "[Time up] " : "", this_round_pnl, this_round_fee, pos, m_shot_map[hedge_ticker].time.tv_sec - build_position_time);
   for (auto i : param_v) {
@@ -672,26 +780,32 @@ void SimpleArb::RecordPnl(Order* o, bool force_flat) {
 }
 
 void SimpleArb::DoOperationAfterFilled(Order* o, const ExchangeInfo& info) {
-  if (strcmp(o->ticker, main_ticker.c_str()) == 0) {
+  LATENCY_STAMP(latency.fill_stamp);
+  Leg::Enum leg = legs.LegOf(o->ticker);
+  run_stats.fills++;
+  OrderIntent intent = working_orders.Fill(o, info, leg);
+  if (leg == Leg::Main) {
     // get hedged right now
-    std::string a = o->tbd;
-    if (a.find("close") != string::npos) {
+    OrderSide::Enum hedge_side = (o->side == OrderSide::Buy) ? OrderSide::Sell : OrderSide::Buy;
+    OrderIntent hedge = intent.Hedge();
+    Order* order = NewOrder(hedge_ticker, hedge_side, info.trade_size, false, false, hedge.Tag(), no_close_today);
+    working_orders.Add(order, hedge);
+    LATENCY_RECORD(latency.fill_to_hedge, latency.fill_stamp);
+    // bookkeeping once the hedge is out, before a test fill moves the hedge cost
+    RecordSlip(Leg::Hedge, hedge_side, intent.Closes());  // before RecordPnl closes the round
+    if (intent.Closes()) {
       close_round++;
-      RecordPnl(o);
+      run_stats.rounds++;
+      RecordPnl(o, intent.Kind() == IntentKind::ForceFlat);
       CalParams();
-    } else {
     }
-    // std::string oc = (m_position_map[hedge_ticker] == 0 ? "open" : "close");
-    OrderSide::Enum hedge_side = (o->side == OrderSide::Buy) ? OrderSide::Sell : OrderSide::Buy;
-    Order* order = NewOrder(hedge_ticker, hedge_side, info.trade_size, false, false, o->tbd, no_close_today);
-    RecordSlip(hedge_ticker, hedge_side, a.find("close") != string::npos);
     HandleTestOrder(order);
-    order->Show(stdout);
-  } else if (strcmp(o->ticker, hedge_ticker.c_str()) == 0) {
+    SLOG_ORDER(LogLevel::Info, order);
+  } else if (leg == Leg::Hedge) {
     UpdateBuildPosTime();
     UpdateBound(o->side);
   } else {
-    printf("o->ticker=%s, main:%s, hedge:%s\n", o->ticker, main_ticker.c_str(), hedge_ticker.c_str());
+    SLOG_INFO("o->ticker=%s, main:%s, hedge:%s\n", o->ticker, main_ticker.c_str(), hedge_ticker.c_str());
     SimpleHandle(322);
   }
 }
@@ -20,15 +20,33 @@
 #include "struct/command.h"
 #include "struct/exchange_info.h"
 #include "struct/order_status.h"
+#include "struct/pair_state.h"
+#include "struct/order_index.h"
+#include "struct/order_intent.h"
+#include "struct/test_fill.h"
+#include "struct/run_stats.h"
 #include "util/time_controller.h"
 #include "util/zmq_sender.hpp"
 #include "util/dater.h"
 #include "util/history_worker.h"
 #include "util/contract_worker.h"
 #include "util/common_tools.h"
+#include "util/ring_buffer.h"
+#include "util/rolling_stats.h"
+#include "util/record_journal.h"
+#include "util/as_of_aligner.h"
+#include "util/fee_point_cache.h"
+#include "util/state_checkpoint.h"
+#include "util/band_channel.h"
+#include "util/latency_histogram.h"
+#include "util/trade_ledger.h"
+#include "util/strat_log.h"
 #include "core/base_strategy.h"
+#include "core/routed_strategy.h"
 
-class SimpleArb: public BaseStrategy {
+// the legs are main_ticker/hedge_ticker if both are set, otherwise the
+// two most traded contracts of unique_name in the history file
+class SimpleArb: public BaseStrategy, public RoutedStrategy {
  public:
   explicit SimpleArb(const libconfig::Setting & param_setting, std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender, TimeController* tc, ContractWorker* cw, HistoryWorker* hw, const std::string & date, StrategyMode::Enum mode = StrategyMode::Real, std::ofstream* exchange_file = nullptr);
   ~SimpleArb();
@@ -36,10 +54,28 @@ class SimpleArb: public BaseStrategy {
   void Start() override;
   void Stop() override;
 
+  using BaseStrategy::UpdateData;
+  void UpdateData(TickerId id, const MarketSnapshot & shot) override;
+
   // void Clear() override;
   void HandleCommand(const Command& shot) override;
   // void UpdateTicker() override;
+
+  const RunStats & Stats() const {
+    return run_stats;
+  }
+
+  // empty unless built with STRAT_LATENCY
+  void DumpLatency(FILE* f) const {
+    latency.Dump(f, m_strat_name);
+  }
+
+  // mean, up/down, stop loss up/down and spread threshold, as checkpointed
+  static const int kBands = 6;
+  void GetBands(double* bands) const;
  private:
+  friend class StrategyBench;  // bench/ times the callbacks one by one
+
   bool FillStratConfig(const libconfig::Setting& param_setting);
   void RunningSetup(std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender);
   void ClearPositionRecord();
@@ -67,11 +103,12 @@ class SimpleArb: public BaseStrategy {
   void Open(OrderSide::Enum side);
   bool Close(bool force_flat = false);
 
-  void RecordSlip(const std::string & ticker, OrderSide::Enum side, bool is_close = false);
+  void RecordSlip(Leg::Enum leg, OrderSide::Enum side, bool is_close = false);
   void RecordPnl(Order* o, bool force_flat = false);
 
   void CalParams();
-  std::tuple<double, double> CalMeanStd(const std::vector<double> & v, int head, int num);
+  // restore on the first tick, then save every checkpoint interval
+  void Checkpoint(int64_t now_sec);
   bool HitMean();
 
   double GetPairMid();
@@ -90,17 +127,21 @@ class SimpleArb: public BaseStrategy {
   char order_ref[MAX_ORDERREF_SIZE];
   std::string main_ticker;
   std::string hedge_ticker;
+  PairState legs;
+  OrderIndex working_orders;  // m_order_map by leg and side
+  AsOfAligner aligner;
+  FeePointCache fees[2];  // per leg
   int max_pos;
   double min_price_move;
 
   // std::unordered_map<std::string, std::vector<BaseStrategy*> >*tsm;
   int cancel_limit;
-  std::unordered_map<std::string, double> mid_map;
   double up_diff;
   double down_diff;
   double range_width;
   double mean;
-  std::vector<double> map_vector;
+  RingBuffer<double> map_vector;
+  RollingStats mid_stats;
   int current_pos;
   double min_profit;
   int train_samples;
@@ -123,11 +164,24 @@ class SimpleArb: public BaseStrategy {
   // int close_count;
   int max_round;
   int close_round;
+  RunStats run_stats;
+  PairLatency latency;
   int split_num;
   std::vector<double> param_v;
   int sample_head;
   int sample_tail;
+  double ui_publish_hz;
+  int checkpoint_max_age_sec;
+  bool checkpoint_tried;
   std::ofstream* exchange_file;
+  RecordJournal exchange_journal;  // batches the test fills written to exchange_file
+  BandChannel ui_channel;  // bands go out from the publisher thread, never from here
+  std::string checkpoint_file;
+  StateCheckpoint checkpoint;  // mid_stats window and bands, for a warm start
+  std::string ledger_file;
+  TradeLedger ledger;
+  int ledger_book;
+  TradeRound round;  // the round trip being built, goes to ledger on the close
   double target_hedge_price;
   std::deque<double>  hedge_ask;
   std::deque<double> hedge_bid;
@@ -17,8 +17,14 @@ SimpleMaker::SimpleMaker(const std::string & main_ticker, const std::string & he
     up_diff(25),
     down_diff(-64),
     max_spread(2*min_price),
-    min_train_sample(60) {
+    min_train_sample(60),
+    aligner(10000),
+    checkpoint_max_age_sec(600),
+    checkpoint_tried(false) {
   max_pos = start_pos;
+  leg_mid[Leg::Main] = leg_mid[Leg::Hedge] = 0.0;
+  map_vector.Reset(min_train_sample);
+  mid_stats.Reset(min_train_sample);
   std::string orderfile_name = strat_name + "_order.txt";
   std::string exchangefile_name = strat_name + "_exchange.txt";
   (*ticker_strat_map)[main_ticker].emplace_back(this);
@@ -32,9 +38,19 @@ SimpleMaker::SimpleMaker(const std::string & main_ticker, const std::string & he
   m_shot_map[hedge_ticker] = shot;
   m_avgcost_map[main_ticker] = 0.0;
   m_avgcost_map[hedge_ticker] = 0.0;
+  legs.Bind(main_ticker, hedge_ticker, &m_shot_map, &m_next_shot_map, &m_position_map, &m_avgcost_map);
 }
 
 SimpleMaker::~SimpleMaker() {
+  pthread_mutex_destroy(&add_size_mutex);
+}
+
+void SimpleMaker::Attach(BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender, ContractWorker* cw, StrategyMode::Enum mode, std::ofstream* exchange_file) {
+  m_ui_sender = uisender;
+  m_order_sender = ordersender;
+  m_tc = &this_tc;
+  m_cw = cw;
+  SetStrategyMode(mode, exchange_file);
 }
 
 void SimpleMaker::Stop() {
@@ -47,46 +63,45 @@ void SimpleMaker::Flatting() {
 }
 
 bool SimpleMaker::IsHedged() {
-  int main_pos = m_position_map[main_ticker];
-  int hedge_pos = m_position_map[hedge_ticker];
+  int main_pos = *legs[Leg::Main].pos;
+  int hedge_pos = *legs[Leg::Hedge].pos;
   return (main_pos == -hedge_pos);
 }
 
 bool SimpleMaker::MidSell() {
-  if (mid_map[main_ticker] - mid_map[hedge_ticker] < down_diff) {
-    printf("[%s %s]midsell hit, as diff id %f\n", main_ticker.c_str(), hedge_ticker.c_str(), mid_map[main_ticker] - mid_map[hedge_ticker]);
+  if (leg_mid[Leg::Main] - leg_mid[Leg::Hedge] < down_diff) {
+    SLOG_INFO("[%s %s]midsell hit, as diff id %f\n", main_ticker.c_str(), hedge_ticker.c_str(), leg_mid[Leg::Main] - leg_mid[Leg::Hedge]);
     return false;
   }
   return true;
 }
 
 bool SimpleMaker::IsAlign() {
-  if (m_shot_map[main_ticker].time.tv_sec == m_shot_map[hedge_ticker].time.tv_sec && abs(m_shot_map[main_ticker].time.tv_usec-m_shot_map[hedge_ticker].time.tv_usec) < 10000) {
-    return true;
-  }
-  return false;
+  return aligner.Aligned();
 }
 
 bool SimpleMaker::MidBuy() {
-  if (mid_map[main_ticker] - mid_map[hedge_ticker] > up_diff) {
-    printf("[%s %s]midbuy hit, as diff id %f\n", main_ticker.c_str(), hedge_ticker.c_str(), mid_map[main_ticker] - mid_map[hedge_ticker]);
+  if (leg_mid[Leg::Main] - leg_mid[Leg::Hedge] > up_diff) {
+    SLOG_INFO("[%s %s]midbuy hit, as diff id %f\n", main_ticker.c_str(), hedge_ticker.c_str(), leg_mid[Leg::Main] - leg_mid[Leg::Hedge]);
     return false;
   }
   return true;
 }
 
 double SimpleMaker::CalBalancePrice() {
-  int netpos = m_position_map[main_ticker];
+  const LegState & main_leg = legs[Leg::Main];
+  const LegState & hedge_leg = legs[Leg::Hedge];
+  int netpos = *main_leg.pos;
   double balance_price = -1.0;
   if (netpos > 0) {  // buy pos, sell close order
-    balance_price = PriceCorrector(m_shot_map[hedge_ticker].asks[0]+m_avgcost_map[main_ticker]-m_avgcost_map[hedge_ticker], min_price, true);
+    balance_price = PriceCorrector(hedge_leg.Ask()+*main_leg.avgcost-*hedge_leg.avgcost, min_price, true);
   } else if (netpos < 0) {
-    balance_price = PriceCorrector(m_shot_map[hedge_ticker].bids[0]+m_avgcost_map[main_ticker]-m_avgcost_map[hedge_ticker], min_price);
+    balance_price = PriceCorrector(hedge_leg.Bid()+*main_leg.avgcost-*hedge_leg.avgcost, min_price);
   } else {
-    printf("pos is 0 when calbalance price!\n");
+    SLOG_INFO("pos is 0 when calbalance price!\n");
     exit(1);
   }
-  printf("[%s %s]Caling balance price: avg[main]=%lf avg[hedge]=%lf hedge[bid]=%lf hedge[ask]=%lf netpos = %d, balance_price=%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_avgcost_map[main_ticker], m_avgcost_map[hedge_ticker], m_shot_map[hedge_ticker].bids[0], m_shot_map[hedge_ticker].asks[0], netpos, balance_price);
+  SLOG_INFO("[%s %s]Caling balance price: avg[main]=%lf avg[hedge]=%lf hedge[bid]=%lf hedge[ask]=%lf netpos = %d, balance_price=%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), *main_leg.avgcost, *hedge_leg.avgcost, hedge_leg.Bid(), hedge_leg.Ask(), netpos, balance_price);
   return balance_price;
 }
 
@@ -96,9 +111,10 @@ bool SimpleMaker::TradeClose(const std::string & ticker, int size) {
 }
 
 void SimpleMaker::DoOperationAfterCancelled(Order* o) {
-  printf("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
+  working_orders.Remove(o);
+  SLOG_INFO("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
   if (m_cancel_map[o->ticker] > cancel_threshhold) {
-    printf("ticker %s hit cancel limit!\n", o->ticker);
+    SLOG_ERROR("ticker %s hit cancel limit!\n", o->ticker);
     m_ss = StrategyStatus::Stopped;
     Stop();
   }
@@ -106,10 +122,11 @@ void SimpleMaker::DoOperationAfterCancelled(Order* o) {
 
 bool SimpleMaker::PriceChange(double current_price, double reasonable_price, OrderSide::Enum side, double edurance) {
   bool is_bilateral = true;
-  if (m_position_map[main_ticker] > 0 && side == OrderSide::Sell) {
+  int pos = *legs[Leg::Main].pos;
+  if (pos > 0 && side == OrderSide::Sell) {
     is_bilateral = false;
   }
-  if (m_position_map[main_ticker] < 0 && side == OrderSide::Buy) {
+  if (pos < 0 && side == OrderSide::Buy) {
     is_bilateral = false;
   }
   if (is_bilateral) {
@@ -138,168 +155,211 @@ bool SimpleMaker::PriceChange(double current_price, double reasonable_price, Ord
   }
 }
 
-void SimpleMaker::AddCloseOrderSize(OrderSide::Enum side) {
+bool SimpleMaker::AddCloseOrderSize(OrderSide::Enum side) {
   pthread_mutex_lock(&add_size_mutex);
   Order * reverse_order = NULL;
-  for (std::unordered_map<std::string, Order*>::iterator it = m_order_map.begin(); it != m_order_map.end(); it++) {
-    if (!strcmp(it->second->ticker, main_ticker.c_str())) {
-      if (it->second->Valid() && it->second->side == side) {
-        reverse_order = it->second;
-        reverse_order->size++;
-        printf("[%s %s]add close ordersize from %d -> %d\n", main_ticker.c_str(), hedge_ticker.c_str(), reverse_order->size-1, reverse_order->size);
-        ModOrder(reverse_order);
-      } else if (it->second->status == OrderStatus::Modifying && it->second->side == side) {
-        reverse_order = it->second;
-        reverse_order->size++;
-        printf("[%s %s]2nd add close ordersize from %d -> %d\n", main_ticker.c_str(), hedge_ticker.c_str(), reverse_order->size-1, reverse_order->size);
-      }
+  Order* working[2 * OrderIndex::kSlots];
+  int n = WorkingOrders(Leg::Main, working);
+  for (int i = 0; i < n; i++) {
+    Order* o = working[i];
+    if (o->side != side) {
+      continue;
+    }
+    if (o->Valid()) {
+      reverse_order = o;
+      reverse_order->size++;
+      SLOG_INFO("[%s %s]add close ordersize from %d -> %d\n", main_ticker.c_str(), hedge_ticker.c_str(), reverse_order->size-1, reverse_order->size);
+      ModOrder(reverse_order);
+    } else if (o->status == OrderStatus::Modifying) {
+      reverse_order = o;
+      reverse_order->size++;
+      SLOG_INFO("[%s %s]2nd add close ordersize from %d -> %d\n", main_ticker.c_str(), hedge_ticker.c_str(), reverse_order->size-1, reverse_order->size);
     }
-  }
-  if (reverse_order == NULL) {
-    printf("not found reverse side order!119\n");
-    exit(1);
   }
   pthread_mutex_unlock(&add_size_mutex);
-  printf("release the lock\n");
+  return reverse_order != NULL;
 }
 
 double SimpleMaker::OrderPrice(const std::string & ticker, OrderSide::Enum side, bool control_price) {
-  if (ticker == hedge_ticker) {
-    return (side == OrderSide::Buy)?m_shot_map[hedge_ticker].asks[0]:m_shot_map[hedge_ticker].bids[0];
+  if (legs.LegOf(ticker) == Leg::Hedge) {
+    return legs[Leg::Hedge].Take(side);
   }
   // main ticker
+  const LegState & main_leg = legs[Leg::Main];
+  double bid = main_leg.Bid();
+  double ask = main_leg.Ask();
   if (control_price) {
-    double return_price =  ((side == OrderSide::Buy)?m_shot_map[main_ticker].bids[0]-price_control:m_shot_map[main_ticker].asks[0]+price_control);
-    printf("[%s %s]Order use price control, bid %lf, ask %lf, price control %lf, return price is %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_shot_map[main_ticker].bids[0], m_shot_map[main_ticker].asks[0], price_control, return_price);
+    double return_price =  ((side == OrderSide::Buy)?bid-price_control:ask+price_control);
+    SLOG_INFO("[%s %s]Order use price control, bid %lf, ask %lf, price control %lf, return price is %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), bid, ask, price_control, return_price);
     return return_price;
   }
 
   bool is_close = false;
-  if ((m_position_map[main_ticker] > 0 && side == OrderSide::Sell) || (m_position_map[main_ticker] < 0 && side == OrderSide::Buy)) {
+  int pos = *main_leg.pos;
+  if ((pos > 0 && side == OrderSide::Sell) || (pos < 0 && side == OrderSide::Buy)) {
     is_close = true;
   }
   if (is_close && IsHedged()) {
     double balance_price = CalBalancePrice();
     // fprintf(order_file, "[%s %s]close report: np is %d, hedgep is %d, avgcost hedge and main are %lf %lf, hedge ask bid is %lf %lf, main ask bid is %lf %lf, balanceprice is %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_position_map[main_ticker], m_position_map[hedge_ticker], m_avgcost_map[hedge_ticker], m_avgcost_map[main_ticker], m_shot_map[hedge_ticker].asks[0], m_shot_map[hedge_ticker].bids[0], m_shot_map[main_ticker].asks[0], m_shot_map[main_ticker].bids[0], balance_price);
     if (side == OrderSide::Buy) {
-      if (balance_price <= m_shot_map[main_ticker].bids[0]) {
+      if (balance_price <= bid) {
         // fprintf(order_file, "[%s %s]balance report: pricecut buy: %lf->%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_shot_map[main_ticker].bids[0], balance_price);
         return balance_price - min_price;
-      } else if (m_shot_map[main_ticker].bids[0] < balance_price && balance_price <= m_shot_map[main_ticker].asks[0]) {
-        return m_shot_map[main_ticker].bids[0];
+      } else if (bid < balance_price && balance_price <= ask) {
+        return bid;
       } else {
         // fprintf(order_file, "[%s %s]fill right now: buy: ask %lf<%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_shot_map[main_ticker].asks[0], balance_price);
-        return m_shot_map[main_ticker].asks[0];
+        return ask;
       }
     } else {
-      if (balance_price >= m_shot_map[main_ticker].asks[0]) {
+      if (balance_price >= ask) {
         // fprintf(order_file, "[%s %s]balance report: pricecut sell: %lf->%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_shot_map[main_ticker].bids[0], balance_price);
         return balance_price + min_price;
-      } else if (m_shot_map[main_ticker].bids[0] <= balance_price && balance_price < m_shot_map[main_ticker].asks[0]) {
-        return m_shot_map[main_ticker].asks[0];
+      } else if (bid <= balance_price && balance_price < ask) {
+        return ask;
       } else {
         // fprintf(order_file, "[%s %s]fill right now: sell: bid %lf>%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_shot_map[main_ticker].bids[0], balance_price);
-        return m_shot_map[main_ticker].bids[0];
+        return bid;
       }
     }
   }
 
   if (is_close && !IsHedged()) {
     // fprintf(order_file, "[%s %s]close report: np is %d, hedgep is %d, avgcost hedge and main are %lf %lf, hedge ask bid is %lf %lf, main ask bid is %lf %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_position_map[main_ticker], m_position_map[hedge_ticker], m_avgcost_map[hedge_ticker], m_avgcost_map[main_ticker], m_shot_map[hedge_ticker].asks[0], m_shot_map[hedge_ticker].bids[0], m_shot_map[main_ticker].asks[0], m_shot_map[main_ticker].bids[0]);
-    return (side == OrderSide::Buy)?m_shot_map[main_ticker].bids[0]-price_control:m_shot_map[main_ticker].asks[0]+price_control;
+    return (side == OrderSide::Buy)?bid-price_control:ask+price_control;
   }
 
-  return (side == OrderSide::Buy)?m_shot_map[main_ticker].bids[0]:m_shot_map[main_ticker].asks[0];
+  return (side == OrderSide::Buy)?bid:ask;
 }
 
 bool SimpleMaker::IsParamOK() {
-  double avg = 0.0;
-  double std = 0.0;
-  if (map_vector.size() == min_train_sample) {  // 30 min to train
-    for (unsigned int i = 0; i < map_vector.size(); i++) {
-      avg += map_vector[i];
-    }
-    avg /= map_vector.size();
-    for (unsigned int i = 0; i < map_vector.size(); i++) {
-      std += (map_vector[i]-avg) * (map_vector[i]-avg);
-    }
-    std /= map_vector.size();
-    std = sqrt(std);
+  if (mid_stats.Count() == min_train_sample) {  // 30 min to train
+    mid_stats.Resync();
+    double avg = mid_stats.Mean();
+    double std = mid_stats.Std();
     up_diff = avg + 1 * std;
     down_diff = avg - 1 * std;
-    printf("[%s %s] cal done,mean is %lf, std is %lf, parmeters: [%lf,%lf]\n", main_ticker.c_str(), hedge_ticker.c_str(), avg, std, down_diff, up_diff);
+    SLOG_INFO("[%s %s] cal done,mean is %lf, std is %lf, parmeters: [%lf,%lf]\n", main_ticker.c_str(), hedge_ticker.c_str(), avg, std, down_diff, up_diff);
     return true;
-  } else if (map_vector.size() > min_train_sample) {
+  } else if (mid_stats.Count() > min_train_sample) {
     return true;
   } else {
-    printf("[%s %s]calculating the parmeters %zu\n", main_ticker.c_str(), hedge_ticker.c_str(), map_vector.size());
+    SLOG_DEBUG("[%s %s]calculating the parmeters %ld\n", main_ticker.c_str(), hedge_ticker.c_str(), mid_stats.Count());
     return false;
   }
 }
 
 bool SimpleMaker::Ready() {
-  if (m_position_ready && m_shot_map[main_ticker].IsGood() && m_shot_map[hedge_ticker].IsGood() && mid_map[main_ticker] > 10 && mid_map[hedge_ticker] > 10 && IsParamOK() && IsAlign()) {
+  if (m_position_ready && legs[Leg::Main].quote->good && legs[Leg::Hedge].quote->good && leg_mid[Leg::Main] > 10 && leg_mid[Leg::Hedge] > 10 && IsParamOK() && IsAlign()) {
     return true;
   }
   if (!m_position_ready) {
-    printf("waiting position query finish!\n");
+    SLOG_WARN("waiting position query finish!\n");
   }
   return false;
 }
 
+void SimpleMaker::UpdateData(TickerId id, const MarketSnapshot & shot) {
+  routed_id_ = id;
+  BaseStrategy::UpdateData(shot);
+  routed_id_ = kNoTicker;
+}
+
 void SimpleMaker::Start() {
+  AsyncLogger::Instance().Register();  // the log ring, before the first tick
   /*
   if (!IsHedged()) {
     printf("not hedged position, cant start!\n");
     return;
   }
   */
-  int pos = m_position_map[main_ticker];
+  int pos = *legs[Leg::Main].pos;
   if (pos != 0) {
     max_pos = abs(pos);
   }
   if (pos > 0) {
-    NewOrder(main_ticker, OrderSide::Sell, pos, false, false, "closeyes");
+    NewOrder(main_ticker, OrderSide::Sell, pos, false, false, OrderTag::Get(OrderTag::CloseYes));
   } else if (pos < 0) {
-    NewOrder(main_ticker, OrderSide::Buy, -pos, false, false, "closeyes");
+    NewOrder(main_ticker, OrderSide::Buy, -pos, false, false, OrderTag::Get(OrderTag::CloseYes));
   } else {
     if (MidBuy()) {
-      NewOrder(main_ticker, OrderSide::Buy, 1, false, false, "startopen");
+      NewOrder(main_ticker, OrderSide::Buy, 1, false, false, OrderTag::Get(OrderTag::StartOpen));
     } else {
-      NewOrder(main_ticker, OrderSide::Buy, 1, false, true, "sleepstartopen");
+      NewOrder(main_ticker, OrderSide::Buy, 1, false, true, OrderTag::Get(OrderTag::SleepStartOpen));
     }
     if (MidSell()) {
-      NewOrder(main_ticker, OrderSide::Sell, 1, false, false, "startopen");
+      NewOrder(main_ticker, OrderSide::Sell, 1, false, false, OrderTag::Get(OrderTag::StartOpen));
     } else {
-      NewOrder(main_ticker, OrderSide::Sell, 1, false, true, "sleepstartopen");
+      NewOrder(main_ticker, OrderSide::Sell, 1, false, true, OrderTag::Get(OrderTag::SleepStartOpen));
     }
   }
 }
 
+bool SimpleMaker::WarmStart(const std::string & path, int interval_sec, int max_age_sec) {
+  checkpoint.SetInterval(interval_sec);
+  checkpoint_max_age_sec = max_age_sec;
+  return checkpoint.Open(path, m_strat_name + '|' + main_ticker + '|' + hedge_ticker, 1, min_train_sample, 2);
+}
+
+void SimpleMaker::Checkpoint(int64_t now_sec) {
+  RollingStats* series[1] = {&mid_stats};
+  double bands[2];
+  if (!checkpoint_tried) {
+    checkpoint_tried = true;
+    size_t n = checkpoint.Restore(now_sec, checkpoint_max_age_sec, series, bands);
+    if (n > 0) {
+      up_diff = bands[0];
+      down_diff = bands[1];
+      const RingBuffer<double> & w = mid_stats.Samples();
+      for (size_t i = 0; i < w.size(); i++) {
+        map_vector.push_back(w[i]);
+      }
+      SLOG_INFO("[%s %s]warm start from checkpoint, %zu samples\n", main_ticker.c_str(), hedge_ticker.c_str(), n);
+    }
+  }
+  if (checkpoint.Due(now_sec)) {
+    bands[0] = up_diff;
+    bands[1] = down_diff;
+    checkpoint.Save(now_sec, series, bands);
+  }
+}
+
 void SimpleMaker::DoOperationAfterUpdateData(const MarketSnapshot& shot) {
+  if (checkpoint.IsOpen()) {
+    Checkpoint(shot.time.tv_sec);
+  }
+  Leg::Enum leg = legs.OnShot(shot, routed_id_);
   if (shot.IsGood()) {
-    mid_map[shot.ticker] = (shot.bids[0]+shot.asks[0]) / 2;
+    if (leg != Leg::Unknown) {
+      leg_mid[leg] = (shot.bids[0]+shot.asks[0]) / 2;
+    }
+    aligner.Update(leg, shot.time);
     if (IsAlign()) {
-      printf("[%s, %s]mid_diff is %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), mid_map[main_ticker]-mid_map[hedge_ticker]);
-      map_vector.emplace_back(mid_map[main_ticker]-mid_map[hedge_ticker]);
+      SLOG_DEBUG("[%s, %s]mid_diff is %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), leg_mid[Leg::Main] - leg_mid[Leg::Hedge]);
+      map_vector.push_back(leg_mid[Leg::Main] - leg_mid[Leg::Hedge]);
+      mid_stats.Add(map_vector.back());
     }
   } else {
-    printf("received bad shot!\n");
-    shot.Show(stdout);
+    aligner.Update(Leg::Unknown, shot.time);  // a bad shot pairs with nothing
+    SLOG_ERROR("received bad shot!\n");
+    SLOG_SHOT(LogLevel::Info, shot);
     return;
   }
 }
 
 bool SimpleMaker::Spread_Good() {
-  if (m_shot_map[main_ticker].asks[0] - m_shot_map[main_ticker].bids[0] <= max_spread) {
-     if (m_shot_map[main_ticker].asks[0] - m_shot_map[main_ticker].bids[0] <= max_spread) {
+  const LegState & main_leg = legs[Leg::Main];
+  const LegState & hedge_leg = legs[Leg::Hedge];
+  if (main_leg.Spread() <= max_spread) {
+     if (main_leg.Spread() <= max_spread) {
        return true;
      } else {
-       printf("[%s %s]hedge spread too wide!%lf, %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_shot_map[hedge_ticker].asks[0], m_shot_map[hedge_ticker].bids[0]);
+       SLOG_INFO("[%s %s]hedge spread too wide!%lf, %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), hedge_leg.Ask(), hedge_leg.Bid());
        return false;
      }
   } else {
-    printf("[%s %s]main spread too wide!%lf, %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), m_shot_map[main_ticker].asks[0], m_shot_map[main_ticker].bids[0]);
+    SLOG_INFO("[%s %s]main spread too wide!%lf, %lf\n", main_ticker.c_str(), hedge_ticker.c_str(), main_leg.Ask(), main_leg.Bid());
     return false;
   }
 }
@@ -333,94 +393,104 @@ void SimpleMaker::Pause() {
 }
 
 void SimpleMaker::ModerateOrders(const std::string & ticker) {
-  if (ticker == main_ticker) {
+  Leg::Enum leg = legs.LegOf(ticker);
+  if (leg == Leg::Main) {
     ModerateOrders(main_ticker, 0);
-  } else if (ticker == hedge_ticker) {
+  } else if (leg == Leg::Hedge) {
     ModerateHedgeOrders();
   } else {
   }
 }
 
 void SimpleMaker::ModerateHedgeOrders() {
-  for (std::unordered_map<std::string, Order*>::iterator it = m_order_map.begin(); it != m_order_map.end(); it++) {
-    if (!strcmp(it->second->ticker, hedge_ticker.c_str())) {
-      MarketSnapshot hedge_shot = m_shot_map[hedge_ticker];
-      Order* o = it->second;
-      if (o->Valid()) {
-        int hedge_pos = m_position_map[hedge_ticker];
-        if (o->side == OrderSide::Buy && fabs(o->price - hedge_shot.asks[0]) > 0.01) {
-          if (hedge_pos < 0) {  // it's a close order, if need to modify, it will be a slip of price
-            // fprintf(order_file, "[%s %s]Slip point report:modify buy order %s: %lf->%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), o->order_ref, o->price, hedge_shot.asks[0]);
-          }
-          ModOrder(o);
-        } else if (o->side == OrderSide::Sell && fabs(o->price - hedge_shot.bids[0]) > 0.01) {
-          if (hedge_pos > 0) {
-            // fprintf(order_file, "[%s %s]Slip point report:modify sell order %s: %lf->%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), o->order_ref, o->price, hedge_shot.bids[0]);
-          }
-          ModOrder(o);
-        } else {
-          // TODO(nick): handle error
+  const L1Quote & hedge_quote = *legs[Leg::Hedge].quote;
+  Order* working[2 * OrderIndex::kSlots];
+  int n = WorkingOrders(Leg::Hedge, working);
+  for (int i = 0; i < n; i++) {
+    Order* o = working[i];
+    if (o->Valid()) {
+      int hedge_pos = *legs[Leg::Hedge].pos;
+      if (o->side == OrderSide::Buy && fabs(o->price - hedge_quote.ask) > 0.01) {
+        if (hedge_pos < 0) {  // it's a close order, if need to modify, it will be a slip of price
+          // fprintf(order_file, "[%s %s]Slip point report:modify buy order %s: %lf->%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), o->order_ref, o->price, hedge_quote.ask);
+        }
+        ModOrder(o);
+      } else if (o->side == OrderSide::Sell && fabs(o->price - hedge_quote.bid) > 0.01) {
+        if (hedge_pos > 0) {
+          // fprintf(order_file, "[%s %s]Slip point report:modify sell order %s: %lf->%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), o->order_ref, o->price, hedge_quote.bid);
         }
+        ModOrder(o);
+      } else {
+        // TODO(nick): handle error
       }
     }
   }
 }
 
 void SimpleMaker::ModerateAllValid(const std::string & ticker, OrderSide::Enum side) {
-  printf("entering moderate all valid!\n");
-  for (std::unordered_map<std::string, Order*>::iterator it = m_order_map.begin(); it != m_order_map.end(); it++) {
-    if (!strcmp(it->second->ticker, ticker.c_str())) {
-      Order* o = it->second;
-      if (o->Valid() && o->side == side) {
-        ModOrder(o);
-        return;
-      } else if (o->status == OrderStatus::Sleep && o->side == side) {
-        Wakeup(o);
-        return;
-      }
+  SLOG_INFO("entering moderate all valid!\n");
+  Order* working[2 * OrderIndex::kSlots];
+  int n = WorkingOrders(legs.LegOf(ticker), working);
+  for (int i = 0; i < n; i++) {
+    Order* o = working[i];
+    if (o->Valid() && o->side == side) {
+      ModOrder(o);
+      return;
+    } else if (o->status == OrderStatus::Sleep && o->side == side) {
+      Wakeup(o);
+      return;
     }
   }
-  printf("exiting moderate all valid!\n");
+  SLOG_ERROR("exiting moderate all valid!\n");
 }
 
 void SimpleMaker::ModerateOrders(const std::string & ticker, double edurance) {
-  for (std::unordered_map<std::string, Order*>::iterator it = m_order_map.begin(); it != m_order_map.end(); it++) {
-    if (!strcmp(it->second->ticker, ticker.c_str())) {
-      Order* o = it->second;
-      if (o->Valid()) {
-        if (o->side == OrderSide::Buy && !MidBuy() && IsAlign() && m_position_map[main_ticker] >= 0) {  // ensure it's open
-          ModOrder(o, true);  // if midbuy ok, mod to normal, else, mod to sleep
-          continue;
-        } else if (o->side == OrderSide::Sell && !MidSell() && IsAlign() && m_position_map[main_ticker] <= 0) {
-          ModOrder(o, true);
-          continue;
-        }
-        double reasonable_price = OrderPrice(ticker, o->side, false);
-        if (PriceChange(o->price, reasonable_price, o->side, edurance)) {
-          // printf("modify order %s, price:%lf->%lf\n", o->order_ref, o->price, reasonable_price);
-          ModOrder(o);
-        } else {
-          // printf("edure price change: from %lf->%lf, side is %s\n", o->price, reasonable_price, OrderSide::ToString(o->side));
-        }
-      } else if (o->status == OrderStatus::Sleep) {
-        if (o->side == OrderSide::Buy && MidBuy() && IsAlign()) {
-          printf("[%s %s]wake up buy orders since mid is good!%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), map_vector.back());
-          m_shot_map[main_ticker].Show(stdout);
-          m_shot_map[hedge_ticker].Show(stdout);
-          Wakeup(o);
-        } else if (o->side == OrderSide::Sell && MidSell() && IsAlign()) {
-          printf("[%s %s]wake up sell orders since mid is good!%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), map_vector.back());
-          m_shot_map[main_ticker].Show(stdout);
-          m_shot_map[hedge_ticker].Show(stdout);
-          Wakeup(o);
-        }
+  Order* working[2 * OrderIndex::kSlots];
+  int n = WorkingOrders(legs.LegOf(ticker), working);
+  for (int i = 0; i < n; i++) {
+    Order* o = working[i];
+    if (o->Valid()) {
+      if (o->side == OrderSide::Buy && !MidBuy() && IsAlign() && *legs[Leg::Main].pos >= 0) {  // ensure it's open
+        ModOrder(o, true);  // if midbuy ok, mod to normal, else, mod to sleep
+        continue;
+      } else if (o->side == OrderSide::Sell && !MidSell() && IsAlign() && *legs[Leg::Main].pos <= 0) {
+        ModOrder(o, true);
+        continue;
+      }
+      double reasonable_price = OrderPrice(ticker, o->side, false);
+      if (PriceChange(o->price, reasonable_price, o->side, edurance)) {
+        // printf("modify order %s, price:%lf->%lf\n", o->order_ref, o->price, reasonable_price);
+        ModOrder(o);
+      } else {
+        // printf("edure price change: from %lf->%lf, side is %s\n", o->price, reasonable_price, OrderSide::ToString(o->side));
+      }
+    } else if (o->status == OrderStatus::Sleep) {
+      if (o->side == OrderSide::Buy && MidBuy() && IsAlign()) {
+        SLOG_INFO("[%s %s]wake up buy orders since mid is good!%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), map_vector.back());
+        SLOG_SHOT(LogLevel::Info, *legs[Leg::Main].shot);
+        SLOG_SHOT(LogLevel::Info, *legs[Leg::Hedge].shot);
+        Wakeup(o);
+      } else if (o->side == OrderSide::Sell && MidSell() && IsAlign()) {
+        SLOG_INFO("[%s %s]wake up sell orders since mid is good!%lf\n", main_ticker.c_str(), hedge_ticker.c_str(), map_vector.back());
+        SLOG_SHOT(LogLevel::Info, *legs[Leg::Main].shot);
+        SLOG_SHOT(LogLevel::Info, *legs[Leg::Hedge].shot);
+        Wakeup(o);
       }
     }
   }
 }
 
-void SimpleMaker::OpenOrder(OrderSide::Enum sd, const std::string & info) {  // send a open order: if not align, sleep order, if algn, sleep or not depend on the if the condition is satisfied
-  std::string na = info + "notalgn";
+int SimpleMaker::WorkingOrders(Leg::Enum leg, Order** out) {
+  if (leg == Leg::Unknown) {
+    return 0;
+  }
+  working_orders.Sync(m_order_map, legs);
+  return working_orders.Collect(leg, out);
+}
+
+void SimpleMaker::OpenOrder(OrderSide::Enum sd, OrderTag::Enum tag, OrderTag::Enum not_aligned_tag) {  // send a open order: if not align, sleep order, if algn, sleep or not depend on the if the condition is satisfied
+  const std::string & info = OrderTag::Get(tag);
+  const std::string & na = OrderTag::Get(not_aligned_tag);
   if (sd == OrderSide::Buy) {
     if (IsAlign()) {
       NewOrder(main_ticker, sd, 1, true, !MidBuy(), info);
@@ -451,48 +521,60 @@ void SimpleMaker::DoOperationAfterUpdatePos(Order* o, const ExchangeInfo& info)
     reverse_sd = OrderSide::Buy;
   }
 
-  if (ticker == main_ticker) {
-    int main_pos = m_position_map[ticker];
-    printf("[%s %s]mainpos is %d, trade size is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), main_pos, trade_size);
+  Leg::Enum leg = legs.LegOf(ticker);
+  if (leg == Leg::Main) {
+    int main_pos = *legs[Leg::Main].pos;
+    SLOG_INFO("[%s %s]mainpos is %d, trade size is %d\n", main_ticker.c_str(), hedge_ticker.c_str(), main_pos, trade_size);
     if (!is_close) {  // open traded
       if (main_pos*trade_size == 1) {  // pos 0->1: cancel open order, add close order, add open order
-        printf("[%s %s]opentraded and pos=1\n", main_ticker.c_str(), hedge_ticker.c_str());
+        SLOG_INFO("[%s %s]opentraded and pos=1\n", main_ticker.c_str(), hedge_ticker.c_str());
         // CancelAll(main_ticker);  // cancel open
         // NewOrder(main_ticker, reverse_sd, 1, false, false, "close@size1");
         ModerateAllValid(main_ticker, reverse_sd);  // cancel and send new, if moding, nothing happen, else cancel and new, so it becomes close
       } else {  // pos > 1
-        printf("[%s %s]opentraded and pos>1\n", main_ticker.c_str(), hedge_ticker.c_str());
-        AddCloseOrderSize(reverse_sd);
+        SLOG_INFO("[%s %s]opentraded and pos>1\n", main_ticker.c_str(), hedge_ticker.c_str());
+        if (!AddCloseOrderSize(reverse_sd)) {
+          // the open lot has no close working for it, stop quoting rather
+          // than keep opening against a book we no longer agree with
+          SLOG_ERROR("[%s %s]not found reverse side order, stopping\n", main_ticker.c_str(), hedge_ticker.c_str());
+          Stop();
+          return;
+        }
       }
       // add open
       if (abs(main_pos) < max_pos) {
-        printf("[%s %s]This order control price\n", main_ticker.c_str(), hedge_ticker.c_str());
-        OpenOrder(sd, "addopen");
+        SLOG_INFO("[%s %s]This order control price\n", main_ticker.c_str(), hedge_ticker.c_str());
+        OpenOrder(sd, OrderTag::AddOpen, OrderTag::AddOpenNotAlgn);
       }
     } else {  // close traded
       if (abs(previous_pos) == max_pos) {
-        OpenOrder(reverse_sd, "makeupopenformax");  // if close traded from position of max_pos, now we have close order, we need to make up one to continue to open
+        OpenOrder(reverse_sd, OrderTag::MakeupOpenForMax, OrderTag::MakeupOpenForMaxNotAlgn);  // if close traded from position of max_pos, now we have close order, we need to make up one to continue to open
       }
       if (main_pos == 0) {
         max_pos = start_pos;  // when clear pos, reinit max_pos
-        printf("[%s %s]This order control price\n", main_ticker.c_str(), hedge_ticker.c_str());
-        OpenOrder(sd, "addopenforpos0");
+        SLOG_INFO("[%s %s]This order control price\n", main_ticker.c_str(), hedge_ticker.c_str());
+        OpenOrder(sd, OrderTag::AddOpenForPos0, OrderTag::AddOpenForPos0NotAlgn);
         return;
       }
     }
-  } else if (ticker == hedge_ticker) {
+  } else if (leg == Leg::Hedge) {
   } else {
     SimpleHandle(251);
   }
 }
 
 void SimpleMaker::DoOperationAfterFilled(Order* o, const ExchangeInfo& info) {
-  if (strcmp(o->ticker, main_ticker.c_str()) == 0) {
-    printf("[%s %s]Mid report: main_ticker's mid filled at %lf for order %s\n", main_ticker.c_str(), hedge_ticker.c_str(), info.trade_price, o->order_ref);
+  Leg::Enum leg = legs.LegOf(o->ticker);
+  if (info.type == InfoType::Filled) {
+    working_orders.Remove(o);
+  }
+  stats.fills++;
+  if (leg == Leg::Main) {
+    SLOG_INFO("[%s %s]Mid report: main_ticker's mid filled at %lf for order %s\n", main_ticker.c_str(), hedge_ticker.c_str(), info.trade_price, o->order_ref);
     // fprintf(order_file, "hedge order for %s\n", o->order_ref);
-    NewOrder(hedge_ticker, (o->side == OrderSide::Buy)?OrderSide::Sell : OrderSide::Buy, info.trade_size, false, false, "hedgeorder");  // hedge operation
-  } else if (strcmp(o->ticker, hedge_ticker.c_str()) == 0) {
-    printf("[%s %s]mid report: hedge_ticker's mid filled at %lf for order %s\n", main_ticker.c_str(), hedge_ticker.c_str(), info.trade_price, o->order_ref);
+    NewOrder(hedge_ticker, (o->side == OrderSide::Buy)?OrderSide::Sell : OrderSide::Buy, info.trade_size, false, false, OrderTag::Get(OrderTag::HedgeOrder));  // hedge operation
+  } else if (leg == Leg::Hedge) {
+    SLOG_INFO("[%s %s]mid report: hedge_ticker's mid filled at %lf for order %s\n", main_ticker.c_str(), hedge_ticker.c_str(), info.trade_price, o->order_ref);
   } else {
     // TODO(nick): handle error
     SimpleHandle(322);
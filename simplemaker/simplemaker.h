@@ -1,9 +1,12 @@
 #ifndef STRATEGY_SIMPLEMAKER_SIMPLEMAKER_H_
 #define STRATEGY_SIMPLEMAKER_SIMPLEMAKER_H_
 
+#include <pthread.h>
+
 #include <unordered_map>
 
 #include <cmath>
+#include <fstream>
 #include <vector>
 #include <string>
 
@@ -14,11 +17,23 @@
 #include "util/zmq_sender.hpp"
 #include "struct/exchange_info.h"
 #include "struct/order_status.h"
+#include "struct/pair_state.h"
+#include "struct/order_index.h"
+#include "struct/order_tag.h"
+#include "struct/run_stats.h"
 #include "util/common_tools.h"
+#include "util/as_of_aligner.h"
+#include "util/ring_buffer.h"
+#include "util/rolling_stats.h"
+#include "util/state_checkpoint.h"
+#include "util/strat_log.h"
 #include "core/base_strategy.h"
+#include "core/routed_strategy.h"
 
-
-class SimpleMaker : public BaseStrategy {
+// the host feeds ticks and exchange infos from different threads, so the
+// close order resizing is serialized by add_size_mutex. the rest assumes
+// one thread per callback kind, as the host does today
+class SimpleMaker : public BaseStrategy, public RoutedStrategy {
  public:
   explicit SimpleMaker(const std::string & main_ticker, const std::string & hedge_ticker, int maxpos, double tick_size, TimeController tc, int contract_size, const std::string & strat_name, std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, bool enable_stdout = true, bool enable_file = true);
   ~SimpleMaker();
@@ -26,8 +41,23 @@ class SimpleMaker : public BaseStrategy {
   void Start() override;
   void Stop() override;
   void Flatting() override;
+  using BaseStrategy::UpdateData;
+  void UpdateData(TickerId id, const MarketSnapshot & shot) override;
+  // keep the training window and bands in path, and start from it when it
+  // is at most max_age_sec old at the first tick
+  bool WarmStart(const std::string & path, int interval_sec, int max_age_sec);
+  // the senders, contract worker and mode the other strategies take in
+  // their constructors, for the offline drivers
+  void Attach(BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender, ContractWorker* cw, StrategyMode::Enum mode, std::ofstream* exchange_file);
+
+  // no test mode fills of its own, so offline only the fills a host books
+  const RunStats & Stats() const {
+    return stats;
+  }
 
  private:
+  friend class StrategyBench;  // bench/ times the callbacks one by one
+
   void DoOperationAfterUpdatePos(Order* o, const ExchangeInfo& info) override;
   void DoOperationAfterUpdateData(const MarketSnapshot& shot) override;
   void DoOperationAfterFilled(Order* o, const ExchangeInfo& info) override;
@@ -57,16 +87,22 @@ class SimpleMaker : public BaseStrategy {
 
   bool PriceChange(double current_price, double reasonable_price, OrderSide::Enum side, double edurance);
 
-  void AddCloseOrderSize(OrderSide::Enum side);
+  // false if no working order on side was there to grow
+  bool AddCloseOrderSize(OrderSide::Enum side);
   void CheckStatus();
   void ModerateAllValid(const std::string & contract, OrderSide::Enum side);
 
   void ModerateOrders(const std::string & contract) override;
 
-  void OpenOrder(OrderSide::Enum sd, const std::string & info);
+  void OpenOrder(OrderSide::Enum sd, OrderTag::Enum tag, OrderTag::Enum not_aligned_tag);
+  void Checkpoint(int64_t now_sec);
+  // leg's working orders copied to out (room for 2 * OrderIndex::kSlots)
+  int WorkingOrders(Leg::Enum leg, Order** out);
   char order_ref[MAX_ORDERREF_SIZE];
   std::string main_ticker;
   std::string hedge_ticker;
+  PairState legs;
+  OrderIndex working_orders;  // m_order_map by leg and side, resynced on membership change
   int start_pos;
   double poscapital;
   double min_price;
@@ -76,14 +112,20 @@ class SimpleMaker : public BaseStrategy {
 
   pthread_mutex_t add_size_mutex;
   int cancel_threshhold;
-  std::unordered_map<std::string, double> mid_map;
+  double leg_mid[2];  // newest good mid per leg
   std::unordered_map<std::string, Order*> sleep_order_map;
   double up_diff;
   double down_diff;
-  std::vector<double> map_vector;
+  RingBuffer<double> map_vector;
+  RollingStats mid_stats;
   double max_spread;
   unsigned int min_train_sample;
+  AsOfAligner aligner;  // 10ms, tighter than the arb strategies
+  StateCheckpoint checkpoint;
+  int checkpoint_max_age_sec;
+  bool checkpoint_tried;
   int max_pos;
+  RunStats stats;
 };
 
 #endif  // STRATEGY_SIMPLEMAKER_SIMPLEMAKER_H_
@@ -0,0 +1,506 @@
+#ifndef STRATEGY_SRC_CORE_PAIR_ENGINE_H_
+#define STRATEGY_SRC_CORE_PAIR_ENGINE_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libconfig.h++>
+
+#include "struct/market_snapshot.h"
+#include "struct/strategy_status.h"
+#include "struct/strategy_mode.h"
+#include "struct/order.h"
+#include "struct/exchange_info.h"
+#include "struct/pair_state.h"
+#include "struct/order_index.h"
+#include "struct/order_intent.h"
+#include "struct/run_stats.h"
+#include "util/time_controller.h"
+#include "util/zmq_sender.hpp"
+#include "util/history_worker.h"
+#include "util/contract_worker.h"
+#include "util/common_tools.h"
+#include "util/as_of_aligner.h"
+#include "util/fee_point_cache.h"
+#include "util/state_checkpoint.h"
+#include "util/latency_histogram.h"
+#include "util/strat_log.h"
+#include "core/base_strategy.h"
+#include "core/pair_policy.h"
+#include "core/routed_strategy.h"
+
+// two-leg arbitrage shared by SimpleArb2, CoinArb and PairTrading: the
+// main leg is worked, every main fill is hedged at the hedge touch.
+// subclasses resolve tickers and contract settings, then call
+// FillPairConfig and RunningSetup; everything per tick is here, with
+// Signal/Pricer/Closer (see core/pair_policy.h) fixed at compile time.
+template <typename Signal, typename Pricer, typename Closer>
+class PairEngine : public BaseStrategy, public RoutedStrategy {
+  friend class StrategyBench;  // bench/ times the callbacks one by one
+
+ public:
+  using BaseStrategy::UpdateData;
+
+  void UpdateData(TickerId id, const MarketSnapshot & shot) override {
+    routed_id_ = id;
+    BaseStrategy::UpdateData(shot);
+    routed_id_ = kNoTicker;
+  }
+
+  void Start() override {
+    AsyncLogger::Instance().Register();  // the log ring, before the first tick
+    m_order_map.reserve(OrderIndex::kCapacity);  // no rehash on the order path
+    UpdateParams("[start]");
+  }
+
+  void Stop() override {
+    CancelAll(main_ticker_);
+    m_ss = StrategyStatus::Stopped;
+    SLOG_INFO("[%s %s]aligned %lu, dropped %lu, repeated %lu\n", main_ticker_.c_str(), hedge_ticker_.c_str(), aligner_.Matched(), aligner_.Dropped(), aligner_.Repeated());
+    DumpLatency(stdout);
+  }
+
+  // a command for ticker "latency" dumps too
+  void HandleCommand(const Command& c) override {
+    if (strcmp(c.ticker, "latency") == 0) {
+      DumpLatency(stdout);
+      return;
+    }
+    BaseStrategy::HandleCommand(c);
+  }
+
+  const RunStats & Stats() const {
+    return stats_;
+  }
+
+  // the orders still working, empty outside Real
+  const OrderIndex & Orders() const {
+    return orders_;
+  }
+
+  // empty unless built with STRAT_LATENCY
+  void DumpLatency(FILE* f) const {
+    latency_.Dump(f, m_strat_name);
+  }
+
+ protected:
+  PairEngine(TimeController* tc, ContractWorker* cw, HistoryWorker* hw, const std::string & date, StrategyMode::Enum mode, std::ofstream* exchange_file)
+    : date_(date),
+      max_close_try_(10),
+      close_round_(0),
+      sample_head_(0),
+      sample_tail_(0),
+      current_spread_(0.0),
+      target_hedge_price_(0.0),
+      checkpoint_tried_(false),
+      checkpoint_max_age_sec_(600),
+      no_close_today_(false),
+      exchange_file_(exchange_file) {
+    m_tc = tc;
+    m_cw = cw;
+    m_hw = hw;
+    SetStrategyMode(mode, exchange_file);
+  }
+
+  // the keys every pair strategy has; throws like any libconfig lookup,
+  // call it inside the subclass's FillStratConfig try block
+  void FillPairConfig(const libconfig::Setting & param_setting, double min_price_move, int cancel_limit) {
+    min_price_move_ = min_price_move;
+    cancel_limit_ = cancel_limit;
+    max_pos_ = param_setting["max_position"];
+    train_samples_ = param_setting["train_samples"];
+    double m_r = param_setting["min_range"];
+    double m_p = param_setting["min_profit"];
+    min_profit_ = m_p * min_price_move_;
+    min_range_ = m_r * min_price_move_;
+    double spread_threshold_int = param_setting["spread_threshold"];
+    spread_threshold_ = spread_threshold_int*min_price_move_;
+    m_max_holding_sec = param_setting["max_holding_sec"];
+    range_width_ = param_setting["range_width"];
+    max_round_ = param_setting["max_round"];
+    if (param_setting.exists("no_close_today")) {
+      no_close_today_ = param_setting["no_close_today"];
+    }
+    if (param_setting.exists("align_tolerance_ms")) {
+      double ms = param_setting["align_tolerance_ms"];
+      aligner_.SetTolerance(static_cast<int64_t>(ms * 1000));
+    }
+    if (param_setting.exists("fee_mid_tolerance")) {
+      double fee_mid_tolerance = param_setting["fee_mid_tolerance"];
+      fees_[Leg::Main].SetTolerance(fee_mid_tolerance);
+      fees_[Leg::Hedge].SetTolerance(fee_mid_tolerance);
+    }
+    int series_capacity = train_samples_;
+    if (param_setting.exists("series_capacity")) {
+      series_capacity = param_setting["series_capacity"];
+    }
+    signal_.Reset(train_samples_, series_capacity);
+    if (param_setting.exists("spill_file")) {
+      std::string spill_file = param_setting["spill_file"];
+      signal_.Spill(spill_file);
+    }
+    if (param_setting.exists("checkpoint_file")) {
+      std::string checkpoint_file = param_setting["checkpoint_file"];
+      checkpoint_file_ = checkpoint_file;
+    }
+    if (param_setting.exists("checkpoint_interval_sec")) {
+      int interval = param_setting["checkpoint_interval_sec"];
+      checkpoint_.SetInterval(interval);
+    }
+    if (param_setting.exists("checkpoint_max_age_sec")) {
+      checkpoint_max_age_sec_ = param_setting["checkpoint_max_age_sec"];
+    }
+  }
+
+  void RunningSetup(std::unordered_map<std::string, std::vector<BaseStrategy*> >*ticker_strat_map, BaseSender<MarketSnapshot>* uisender, BaseSender<Order>* ordersender) {
+    m_ui_sender = uisender;
+    m_order_sender = ordersender;
+    (*ticker_strat_map)[main_ticker_].emplace_back(this);
+    (*ticker_strat_map)[hedge_ticker_].emplace_back(this);
+    (*ticker_strat_map)["positionend"].emplace_back(this);
+    MarketSnapshot shot;
+    m_shot_map[main_ticker_] = shot;
+    m_shot_map[hedge_ticker_] = shot;
+    m_avgcost_map[main_ticker_] = 0.0;
+    m_avgcost_map[hedge_ticker_] = 0.0;
+    legs_.Bind(main_ticker_, hedge_ticker_, &m_shot_map, &m_next_shot_map, &m_position_map, &m_avgcost_map);
+    if (fee_main_.empty()) {
+      fee_main_ = main_ticker_;
+    }
+    if (fee_hedge_.empty()) {
+      fee_hedge_ = hedge_ticker_;
+    }
+    fees_[Leg::Main].Bind(m_cw, fee_main_, no_close_today_);
+    fees_[Leg::Hedge].Bind(m_cw, fee_hedge_, no_close_today_);
+    if (!checkpoint_file_.empty()) {
+      checkpoint_.Open(checkpoint_file_, m_strat_name + '|' + main_ticker_ + '|' + hedge_ticker_, Signal::kSeries, train_samples_, Signal::kBands);
+    }
+  }
+
+  void DoOperationAfterUpdateData(const MarketSnapshot& shot) override {
+    LATENCY_STAMP(latency_.tick_stamp);
+    if (checkpoint_.IsOpen()) {
+      Checkpoint(shot.time.tv_sec);
+    }
+    aligner_.Update(legs_.OnShot(shot, routed_id_), shot.time);
+    current_spread_ = Signal::Spread(legs_);
+    if (!IsAlign() || (Signal::kSpreadGated && !Spread_Good())) {
+      return;
+    }
+    signal_.Add(legs_);
+    if (++sample_tail_ - sample_head_ > train_samples_) {
+      UpdateParams("[tail-head hit]");
+    }
+  }
+
+  void DoOperationAfterFilled(Order* o, const ExchangeInfo& info) override {
+    LATENCY_STAMP(latency_.fill_stamp);
+    Leg::Enum leg = legs_.LegOf(info.ticker);
+    OrderIntent intent = orders_.Fill(o, info, leg);
+    bool is_close = intent.Closes();
+    SLOG_ORDER(LogLevel::Info, o);
+    stats_.fills++;
+    if (leg == Leg::Main) {
+      OrderSide::Enum hedge_side = (info.side == OrderSide::Buy) ? OrderSide::Sell : OrderSide::Buy;
+      double price = legs_[Leg::Hedge].Take(hedge_side);
+      if (m_mode == StrategyMode::NextTest) {
+        price = legs_[Leg::Hedge].NextTake(hedge_side);
+      }
+      // costs as of the fill, a test mode hedge may be booked inside PlaceOrder
+      double main_cost = *legs_[Leg::Main].avgcost;
+      double hedge_cost = *legs_[Leg::Hedge].avgcost;
+      int64_t size = (info.side == OrderSide::Buy) ? -1 : 1;
+      Order* hedge_order = Send(hedge_ticker_, price, size, intent.Hedge());
+      LATENCY_RECORD(latency_.fill_to_hedge, latency_.fill_stamp);
+      // offline bookkeeping, after the hedge is out and never in Real
+      if (is_close && m_mode != StrategyMode::Real) {
+        int size = abs(info.trade_size);
+        stats_.pnl += m_cw->CalNetPnl(fee_main_, main_cost, size, info.trade_price, size, info.side, no_close_today_) + m_cw->CalNetPnl(fee_hedge_, hedge_cost, size, price, size, hedge_side, no_close_today_);
+      }
+      SLOG_ORDER(LogLevel::Info, hedge_order);
+    } else if (leg == Leg::Hedge) {
+      if (is_close) {
+        close_round_++;
+        stats_.rounds++;
+        UpdateParams("[close]");
+      } else {
+        sample_head_ = sample_tail_;
+      }
+    }
+  }
+
+  void DoOperationAfterCancelled(Order* o) override {
+    orders_.Remove(o);
+    SLOG_INFO("ticker %s cancel num %d!\n", o->ticker, m_cancel_map[o->ticker]);
+    if (m_cancel_map[o->ticker] > cancel_limit_) {
+      SLOG_ERROR("ticker %s hit cancel limit!\n", o->ticker);
+      Stop();
+    }
+  }
+
+  void ModerateOrders(const std::string & ticker) override {
+    if (m_mode != StrategyMode::Real) {
+      return;
+    }
+    orders_.Sync(m_order_map, legs_);
+    Order* working[2 * OrderIndex::kSlots];
+    int n = orders_.Collect(Leg::Main, working);
+    for (int i = 0; i < n; i++) {
+      Order* o = working[i];
+      if (!o->Valid()) {
+        continue;
+      }
+      double reasonable_price = OrderPrice(Leg::Main, o->side);
+      if (fabs(reasonable_price - o->price) < min_price_move_ / 2) {  // this tick is the order sent tick or tick price not changed
+        continue;
+      }
+      if (Pricer::CancelMain(o, reasonable_price, legs_, target_hedge_price_, min_price_move_)) {
+        SLOG_ORDER(LogLevel::Info, o);
+        CancelOrder(o);
+      }
+    }
+    n = orders_.Collect(Leg::Hedge, working);
+    for (int i = 0; i < n; i++) {
+      Order* o = working[i];
+      if (!o->Valid() || fabs(OrderPrice(Leg::Hedge, o->side) - o->price) < min_price_move_ / 2) {
+        continue;
+      }
+      ModOrder(o);
+      LATENCY_RECORD(latency_.tick_to_order[Leg::Hedge], latency_.tick_stamp);
+      SLOG_ORDER(LogLevel::Info, o);
+    }
+  }
+
+  bool Ready() override {
+    return sample_tail_ - sample_head_ >= train_samples_;
+  }
+
+  void Resume() override {
+    sample_head_ = sample_tail_;
+  }
+
+  void Run() override {
+    if (!RiskCheck()) {
+      return;
+    }
+    if (OpenLogic()) {
+      return;
+    }
+    CloseLogic();
+  }
+
+  // a spread gated signal flattens under the same checks it trades under
+  void Flatting() override {
+    if (Signal::kSpreadGated ? RiskCheck() : IsAlign()) {
+      CloseLogic();
+    }
+  }
+
+  double OrderPrice(const std::string & ticker, OrderSide::Enum side, bool control_price) override {
+    Leg::Enum leg = legs_.LegOf(ticker);
+    if (leg == Leg::Unknown) {
+      SLOG_ERROR("error ticker %s\n", ticker.c_str());
+      return -1.0;
+    }
+    return OrderPrice(leg, side);
+  }
+
+  void ForceFlat() override {
+    int pos = *legs_[Leg::Main].pos;
+    if (pos == 0) {
+      return;
+    }
+    OrderSide::Enum side = (pos > 0) ? OrderSide::Sell : OrderSide::Buy;
+    for (int i = 0; i < max_close_try_; i++) {
+      if (Close(side)) {
+        break;
+      }
+      if (i == max_close_try_ - 1) {
+        SLOG_ERROR("[%s %s]try max_close times, cant close this order!\n", main_ticker_.c_str(), hedge_ticker_.c_str());
+        SLOG_ORDERS(LogLevel::Warn, m_order_map);
+        m_order_map.clear();  // it's a temp solution, TODO
+        orders_.Clear();
+        Close(side);
+      }
+    }
+  }
+
+  inline double OrderPrice(Leg::Enum leg, OrderSide::Enum side) const {
+    const LegState & hedge = legs_[Leg::Hedge];
+    if (leg == Leg::Hedge) {
+      return (m_mode == StrategyMode::NextTest) ? hedge.NextTake(side) : hedge.Take(side);
+    }
+    if (m_mode == StrategyMode::NextTest) {
+      return legs_[Leg::Main].Take(side);
+    }
+    return Pricer::MainPrice(legs_, side, signal_.Lower(), signal_.Upper(), min_price_move_);
+  }
+
+  // this tick is a fresh aligned pair, see AsOfAligner
+  inline bool IsAlign() const {
+    return aligner_.Aligned();
+  }
+
+  inline bool Spread_Good() const {
+    return current_spread_ <= spread_threshold_;
+  }
+
+  inline bool RiskCheck() const {
+    return IsAlign() && close_round_ < max_round_ && (!Signal::kSpreadGated || Spread_Good());
+  }
+
+  inline bool OpenLogic() {
+    if (abs(*legs_[Leg::Main].pos) >= max_pos_ || !m_order_map.empty()) {
+      return false;
+    }
+    OrderSide::Enum side = signal_.OpenSide(legs_);
+    if (side == OrderSide::Unknown) {
+      return false;
+    }
+    SLOG_INFO("[%s %s]open %s\n", main_ticker_.c_str(), hedge_ticker_.c_str(), OrderSide::ToString(side));
+    Open(side);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Main].shot);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Hedge].shot);
+    return true;
+  }
+
+  inline void CloseLogic() {
+    int pos = *legs_[Leg::Main].pos;
+    if (pos == 0) {
+      return;
+    }
+    double exit = signal_.Exit(pos);
+    double mean = signal_.ExitMean(pos);
+    OrderSide::Enum side = Closer::CloseSide(pos, exit, mean, current_spread_);
+    if (side == OrderSide::Unknown) {
+      return;
+    }
+    SLOG_INFO("[%s %s]CloseLogic: exit=%lf, mean=%lf, pos=%d, current_spread=%lf\n", main_ticker_.c_str(), hedge_ticker_.c_str(), exit, mean, pos, current_spread_);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Main].shot);
+    SLOG_SHOT(LogLevel::Info, *legs_[Leg::Hedge].shot);
+    Close(side);
+  }
+
+  void Open(OrderSide::Enum side) {
+    double price = Pricer::OpenPrice(legs_, side, min_price_move_);
+    int64_t size = (side == OrderSide::Buy) ? 1 : -1;
+    target_hedge_price_ = (side == OrderSide::Buy) ? legs_[Leg::Hedge].Bid() : legs_[Leg::Hedge].Ask();
+    Order* o = Send(main_ticker_, price, size, OrderIntent(IntentKind::Open, Leg::Main));
+    LATENCY_RECORD(latency_.tick_to_order[Leg::Main], latency_.tick_stamp);
+    SLOG_ORDER(LogLevel::Info, o);
+  }
+
+  bool Close(OrderSide::Enum side) {
+    if (!m_order_map.empty()) {
+      SLOG_WARN("[%s %s]block order exsited! no close\n", main_ticker_.c_str(), hedge_ticker_.c_str());
+      SLOG_ORDERS(LogLevel::Warn, m_order_map);
+      return false;
+    }
+    double price = legs_[Leg::Main].Take(side);
+    int64_t size = (side == OrderSide::Buy) ? 1 : -1;
+    target_hedge_price_ = (side == OrderSide::Buy) ? legs_[Leg::Hedge].Bid() : legs_[Leg::Hedge].Ask();
+    Order* o = Send(main_ticker_, price, size, OrderIntent(IntentKind::Close, Leg::Main));
+    LATENCY_RECORD(latency_.tick_to_order[Leg::Main], latency_.tick_stamp);
+    SLOG_ORDER(LogLevel::Info, o);
+    return true;
+  }
+
+  // outside Real, PlaceOrder fills the order before it returns: the fill
+  // has taken its intent from the tag by then, and an index entry would
+  // outlive the order, so only a Real order is indexed
+  Order* Send(const std::string & ticker, double price, int64_t size, OrderIntent intent) {
+    Order* o = PlaceOrder(ticker, price, size, no_close_today_, intent.Tag());
+    if (m_mode == StrategyMode::Real) {
+      orders_.Add(o, intent);
+    }
+    return o;
+  }
+
+  // the first tick restores the training windows and bands if the file
+  // is fresh, later ones save them every checkpoint interval
+  void Checkpoint(int64_t now_sec) {
+    RollingStats* series[Signal::kSeries];
+    for (int i = 0; i < Signal::kSeries; i++) {
+      series[i] = signal_.Series(i);
+    }
+    double bands[Signal::kBands];
+    if (!checkpoint_tried_) {
+      checkpoint_tried_ = true;
+      size_t n = checkpoint_.Restore(now_sec, checkpoint_max_age_sec_, series, bands);
+      if (n > 0) {
+        signal_.SetBands(bands);
+        sample_head_ = 0;
+        sample_tail_ = n;
+        SLOG_INFO("[%s %s]warm start from checkpoint, %zu samples\n", main_ticker_.c_str(), hedge_ticker_.c_str(), n);
+      }
+    }
+    if (checkpoint_.Due(now_sec)) {
+      signal_.GetBands(bands);
+      checkpoint_.Save(now_sec, series, bands);
+    }
+  }
+
+  void UpdateParams(const char* tag) {
+    if (sample_tail_ < train_samples_) {
+      SLOG_ERROR("calparams wrong, exit\n");
+      exit(1);
+    }
+    SLOG_INFO("[%s %s] sample_tail_=%d, sample_head_=%d, train_samples_=%d\n", main_ticker_.c_str(), hedge_ticker_.c_str(), sample_tail_, sample_head_, train_samples_);
+    double round_fee_cost = fees_[Leg::Main].RoundTrip(legs_[Leg::Main].Mid()) + fees_[Leg::Hedge].RoundTrip(legs_[Leg::Hedge].Mid());
+    signal_.Calibrate(round_fee_cost, range_width_, min_range_);
+    spread_threshold_ = signal_.SpreadThreshold(spread_threshold_, min_profit_, round_fee_cost);
+    SLOG_INFO("[%s %s]%s cal done, spread_threshold is %lf, min_profit is %lf, fee_point=%lf\n", main_ticker_.c_str(), hedge_ticker_.c_str(), tag, spread_threshold_, min_profit_, round_fee_cost);
+    sample_head_ = sample_tail_;
+  }
+
+  // strategy core param
+  std::string date_;
+  std::string main_ticker_;
+  std::string hedge_ticker_;
+  // names CalFeePoint knows the legs by, default to the tickers
+  std::string fee_main_;
+  std::string fee_hedge_;
+  FeePointCache fees_[2];  // per leg, keyed by the names above
+  PairState legs_;
+  OrderIndex orders_;  // m_order_map by leg and side
+  AsOfAligner aligner_;
+  int max_close_try_;
+
+  // realtime update param
+  int close_round_;
+  int sample_head_;
+  int sample_tail_;
+  double current_spread_;
+  double target_hedge_price_;
+
+  // warm start
+  std::string checkpoint_file_;
+  StateCheckpoint checkpoint_;
+  bool checkpoint_tried_;
+  int checkpoint_max_age_sec_;
+
+  // read from config
+  int max_pos_;
+  double min_price_move_;
+  int cancel_limit_;
+  double min_profit_;
+  int train_samples_;
+  double min_range_;
+  double range_width_;
+  double spread_threshold_;
+  bool no_close_today_;
+  int max_round_;
+
+  Signal signal_;
+  std::ofstream* exchange_file_;
+  RunStats stats_;
+  PairLatency latency_;
+};
+
+#endif  // STRATEGY_SRC_CORE_PAIR_ENGINE_H_
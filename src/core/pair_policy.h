@@ -0,0 +1,337 @@
+#ifndef STRATEGY_SRC_CORE_PAIR_POLICY_H_
+#define STRATEGY_SRC_CORE_PAIR_POLICY_H_
+
+#include <algorithm>
+#include <string>
+
+#include "struct/order.h"
+#include "struct/pair_state.h"
+#include "util/common_tools.h"
+#include "util/ring_buffer.h"
+#include "util/rolling_stats.h"
+#include "util/strat_log.h"
+
+// policies plugged into PairEngine. they are plain classes with inline
+// members, the engine calls them directly so every stage inlines into
+// the strategy's own callbacks.
+//
+// Signal:  what is sampled per aligned tick, how bands are calibrated,
+//          when to open and what a position is closed against, and the
+//          spread_threshold a calibration leaves behind. kSeries
+//          training windows and kBands band values are what a warm start
+//          checkpoint (util/state_checkpoint.h) keeps
+// Pricer:  open price, main leg order price and when a resting main
+//          order must be pulled
+// Closer:  when a position has reverted enough to close
+
+// main mid - hedge mid, one band around its mean. opens on the touch:
+// sell when main ask - hedge ask reaches the upper band, buy when main
+// bid - hedge bid reaches the lower one, if the hedge side has at least
+// kMinHedgeSize lots to take
+template <int kMinHedgeSize>
+class MidDiffSignal {
+ public:
+  static const bool kSpreadGated = false;
+  static const int kSeries = 1;
+  static const int kBands = 3;
+
+  MidDiffSignal()
+    : up_(0.0),
+      down_(0.0),
+      mean_(0.0),
+      margin_(0.0) {
+  }
+
+  static inline double Spread(const PairState & legs) {
+    return legs[Leg::Main].Spread();
+  }
+
+  void Reset(int train_samples, int capacity) {
+    mids_.Reset(std::max(capacity, train_samples));
+    stats_.Reset(train_samples);
+  }
+
+  void Spill(const std::string & path) {
+    mids_.Spill(path);
+  }
+
+  inline void Add(const PairState & legs) {
+    double mid = legs.MidDiff();
+    mids_.push_back(mid);
+    stats_.Add(mid);
+    SLOG_DEBUG("mid_diff=%lf\n", mid);
+  }
+
+  RollingStats* Series(int i) {
+    return &stats_;
+  }
+
+  void GetBands(double* bands) const {
+    bands[0] = mean_;
+    bands[1] = up_;
+    bands[2] = down_;
+  }
+
+  // after the windows were restored, mids_ picks up the same samples
+  void SetBands(const double* bands) {
+    mean_ = bands[0];
+    up_ = bands[1];
+    down_ = bands[2];
+    const RingBuffer<double> & w = stats_.Samples();
+    for (size_t i = 0; i < w.size(); i++) {
+      mids_.push_back(w[i]);
+    }
+  }
+
+  void Calibrate(double fee_point, double range_width, double min_range) {
+    stats_.Resync();
+    double std = stats_.Std();
+    margin_ = std::max(range_width * std, min_range) + fee_point;
+    mean_ = stats_.Mean();
+    up_ = mean_ + margin_;
+    down_ = mean_ - margin_;
+    SLOG_INFO("mean is %lf, std is %lf, parmeters: [%lf,%lf]\n", mean_, std, down_, up_);
+  }
+
+  // whatever is left of the band once min_profit and the fees are paid
+  inline double SpreadThreshold(double configured, double min_profit, double fee_point) const {
+    return margin_ - min_profit - fee_point;
+  }
+
+  inline OrderSide::Enum OpenSide(const PairState & legs) const {
+    const LegState & main_leg = legs[Leg::Main];
+    const LegState & hedge_leg = legs[Leg::Hedge];
+    if (main_leg.Ask() - hedge_leg.Ask() >= up_) {  // sell at high price
+      return hedge_leg.AskSize() < kMinHedgeSize ? OrderSide::Unknown : OrderSide::Sell;
+    }
+    if (main_leg.Bid() - hedge_leg.Bid() <= down_) {  // buy at low price
+      return hedge_leg.BidSize() < kMinHedgeSize ? OrderSide::Unknown : OrderSide::Buy;
+    }
+    return OrderSide::Unknown;
+  }
+
+  inline double Exit(int pos) const {
+    return mids_.back();
+  }
+
+  inline double ExitMean(int pos) const {
+    return mean_;
+  }
+
+  inline double Lower() const {
+    return down_;
+  }
+
+  inline double Upper() const {
+    return up_;
+  }
+
+ private:
+  RingBuffer<double> mids_;
+  RollingStats stats_;
+  double up_;
+  double down_;
+  double mean_;
+  double margin_;
+};
+
+// the two executable spreads, long = main ask - hedge bid and
+// short = main bid - hedge ask, each with its own band. only sampled,
+// traded and flattened while the summed spread is under spread_threshold
+// and close rounds are under max_round; the threshold stays as configured
+class LongShortSignal {
+ public:
+  static const bool kSpreadGated = true;
+  static const int kSeries = 2;
+  static const int kBands = 6;
+
+  LongShortSignal()
+    : long_up_(0.0),
+      long_down_(0.0),
+      long_mean_(0.0),
+      short_up_(0.0),
+      short_down_(0.0),
+      short_mean_(0.0) {
+  }
+
+  static inline double Spread(const PairState & legs) {
+    return legs.SpreadSum();
+  }
+
+  void Reset(int train_samples, int capacity) {
+    long_.Reset(std::max(capacity, train_samples));
+    short_.Reset(std::max(capacity, train_samples));
+    long_stats_.Reset(train_samples);
+    short_stats_.Reset(train_samples);
+  }
+
+  void Spill(const std::string & path) {
+    long_.Spill(path + ".long");
+    short_.Spill(path + ".short");
+  }
+
+  inline void Add(const PairState & legs) {
+    const LegState & main_leg = legs[Leg::Main];
+    const LegState & hedge_leg = legs[Leg::Hedge];
+    double long_price = main_leg.Ask() - hedge_leg.Bid();
+    double short_price = main_leg.Bid() - hedge_leg.Ask();
+    long_.push_back(long_price);
+    short_.push_back(short_price);
+    long_stats_.Add(long_price);
+    short_stats_.Add(short_price);
+  }
+
+  RollingStats* Series(int i) {
+    return i == 0 ? &long_stats_ : &short_stats_;
+  }
+
+  void GetBands(double* bands) const {
+    bands[0] = long_mean_;
+    bands[1] = long_up_;
+    bands[2] = long_down_;
+    bands[3] = short_mean_;
+    bands[4] = short_up_;
+    bands[5] = short_down_;
+  }
+
+  void SetBands(const double* bands) {
+    long_mean_ = bands[0];
+    long_up_ = bands[1];
+    long_down_ = bands[2];
+    short_mean_ = bands[3];
+    short_up_ = bands[4];
+    short_down_ = bands[5];
+    const RingBuffer<double> & l = long_stats_.Samples();
+    const RingBuffer<double> & s = short_stats_.Samples();
+    for (size_t i = 0; i < l.size(); i++) {
+      long_.push_back(l[i]);
+      short_.push_back(s[i]);
+    }
+  }
+
+  void Calibrate(double fee_point, double range_width, double min_range) {
+    long_stats_.Resync();
+    short_stats_.Resync();
+    long_mean_ = long_stats_.Mean();
+    short_mean_ = short_stats_.Mean();
+    double long_width = std::max(range_width * long_stats_.Std(), min_range) + fee_point;
+    double short_width = std::max(range_width * short_stats_.Std(), min_range) + fee_point;
+    long_up_ = long_mean_ + long_width;
+    long_down_ = long_mean_ - long_width;
+    short_up_ = short_mean_ + short_width;
+    short_down_ = short_mean_ - short_width;
+    SLOG_INFO("long_up:%lf %lf %lf short:%lf %lf %lf\n", long_up_, long_mean_, long_down_, short_up_, short_mean_, short_down_);
+  }
+
+  inline double SpreadThreshold(double configured, double min_profit, double fee_point) const {
+    return configured;
+  }
+
+  inline OrderSide::Enum OpenSide(const PairState & legs) const {
+    double long_back = long_.back();
+    double short_back = short_.back();
+    if (long_back > short_down_ && short_back < long_up_) {
+      return OrderSide::Unknown;
+    }
+    return (long_back <= short_down_) ? OrderSide::Buy : OrderSide::Sell;
+  }
+
+  // a long position is closed by selling, i.e. at the short price
+  inline double Exit(int pos) const {
+    return pos > 0 ? short_.back() : long_.back();
+  }
+
+  inline double ExitMean(int pos) const {
+    return pos > 0 ? short_mean_ : long_mean_;
+  }
+
+  inline double Lower() const {
+    return short_down_;
+  }
+
+  inline double Upper() const {
+    return long_up_;
+  }
+
+ private:
+  RingBuffer<double> long_;
+  RingBuffer<double> short_;
+  RollingStats long_stats_;
+  RollingStats short_stats_;
+  double long_up_;
+  double long_down_;
+  double long_mean_;
+  double short_up_;
+  double short_down_;
+  double short_mean_;
+};
+
+// quotes the main leg at the band edge off the hedge touch and pulls a
+// resting main order once that price has moved away from it. opens
+// kImproveTicks inside the main touch
+template <int kImproveTicks>
+class HunterPricer {
+ public:
+  static inline double OpenPrice(const PairState & legs, OrderSide::Enum side, double min_price_move) {
+    return (side == OrderSide::Buy) ? legs[Leg::Main].Bid() + kImproveTicks * min_price_move : legs[Leg::Main].Ask() - kImproveTicks * min_price_move;
+  }
+
+  static inline double MainPrice(const PairState & legs, OrderSide::Enum side, double lower, double upper, double min_price_move) {
+    const LegState & hedge = legs[Leg::Hedge];
+    return (side == OrderSide::Buy) ? RoundPrice(hedge.Bid() + lower, min_price_move, 1) : RoundPrice(hedge.Ask() + upper, min_price_move, -1);
+  }
+
+  static inline bool CancelMain(const Order* o, double reasonable_price, const PairState & legs, double target_hedge_price, double min_price_move) {
+    return (o->side == OrderSide::Buy && o->price - reasonable_price >= min_price_move / 2)  //  buy, order price > reasonable buy price, loss
+        || (o->side == OrderSide::Sell && o->price - reasonable_price <= min_price_move / 2);  // sell, order price < reasonable sell
+  }
+};
+
+// crosses the main touch and pulls a resting main order once the hedge
+// touch moved past the price the open was computed against
+class TakePricer {
+ public:
+  static inline double OpenPrice(const PairState & legs, OrderSide::Enum side, double min_price_move) {
+    return legs[Leg::Main].Take(side);
+  }
+
+  static inline double MainPrice(const PairState & legs, OrderSide::Enum side, double lower, double upper, double min_price_move) {
+    return legs[Leg::Main].Take(side);
+  }
+
+  static inline bool CancelMain(const Order* o, double reasonable_price, const PairState & legs, double target_hedge_price, double min_price_move) {
+    const LegState & hedge = legs[Leg::Hedge];
+    return (o->side == OrderSide::Buy && hedge.Bid() - target_hedge_price < -1e-4)
+        || (o->side == OrderSide::Sell && hedge.Ask() - target_hedge_price > -1e-4);
+  }
+};
+
+// close once the exit value is half a spread past its mean
+class HalfSpreadClose {
+ public:
+  static inline OrderSide::Enum CloseSide(int pos, double exit, double mean, double spread) {
+    if (pos > 0 && exit > mean + spread / 2) {
+      return OrderSide::Sell;
+    }
+    if (pos < 0 && exit < mean - spread / 2) {
+      return OrderSide::Buy;
+    }
+    return OrderSide::Unknown;
+  }
+};
+
+// close as soon as the exit value crosses its mean
+class MeanClose {
+ public:
+  static inline OrderSide::Enum CloseSide(int pos, double exit, double mean, double spread) {
+    if (pos > 0 && exit > mean) {  // buy pos, sell to close
+      return OrderSide::Sell;
+    }
+    if (pos < 0 && exit < mean) {
+      return OrderSide::Buy;
+    }
+    return OrderSide::Unknown;
+  }
+};
+
+#endif  // STRATEGY_SRC_CORE_PAIR_POLICY_H_
@@ -0,0 +1,30 @@
+#ifndef STRATEGY_SRC_CORE_ROUTED_STRATEGY_H_
+#define STRATEGY_SRC_CORE_ROUTED_STRATEGY_H_
+
+#include "struct/market_snapshot.h"
+#include "util/ticker_table.h"
+
+// a strategy that matches legs on interned ids. a driver routing by id
+// (core/ticker_router.h, core/strategy_actor.h) calls UpdateData with the
+// id the snapshot was routed under instead of BaseStrategy::UpdateData,
+// under one that doesn't (the backend's ticker_strat_map) there is no id
+// and the strategy compares names. the backend's UpdateData takes the
+// snapshot only, so the id is held in routed_id_ for the length of the
+// call, DoOperationAfterUpdateData reads it from there
+class RoutedStrategy {
+ public:
+  virtual ~RoutedStrategy() {
+  }
+
+  // set routed_id_, call BaseStrategy::UpdateData, reset it
+  virtual void UpdateData(TickerId id, const MarketSnapshot & shot) = 0;
+
+ protected:
+  RoutedStrategy()
+    : routed_id_(kNoTicker) {
+  }
+
+  TickerId routed_id_;  // kNoTicker outside UpdateData(id, shot)
+};
+
+#endif  // STRATEGY_SRC_CORE_ROUTED_STRATEGY_H_
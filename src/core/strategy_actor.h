@@ -0,0 +1,209 @@
+#ifndef STRATEGY_SRC_CORE_STRATEGY_ACTOR_H_
+#define STRATEGY_SRC_CORE_STRATEGY_ACTOR_H_
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+
+#include "struct/market_snapshot.h"
+#include "struct/exchange_info.h"
+#include "struct/command.h"
+#include "core/base_strategy.h"
+#include "core/routed_strategy.h"
+#include "util/async_logger.h"
+#include "util/mpsc_queue.h"
+#include "util/ticker_table.h"
+
+namespace actordetail {
+
+constexpr size_t Max(size_t a, size_t b) {
+  return a > b ? a : b;
+}
+
+}  // namespace actordetail
+
+// one inbox entry, body holds the raw record of its kind
+struct ActorMessage {
+  enum Kind {
+    Start = 0,
+    Stop,
+    Shot,
+    NextShot,
+    Info,
+    Cmd
+  };
+
+  static const size_t kBodySize = actordetail::Max(sizeof(MarketSnapshot), actordetail::Max(sizeof(ExchangeInfo), sizeof(Command)));
+
+  int kind;
+  TickerId ticker;  // the id a Shot was routed under, kNoTicker if none
+  alignas(8) char body[kBodySize];
+};
+
+// runs one strategy as an actor: the feed, exchange and command threads
+// only post into its inbox, and a single (optionally pinned) thread makes
+// every call into the strategy, in arrival order. strategy code behind an
+// actor needs no locks, and a fill is never handled in the middle of a tick
+class StrategyActor {
+ public:
+  static const size_t kDefaultInbox = 4096;
+
+  explicit StrategyActor(BaseStrategy* strategy, size_t inbox = kDefaultInbox)
+    : strategy_(strategy),
+      routed_(dynamic_cast<RoutedStrategy*>(strategy)),
+      inbox_(inbox),
+      running_(false),
+      stalls_(0),
+      handled_(0) {
+  }
+
+  ~StrategyActor() {
+    Stop();
+  }
+
+  StrategyActor(const StrategyActor&) = delete;
+  StrategyActor& operator=(const StrategyActor&) = delete;
+
+  // spawn the actor thread, pinned to cpu when cpu >= 0, and run the
+  // strategy's Start on it
+  void Start(int cpu = -1) {
+    if (running_.exchange(true)) {
+      return;
+    }
+    thread_ = std::thread(&StrategyActor::Loop, this, cpu);
+    Post(ActorMessage::Start, nullptr, 0);
+  }
+
+  // everything posted before is handled, then the strategy's Stop runs
+  // and the thread exits
+  void Stop() {
+    if (!thread_.joinable()) {
+      return;
+    }
+    Post(ActorMessage::Stop, nullptr, 0);
+    thread_.join();
+    running_ = false;
+  }
+
+  inline void OnShot(const MarketSnapshot & shot) {
+    Post(ActorMessage::Shot, &shot, sizeof(shot));
+  }
+
+  // id goes with the snapshot to a RoutedStrategy on the actor thread
+  inline void OnShot(TickerId id, const MarketSnapshot & shot) {
+    Post(ActorMessage::Shot, &shot, sizeof(shot), id);
+  }
+
+  inline void OnNextShot(const MarketSnapshot & shot) {
+    Post(ActorMessage::NextShot, &shot, sizeof(shot));
+  }
+
+  inline void OnExchangeInfo(const ExchangeInfo & info) {
+    Post(ActorMessage::Info, &info, sizeof(info));
+  }
+
+  inline void OnCommand(const Command & c) {
+    Post(ActorMessage::Cmd, &c, sizeof(c));
+  }
+
+  // times a producer found the inbox full and had to wait
+  long Stalls() const {
+    return stalls_.load(std::memory_order_relaxed);
+  }
+
+  long Handled() const {
+    return handled_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static const int kSpinsBeforeYield = 1 << 10;
+
+  // never drops: a lost fill or cancel would leave the strategy's book wrong
+  inline void Post(int kind, const void* body, size_t n, TickerId ticker = kNoTicker) {
+    auto fill = [kind, body, n, ticker](ActorMessage* m) {
+      m->kind = kind;
+      m->ticker = ticker;
+      if (n > 0) {
+        memcpy(m->body, body, n);
+      }
+    };
+    if (inbox_.Push(fill)) {
+      return;
+    }
+    stalls_.fetch_add(1, std::memory_order_relaxed);
+    while (!inbox_.Push(fill)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void Loop(int cpu) {
+    if (cpu >= 0) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      if (err != 0) {
+        printf("strategy actor pin to cpu %d failed: %s\n", cpu, strerror(err));
+      }
+    }
+    AsyncLogger::Instance().Register();
+    bool stop = false;
+    int idle = 0;
+    while (!stop) {
+      if (inbox_.Pop([this, &stop](const ActorMessage & m) { stop = Dispatch(m); })) {
+        idle = 0;
+        continue;
+      }
+      if (++idle >= kSpinsBeforeYield) {
+        std::this_thread::yield();
+        idle = 0;
+      }
+    }
+  }
+
+  // true once the strategy is stopped
+  bool Dispatch(const ActorMessage & m) {
+    handled_.fetch_add(1, std::memory_order_relaxed);
+    switch (m.kind) {
+      case ActorMessage::Shot:
+        if (routed_ != nullptr) {
+          routed_->UpdateData(m.ticker, *reinterpret_cast<const MarketSnapshot*>(m.body));
+        } else {
+          strategy_->UpdateData(*reinterpret_cast<const MarketSnapshot*>(m.body));
+        }
+        return false;
+      case ActorMessage::NextShot:
+        strategy_->UpdateNextShot(*reinterpret_cast<const MarketSnapshot*>(m.body));
+        return false;
+      case ActorMessage::Info:
+        strategy_->UpdateExchangeInfo(*reinterpret_cast<const ExchangeInfo*>(m.body));
+        return false;
+      case ActorMessage::Cmd:
+        strategy_->HandleCommand(*reinterpret_cast<const Command*>(m.body));
+        return false;
+      case ActorMessage::Start:
+        strategy_->Start();
+        return false;
+      case ActorMessage::Stop:
+        strategy_->Stop();
+        return true;
+      default:
+        printf("strategy actor: unknown message kind %d\n", m.kind);
+        return false;
+    }
+  }
+
+  BaseStrategy* strategy_;
+  RoutedStrategy* routed_;  // strategy_, if it is one
+  MpscQueue<ActorMessage> inbox_;
+  std::atomic<bool> running_;
+  std::atomic<long> stalls_;
+  std::atomic<long> handled_;
+  std::thread thread_;
+};
+
+#endif  // STRATEGY_SRC_CORE_STRATEGY_ACTOR_H_
@@ -0,0 +1,117 @@
+#ifndef STRATEGY_SRC_CORE_TICKER_ROUTER_H_
+#define STRATEGY_SRC_CORE_TICKER_ROUTER_H_
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "struct/market_snapshot.h"
+#include "core/base_strategy.h"
+#include "core/routed_strategy.h"
+#include "util/ticker_table.h"
+
+// snapshot routing by TickerId: subscriptions are interned once at setup
+// and frozen into one flat array, the subscribers of a ticker being one
+// contiguous span of it. strategies still register into the backend's
+// ticker_strat_map, a driver takes that map over with Subscribe(map).
+// a RoutedStrategy gets the id along with the snapshot
+class TickerRouter {
+ public:
+  struct Span {
+    BaseStrategy* const* first;
+    BaseStrategy* const* last;
+
+    BaseStrategy* const* begin() const {
+      return first;
+    }
+
+    BaseStrategy* const* end() const {
+      return last;
+    }
+
+    bool empty() const {
+      return first == last;
+    }
+
+    size_t size() const {
+      return last - first;
+    }
+  };
+
+  TickerId Subscribe(const std::string & ticker, BaseStrategy* s) {
+    TickerId id = TickerTable::Intern(ticker);
+    pending_.emplace_back(id, s);
+    return id;
+  }
+
+  // every (ticker, strategy) of a ticker_strat_map, in its per ticker order
+  void Subscribe(const std::unordered_map<std::string, std::vector<BaseStrategy*> > & ticker_strat_map) {
+    for (const auto & m : ticker_strat_map) {
+      for (BaseStrategy* s : m.second) {
+        Subscribe(m.first, s);
+      }
+    }
+  }
+
+  // flattens the subscriptions so far, call after the last Subscribe and
+  // before routing. subscription order within a ticker is kept
+  void Freeze() {
+    size_t n_ids = TickerTable::Size();
+    begin_.assign(n_ids + 1, 0);
+    for (const auto & p : pending_) {
+      begin_[p.first + 1]++;
+    }
+    for (size_t i = 0; i < n_ids; i++) {
+      begin_[i + 1] += begin_[i];
+    }
+    subscribers_.assign(pending_.size(), nullptr);
+    routed_.assign(pending_.size(), nullptr);
+    std::vector<uint32_t> fill(begin_.begin(), begin_.end() - 1);
+    for (const auto & p : pending_) {
+      routed_[fill[p.first]] = dynamic_cast<RoutedStrategy*>(p.second);
+      subscribers_[fill[p.first]++] = p.second;
+    }
+  }
+
+  inline Span Subscribers(TickerId id) const {
+    Span span;
+    if (begin_.empty() || id >= begin_.size() - 1) {  // kNoTicker, or interned after Freeze
+      span.first = span.last = nullptr;
+      return span;
+    }
+    span.first = subscribers_.data() + begin_[id];
+    span.last = subscribers_.data() + begin_[id + 1];
+    return span;
+  }
+
+  // next, if given, goes to UpdateNextShot first. returns the number of
+  // subscribers reached
+  inline size_t Deliver(TickerId id, const MarketSnapshot & shot, const MarketSnapshot* next = nullptr) const {
+    Span span = Subscribers(id);
+    if (span.empty()) {
+      return 0;
+    }
+    RoutedStrategy* const* routed = routed_.data() + (span.first - subscribers_.data());
+    for (size_t i = 0; i < span.size(); i++) {
+      BaseStrategy* s = span.first[i];
+      if (next != nullptr) {
+        s->UpdateNextShot(*next);
+      }
+      if (routed[i] != nullptr) {
+        routed[i]->UpdateData(id, shot);
+      } else {
+        s->UpdateData(shot);
+      }
+    }
+    return span.size();
+  }
+
+ private:
+  std::vector<std::pair<TickerId, BaseStrategy*> > pending_;
+  std::vector<uint32_t> begin_;  // span of id is [begin_[id], begin_[id + 1])
+  std::vector<BaseStrategy*> subscribers_;
+  std::vector<RoutedStrategy*> routed_;  // parallel to subscribers_, nullptr if not one
+};
+
+#endif  // STRATEGY_SRC_CORE_TICKER_ROUTER_H_
@@ -0,0 +1,27 @@
+#ifndef STRATEGY_SRC_STRUCT_BAND_STATE_H_
+#define STRATEGY_SRC_STRUCT_BAND_STATE_H_
+
+#include <sys/time.h>
+
+// what a band strategy shows the UI on each aligned tick, plain numbers
+// only; turning it into a wire message is the publisher's job
+struct BandState {
+  timeval time;
+  double mid;
+  double mean;
+  double spread;
+  double down;  // open lines
+  double up;
+  double stop_loss_down;
+  double stop_loss_up;
+  double main_bid;
+  double main_ask;
+  double hedge_bid;
+  double hedge_ask;
+  int main_bid_size;
+  int main_ask_size;
+  int hedge_bid_size;
+  int hedge_ask_size;
+};
+
+#endif  // STRATEGY_SRC_STRUCT_BAND_STATE_H_
@@ -0,0 +1,173 @@
+#ifndef STRATEGY_SRC_STRUCT_ORDER_INDEX_H_
+#define STRATEGY_SRC_STRUCT_ORDER_INDEX_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "struct/order.h"
+#include "struct/exchange_info.h"
+#include "struct/order_intent.h"
+#include "struct/pair_state.h"
+
+// working orders of a pair in fixed slots grouped by leg and side, each
+// with the OrderIntent it was sent with. a handle is a slot number and
+// stays valid until its order is removed.
+// it mirrors m_order_map: strategies Add what they send and Remove on
+// fill/cancel, and Sync rebuilds it from the map when the two disagree
+// in size (the backend dropped or rejected something behind our back)
+class OrderIndex {
+ public:
+  typedef int Handle;
+  static const int kSlots = 8;  // per leg and side
+  static const int kGroups = 4;
+  static const int kCapacity = kGroups * kSlots;
+  static const Handle kNone = -1;
+
+  OrderIndex() {
+    Clear();
+  }
+
+  void Clear() {
+    for (int g = 0; g < kGroups; g++) {
+      used_[g] = 0;
+    }
+    size_ = 0;
+    untracked_ = 0;
+  }
+
+  // kNone if the leg or side is unknown or the group is full
+  Handle Add(Order* o, OrderIntent intent) {
+    int g = Group(intent.GetLeg(), o->side);
+    if (g < 0 || used_[g] == kFull) {
+      untracked_++;
+      return kNone;
+    }
+    int slot = __builtin_ctz(~used_[g] & kFull);
+    used_[g] |= 1u << slot;
+    orders_[g][slot] = o;
+    intents_[g][slot] = intent;
+    size_++;
+    return g * kSlots + slot;
+  }
+
+  // intent recovered from the order's tag
+  Handle Add(Leg::Enum leg, Order* o) {
+    return Add(o, OrderIntent::FromTag(o->tbd, leg));
+  }
+
+  // intent, if given, gets the one o was added with
+  bool Remove(const Order* o, OrderIntent* intent = nullptr) {
+    for (int g = 0; g < kGroups; g++) {
+      for (uint32_t m = used_[g]; m != 0; m &= m - 1) {
+        int slot = __builtin_ctz(m);
+        if (orders_[g][slot] == o) {
+          used_[g] &= ~(1u << slot);
+          size_--;
+          if (intent != nullptr) {
+            *intent = intents_[g][slot];
+          }
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Unknown if o is not here
+  OrderIntent IntentOf(const Order* o) const {
+    for (int g = 0; g < kGroups; g++) {
+      for (uint32_t m = used_[g]; m != 0; m &= m - 1) {
+        int slot = __builtin_ctz(m);
+        if (orders_[g][slot] == o) {
+          return intents_[g][slot];
+        }
+      }
+    }
+    return OrderIntent();
+  }
+
+  // the intent of a fill of o, removing o once fully filled. an order
+  // the index lost track of gets it from its tag, on leg
+  OrderIntent Fill(const Order* o, const ExchangeInfo & info, Leg::Enum leg) {
+    OrderIntent intent;
+    if (info.type == InfoType::Filled) {
+      Remove(o, &intent);
+    } else {
+      intent = IntentOf(o);
+    }
+    return intent.Known() ? intent : OrderIntent::FromTag(o->tbd, leg);
+  }
+
+  inline Order* Get(Handle h) const {
+    return (h >= 0 && h < kCapacity && (used_[h / kSlots] >> (h % kSlots) & 1)) ? orders_[h / kSlots][h % kSlots] : nullptr;
+  }
+
+  inline int Count(Leg::Enum leg, OrderSide::Enum side) const {
+    int g = Group(leg, side);
+    return g < 0 ? 0 : __builtin_popcount(used_[g]);
+  }
+
+  // anything working on this leg
+  inline int Count(Leg::Enum leg) const {
+    return Count(leg, OrderSide::Buy) + Count(leg, OrderSide::Sell);
+  }
+
+  // the first working order of leg/side, nullptr if none
+  inline Order* First(Leg::Enum leg, OrderSide::Enum side) const {
+    int g = Group(leg, side);
+    return (g < 0 || used_[g] == 0) ? nullptr : orders_[g][__builtin_ctz(used_[g])];
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+  // copies the orders of leg (both sides) to out, which has room for
+  // 2 * kSlots, so callers may cancel or modify while walking the copy
+  int Collect(Leg::Enum leg, Order** out) const {
+    int n = 0;
+    for (int s = 0; s < 2; s++) {
+      int g = leg * 2 + s;
+      for (uint32_t m = used_[g]; m != 0; m &= m - 1) {
+        out[n++] = orders_[g][__builtin_ctz(m)];
+      }
+    }
+    return n;
+  }
+
+  // the same for both legs, out has room for kCapacity
+  int CollectAll(Order** out) const {
+    int n = Collect(Leg::Main, out);
+    return n + Collect(Leg::Hedge, out + n);
+  }
+
+  void Sync(const std::unordered_map<std::string, Order*> & order_map, const PairState & legs) {
+    if (size_ + untracked_ == order_map.size()) {
+      return;
+    }
+    Clear();
+    for (const auto & m : order_map) {
+      Add(legs.LegOf(m.second->ticker), m.second);
+    }
+  }
+
+ private:
+  static const uint32_t kFull = (1u << kSlots) - 1;
+
+  static inline int Group(Leg::Enum leg, OrderSide::Enum side) {
+    if (leg == Leg::Unknown || (side != OrderSide::Buy && side != OrderSide::Sell)) {
+      return -1;
+    }
+    return leg * 2 + (side == OrderSide::Sell);
+  }
+
+  Order* orders_[kGroups][kSlots];
+  OrderIntent intents_[kGroups][kSlots];
+  uint32_t used_[kGroups];
+  size_t size_;
+  size_t untracked_;
+};
+
+#endif  // STRATEGY_SRC_STRUCT_ORDER_INDEX_H_
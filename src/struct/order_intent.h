@@ -0,0 +1,95 @@
+#ifndef STRATEGY_SRC_STRUCT_ORDER_INTENT_H_
+#define STRATEGY_SRC_STRUCT_ORDER_INTENT_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "struct/order_tag.h"
+#include "struct/pair_state.h"
+
+struct IntentKind {
+  enum Enum {
+    Unknown = 0,
+    Open,
+    Close,
+    ForceFlat,  // a close forced by time up or stop loss
+    StartOpen,
+    Hedge  // a hedge sent for a fill of unknown intent
+  };
+};
+
+// why an order was sent and on which leg, two bytes. strategies keep it
+// next to the order in their OrderIndex, so a fill is classified without
+// looking at Order::tbd; the tag still goes out in tbd (the backend owns
+// Order), from which FromTag recovers the intent of orders the index
+// never saw
+struct OrderIntent {
+  OrderIntent()
+    : kind(IntentKind::Unknown),
+      leg(Leg::Unknown) {
+  }
+
+  OrderIntent(IntentKind::Enum k, Leg::Enum l)
+    : kind(k),
+      leg(l) {
+  }
+
+  inline IntentKind::Enum Kind() const {
+    return static_cast<IntentKind::Enum>(kind);
+  }
+
+  inline Leg::Enum GetLeg() const {
+    return static_cast<Leg::Enum>(leg);
+  }
+
+  inline bool Known() const {
+    return kind != IntentKind::Unknown;
+  }
+
+  inline bool Closes() const {
+    return kind == IntentKind::Close || kind == IntentKind::ForceFlat;
+  }
+
+  // the hedge sent for a fill of this: same intent, on the hedge leg
+  inline OrderIntent Hedge() const {
+    return OrderIntent(Known() ? Kind() : IntentKind::Hedge, Leg::Hedge);
+  }
+
+  // the tag to send with
+  inline const std::string & Tag() const {
+    static const OrderTag::Enum tags[] = {OrderTag::Open, OrderTag::Open, OrderTag::Close, OrderTag::ForceFlatClose, OrderTag::StartOpen, OrderTag::HedgeOrder};
+    return OrderTag::Get(tags[kind]);
+  }
+
+  // the intent an order sent with tag tbd had. tags outside OrderTag
+  // count as a close if they say so, as the substring test used to
+  static OrderIntent FromTag(const char* tbd, Leg::Enum leg) {
+    static const IntentKind::Enum kinds[OrderTag::kCount] = {
+      IntentKind::Open,  // open
+      IntentKind::Close,  // close
+      IntentKind::ForceFlat,  // force_flat_close
+      IntentKind::Close,  // closeyes
+      IntentKind::StartOpen,  // startopen
+      IntentKind::StartOpen,  // sleepstartopen
+      IntentKind::Hedge,  // hedgeorder
+      IntentKind::Open,  // addopen
+      IntentKind::Open,  // addopennotalgn
+      IntentKind::Open,  // makeupopenformax
+      IntentKind::Open,  // makeupopenformaxnotalgn
+      IntentKind::Open,  // addopenforpos0
+      IntentKind::Open  // addopenforpos0notalgn
+    };
+    int t = OrderTag::Find(tbd);
+    if (t >= 0) {
+      return OrderIntent(kinds[t], leg);
+    }
+    return OrderIntent(strstr(tbd, "close") != nullptr ? IntentKind::Close : IntentKind::Unknown, leg);
+  }
+
+  uint8_t kind;
+  int8_t leg;
+};
+
+#endif  // STRATEGY_SRC_STRUCT_ORDER_INTENT_H_
@@ -0,0 +1,143 @@
+#ifndef STRATEGY_SRC_STRUCT_ORDER_OWNERS_H_
+#define STRATEGY_SRC_STRUCT_ORDER_OWNERS_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "struct/order.h"
+
+// working order -> owner index (a pair, a leg, ...) in one open addressed
+// array sized at setup, so Put/Find/Erase never allocate on the order
+// path the way an unordered_map node per order does. Reset pre-faults
+// it; once full, Put refuses and the caller treats the order as
+// untracked, as OrderIndex does
+class OrderOwners {
+ public:
+  OrderOwners()
+    : mask_(0),
+      size_(0),
+      limit_(0) {
+  }
+
+  // room for at least max_orders, keeping the load at or below a half
+  void Reset(size_t max_orders) {
+    size_t n = 16;
+    while (n < 2 * max_orders) {
+      n <<= 1;
+    }
+    slots_.assign(n, Slot());
+    mask_ = n - 1;
+    size_ = 0;
+    limit_ = n / 2;
+  }
+
+  void Clear() {
+    for (Slot & s : slots_) {
+      s.order = nullptr;
+    }
+    size_ = 0;
+  }
+
+  // false if full (or not Reset)
+  bool Put(Order* o, int owner) {
+    if (slots_.empty()) {
+      return false;
+    }
+    size_t i = Home(o);
+    while (slots_[i].order != nullptr && slots_[i].order != o) {
+      i = (i + 1) & mask_;
+    }
+    if (slots_[i].order == nullptr) {
+      if (size_ == limit_) {
+        return false;
+      }
+      size_++;
+    }
+    slots_[i].order = o;
+    slots_[i].owner = owner;
+    return true;
+  }
+
+  // -1 if not there
+  inline int Find(const Order* o) const {
+    if (slots_.empty()) {
+      return -1;
+    }
+    for (size_t i = Home(o); slots_[i].order != nullptr; i = (i + 1) & mask_) {
+      if (slots_[i].order == o) {
+        return slots_[i].owner;
+      }
+    }
+    return -1;
+  }
+
+  // the owner o had, -1 if not there. shifts the rest of the probe run
+  // back so no tombstones build up
+  int Erase(const Order* o) {
+    if (slots_.empty()) {
+      return -1;
+    }
+    size_t i = Home(o);
+    while (slots_[i].order != o) {
+      if (slots_[i].order == nullptr) {
+        return -1;
+      }
+      i = (i + 1) & mask_;
+    }
+    int owner = slots_[i].owner;
+    size_t j = i;
+    while (true) {
+      j = (j + 1) & mask_;
+      if (slots_[j].order == nullptr) {
+        break;
+      }
+      size_t home = Home(slots_[j].order);
+      // j's entry may move into the hole at i unless its home lies in (i, j]
+      if (((j - home) & mask_) >= ((j - i) & mask_)) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i].order = nullptr;
+    size_--;
+    return owner;
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+  // calls f(order, owner) for every entry, f may not Put or Erase
+  template <typename F>
+  void ForEach(F f) const {
+    for (const Slot & s : slots_) {
+      if (s.order != nullptr) {
+        f(s.order, s.owner);
+      }
+    }
+  }
+
+ private:
+  struct Slot {
+    Slot()
+      : order(nullptr),
+        owner(-1) {
+    }
+
+    Order* order;
+    int owner;
+  };
+
+  inline size_t Home(const Order* o) const {
+    uint64_t h = reinterpret_cast<uintptr_t>(o) * 0x9e3779b97f4a7c15ull;
+    return (h >> 32) & mask_;
+  }
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  size_t size_;
+  size_t limit_;
+};
+
+#endif  // STRATEGY_SRC_STRUCT_ORDER_OWNERS_H_
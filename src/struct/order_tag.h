@@ -0,0 +1,67 @@
+#ifndef STRATEGY_SRC_STRUCT_ORDER_TAG_H_
+#define STRATEGY_SRC_STRUCT_ORDER_TAG_H_
+
+#include <string.h>
+
+#include <string>
+
+// the tbd tags strategies send orders with, each built once. NewOrder and
+// PlaceOrder take the tag as a const std::string &, so a literal there
+// constructs a string per order, and the ones past the small string
+// buffer ("force_flat_close", "makeupopenformax", the notalgn variants)
+// cost a heap allocation every time
+struct OrderTag {
+  enum Enum {
+    Open = 0,
+    Close,
+    ForceFlatClose,
+    CloseYes,
+    StartOpen,
+    SleepStartOpen,
+    HedgeOrder,
+    AddOpen,
+    AddOpenNotAlgn,
+    MakeupOpenForMax,
+    MakeupOpenForMaxNotAlgn,
+    AddOpenForPos0,
+    AddOpenForPos0NotAlgn,
+    kCount
+  };
+
+  static inline const std::string & Get(Enum t) {
+    return Table()[t];
+  }
+
+  // the tag tbd is, -1 if none
+  static int Find(const char* tbd) {
+    const std::string* table = Table();
+    for (int t = 0; t < kCount; t++) {
+      if (strcmp(tbd, table[t].c_str()) == 0) {
+        return t;
+      }
+    }
+    return -1;
+  }
+
+ private:
+  static const std::string* Table() {
+    static const std::string table[kCount] = {
+      "open",
+      "close",
+      "force_flat_close",
+      "closeyes",
+      "startopen",
+      "sleepstartopen",
+      "hedgeorder",
+      "addopen",
+      "addopennotalgn",
+      "makeupopenformax",
+      "makeupopenformaxnotalgn",
+      "addopenforpos0",
+      "addopenforpos0notalgn"
+    };
+    return table;
+  }
+};
+
+#endif  // STRATEGY_SRC_STRUCT_ORDER_TAG_H_
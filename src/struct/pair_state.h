@@ -0,0 +1,219 @@
+#ifndef STRATEGY_SRC_STRUCT_PAIR_STATE_H_
+#define STRATEGY_SRC_STRUCT_PAIR_STATE_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "struct/market_snapshot.h"
+#include "struct/order.h"
+#include "util/ticker_table.h"
+
+struct Leg {
+  enum Enum {
+    Unknown = -1,
+    Main = 0,
+    Hedge = 1
+  };
+};
+
+// top of book of one leg, one cache line. decision code reads this
+// instead of the ~300 byte MarketSnapshot it was taken from
+struct alignas(64) L1Quote {
+  double bid;
+  double ask;
+  double mid;
+  double spread;
+  int bid_size;
+  int ask_size;
+  timeval time;
+  bool good;  // MarketSnapshot::IsGood at the time
+
+  inline void Set(const MarketSnapshot & shot) {
+    bid = shot.bids[0];
+    ask = shot.asks[0];
+    mid = (bid + ask) / 2;
+    spread = ask - bid;
+    bid_size = shot.bid_sizes[0];
+    ask_size = shot.ask_sizes[0];
+    time = shot.time;
+    good = shot.IsGood();
+  }
+};
+
+static_assert(sizeof(L1Quote) == 64, "L1Quote is one cache line");
+
+// one leg of a pair, pointing straight into the BaseStrategy maps. prices
+// come from quote, refreshed by PairState::OnShot; shot is the full record
+struct LegState {
+  LegState()
+    : id(kNoTicker),
+      quote(nullptr),
+      shot(nullptr),
+      next_shot(nullptr),
+      pos(nullptr),
+      avgcost(nullptr) {
+  }
+
+  inline double Bid() const {
+    return quote->bid;
+  }
+
+  inline double Ask() const {
+    return quote->ask;
+  }
+
+  inline int BidSize() const {
+    return quote->bid_size;
+  }
+
+  inline int AskSize() const {
+    return quote->ask_size;
+  }
+
+  inline double Mid() const {
+    return quote->mid;
+  }
+
+  inline double Spread() const {
+    return quote->spread;
+  }
+
+  // price that crosses the book for `side`
+  inline double Take(OrderSide::Enum side) const {
+    return (side == OrderSide::Buy) ? quote->ask : quote->bid;
+  }
+
+  inline double NextTake(OrderSide::Enum side) const {
+    return (side == OrderSide::Buy) ? next_shot->asks[0] : next_shot->bids[0];
+  }
+
+  std::string ticker;
+  TickerId id;
+  const L1Quote* quote;
+  MarketSnapshot* shot;
+  MarketSnapshot* next_shot;
+  int* pos;
+  double* avgcost;
+};
+
+// main/hedge legs resolved once, so the tick path never hashes a ticker.
+// unordered_map nodes are stable, the pointers only go stale if a map is
+// cleared: call BindPosition again after clearing m_position_map/m_avgcost_map.
+// both legs' quotes sit in one aligned two-line block (the strategy itself
+// may be heap allocated without over-alignment under c++11)
+class PairState {
+ public:
+  PairState()
+    : quotes_(nullptr) {
+    if (posix_memalign(reinterpret_cast<void**>(&quotes_), sizeof(L1Quote), 2 * sizeof(L1Quote)) != 0) {
+      printf("pair quote alloc failed\n");
+      exit(1);
+    }
+    memset(static_cast<void*>(quotes_), 0, 2 * sizeof(L1Quote));
+    for (int i = 0; i < 2; i++) {
+      legs_[i].quote = &quotes_[i];
+    }
+  }
+
+  ~PairState() {
+    free(quotes_);
+  }
+
+  PairState(const PairState&) = delete;
+  PairState& operator=(const PairState&) = delete;
+
+  void Bind(const std::string & main_ticker,
+            const std::string & hedge_ticker,
+            std::unordered_map<std::string, MarketSnapshot>* shot_map,
+            std::unordered_map<std::string, MarketSnapshot>* next_shot_map,
+            std::unordered_map<std::string, int>* position_map,
+            std::unordered_map<std::string, double>* avgcost_map) {
+    legs_[Leg::Main].ticker = main_ticker;
+    legs_[Leg::Hedge].ticker = hedge_ticker;
+    for (int i = 0; i < 2; i++) {
+      legs_[i].id = TickerTable::Intern(legs_[i].ticker);
+      legs_[i].shot = &(*shot_map)[legs_[i].ticker];
+      legs_[i].next_shot = &(*next_shot_map)[legs_[i].ticker];
+      quotes_[i].Set(*legs_[i].shot);
+    }
+    BindPosition(position_map, avgcost_map);
+  }
+
+  // refresh the quote of the shot's leg, first thing in
+  // DoOperationAfterUpdateData. returns the leg, Unknown for other tickers.
+  // the leg is found by id if the shot was routed under one (see
+  // core/routed_strategy.h), by name under kNoTicker
+  inline Leg::Enum OnShot(const MarketSnapshot & shot, TickerId id) {
+    Leg::Enum leg = (id != kNoTicker) ? LegOf(id) : LegOf(shot.ticker);
+    if (leg != Leg::Unknown) {
+      quotes_[leg].Set(shot);
+    }
+    return leg;
+  }
+
+  void BindPosition(std::unordered_map<std::string, int>* position_map,
+                    std::unordered_map<std::string, double>* avgcost_map) {
+    for (int i = 0; i < 2; i++) {
+      legs_[i].pos = &(*position_map)[legs_[i].ticker];
+      legs_[i].avgcost = &(*avgcost_map)[legs_[i].ticker];
+    }
+  }
+
+  inline LegState& operator[](int leg) {
+    return legs_[leg];
+  }
+
+  inline const LegState& operator[](int leg) const {
+    return legs_[leg];
+  }
+
+  inline Leg::Enum LegOf(TickerId id) const {
+    if (id == legs_[Leg::Main].id) {
+      return Leg::Main;
+    }
+    if (id == legs_[Leg::Hedge].id) {
+      return Leg::Hedge;
+    }
+    return Leg::Unknown;
+  }
+
+  inline Leg::Enum LegOf(const char* ticker) const {
+    if (strcmp(ticker, legs_[Leg::Main].ticker.c_str()) == 0) {
+      return Leg::Main;
+    }
+    if (strcmp(ticker, legs_[Leg::Hedge].ticker.c_str()) == 0) {
+      return Leg::Hedge;
+    }
+    return Leg::Unknown;
+  }
+
+  inline Leg::Enum LegOf(const std::string & ticker) const {
+    if (ticker.size() == legs_[Leg::Main].ticker.size() && ticker == legs_[Leg::Main].ticker) {
+      return Leg::Main;
+    }
+    if (ticker.size() == legs_[Leg::Hedge].ticker.size() && ticker == legs_[Leg::Hedge].ticker) {
+      return Leg::Hedge;
+    }
+    return Leg::Unknown;
+  }
+
+  // main mid - hedge mid
+  inline double MidDiff() const {
+    return legs_[Leg::Main].Mid() - legs_[Leg::Hedge].Mid();
+  }
+
+  inline double SpreadSum() const {
+    return legs_[Leg::Main].Spread() + legs_[Leg::Hedge].Spread();
+  }
+
+ private:
+  L1Quote* quotes_;
+  LegState legs_[2];
+};
+
+#endif  // STRATEGY_SRC_STRUCT_PAIR_STATE_H_
@@ -0,0 +1,17 @@
+#ifndef STRATEGY_SRC_STRUCT_RUN_STATS_H_
+#define STRATEGY_SRC_STRUCT_RUN_STATS_H_
+
+// what an offline run of one strategy amounts to
+struct RunStats {
+  RunStats()
+    : pnl(0.0),
+      rounds(0),
+      fills(0) {
+  }
+
+  double pnl;  // net of fees, summed over closed rounds
+  int rounds;
+  int fills;
+};
+
+#endif  // STRATEGY_SRC_STRUCT_RUN_STATS_H_
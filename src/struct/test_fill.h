@@ -0,0 +1,34 @@
+#ifndef STRATEGY_SRC_STRUCT_TEST_FILL_H_
+#define STRATEGY_SRC_STRUCT_TEST_FILL_H_
+
+#include <string.h>
+
+#include "struct/order.h"
+#include "struct/exchange_info.h"
+
+// bounded, always terminated copy between the fixed char fields of
+// Order and ExchangeInfo, what snprintf(dst, N, "%s", src) did without
+// going through the format parser
+template <size_t N>
+inline void CopyField(char (&dst)[N], const char* src, size_t src_size) {
+  size_t n = strnlen(src, src_size < N - 1 ? src_size : N - 1);
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+// the fill a test mode strategy books for an order it just sent: all of
+// it at the order's price
+inline void MakeTestFill(const Order & o, ExchangeInfo* info) {
+  static const char kReason[] = "test";
+  info->shot_time = o.shot_time;
+  info->show_time = o.shot_time;
+  info->type = InfoType::Filled;
+  info->trade_size = o.size;
+  info->trade_price = o.price;
+  info->side = o.side;
+  CopyField(info->order_ref, o.order_ref, sizeof(o.order_ref));
+  CopyField(info->ticker, o.ticker, sizeof(o.ticker));
+  CopyField(info->reason, kReason, sizeof(kReason));
+}
+
+#endif  // STRATEGY_SRC_STRUCT_TEST_FILL_H_
@@ -0,0 +1,83 @@
+#ifndef STRATEGY_SRC_UTIL_AS_OF_ALIGNER_H_
+#define STRATEGY_SRC_UTIL_AS_OF_ALIGNER_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "struct/pair_state.h"
+
+// as-of join of the two legs of a pair: keeps the newest quote time per
+// leg and, on every new quote, reports whether it pairs with the other
+// leg's newest quote, i.e. they are less than the tolerance apart in true
+// time (a second boundary in between does not matter). a repeated stamp
+// on the same leg is not a new quote and never pairs
+class AsOfAligner {
+ public:
+  static const int64_t kDefaultToleranceUsec = 100000;
+
+  explicit AsOfAligner(int64_t tolerance_usec = kDefaultToleranceUsec)
+    : tolerance_usec_(tolerance_usec),
+      aligned_(false),
+      matched_(0),
+      dropped_(0),
+      repeated_(0) {
+    last_usec_[Leg::Main] = last_usec_[Leg::Hedge] = kNever;
+  }
+
+  void SetTolerance(int64_t usec) {
+    tolerance_usec_ = usec;
+  }
+
+  // one quote on leg, true if it makes an aligned pair. Leg::Unknown
+  // (not one of ours) only clears Aligned()
+  inline bool Update(Leg::Enum leg, const timeval & t) {
+    aligned_ = false;
+    if (leg == Leg::Unknown) {
+      return false;
+    }
+    int64_t usec = static_cast<int64_t>(t.tv_sec) * 1000000 + t.tv_usec;
+    if (usec == last_usec_[leg]) {
+      repeated_++;
+      return false;
+    }
+    last_usec_[leg] = usec;
+    int64_t other = last_usec_[1 - leg];
+    aligned_ = (other != kNever && llabs(usec - other) < tolerance_usec_);
+    if (aligned_) {
+      matched_++;
+    } else {
+      dropped_++;
+    }
+    return aligned_;
+  }
+
+  // what the latest Update returned
+  inline bool Aligned() const {
+    return aligned_;
+  }
+
+  uint64_t Matched() const {
+    return matched_;
+  }
+
+  uint64_t Dropped() const {
+    return dropped_;
+  }
+
+  uint64_t Repeated() const {
+    return repeated_;
+  }
+
+ private:
+  static const int64_t kNever = INT64_MIN;
+
+  int64_t tolerance_usec_;
+  int64_t last_usec_[2];
+  bool aligned_;
+  uint64_t matched_;
+  uint64_t dropped_;
+  uint64_t repeated_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_AS_OF_ALIGNER_H_
@@ -0,0 +1,238 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <new>
+#include <string>
+
+#include "util/async_logger.h"
+
+static_assert(sizeof(LogRecord) == kLogRecordSize, "LogRecord layout");
+
+LogRing::LogRing()
+  : head_(0),
+    tail_cache_(0),
+    tail_(0),
+    head_cache_(0),
+    dropped_(0) {
+}
+
+LogRecord* LogRing::Claim() {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_cache_ >= kCapacity) {
+    head_cache_ = head_.load(std::memory_order_acquire);
+    if (tail - head_cache_ >= kCapacity) {
+      dropped_++;
+      return nullptr;
+    }
+  }
+  return &records_[tail & (kCapacity - 1)];
+}
+
+void LogRing::Publish() {
+  tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool LogRing::Pop(LogRecord* r) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (head == tail_cache_) {
+    tail_cache_ = tail_.load(std::memory_order_acquire);
+    if (head == tail_cache_) {
+      return false;
+    }
+  }
+  memcpy(r, &records_[head & (kCapacity - 1)], sizeof(LogRecord));
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+AsyncLogger& AsyncLogger::Instance() {
+  static AsyncLogger logger;
+  return logger;
+}
+
+AsyncLogger::AsyncLogger()
+  : out_(stdout),
+    running_(true) {
+  thread_ = std::thread(&AsyncLogger::Loop, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  Drain();
+  fflush(out_);
+  if (out_ != stdout) {
+    fclose(out_);
+  }
+  // rings stay alive: a detached thread may still hold its pointer
+}
+
+bool AsyncLogger::Open(const std::string & path) {
+  FILE* f = fopen(path.c_str(), "a");
+  if (f == nullptr) {
+    printf("open log file %s failed\n", path.c_str());
+    return false;
+  }
+  Flush();
+  std::lock_guard<std::mutex> lock(drain_mutex_);
+  if (out_ != stdout) {
+    fclose(out_);
+  }
+  out_ = f;
+  return true;
+}
+
+LogRing* AsyncLogger::NewRing() {
+  void* p = nullptr;
+  if (posix_memalign(&p, 64, sizeof(LogRing)) != 0) {
+    printf("log ring alloc failed\n");
+    exit(1);
+  }
+  LogRing* ring = new(p) LogRing();
+  std::lock_guard<std::mutex> lock(mutex_);
+  rings_.push_back(ring);
+  return ring;
+}
+
+// writes without mutex_, so a slow disk never holds up a thread's first
+// log in NewRing
+bool AsyncLogger::Drain() {
+  std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    draining_.assign(rings_.begin(), rings_.end());
+  }
+  LogRecord r;
+  char line[1024];
+  bool busy = false;
+  for (auto ring : draining_) {
+    while (ring->Pop(&r)) {
+      size_t n = Format(r, line, sizeof(line));
+      fwrite(line, 1, n, out_);
+      busy = true;
+    }
+  }
+  if (busy) {
+    fflush(out_);
+  }
+  return busy;
+}
+
+void AsyncLogger::Loop() {
+  while (running_) {
+    if (!Drain()) {
+      usleep(200);
+    }
+  }
+}
+
+void AsyncLogger::Flush() {
+  while (Drain()) {
+  }
+}
+
+long AsyncLogger::Dropped() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  long dropped = 0;
+  for (auto ring : rings_) {
+    dropped += ring->Dropped();
+  }
+  return dropped;
+}
+
+// printf the captured args one conversion at a time, the length modifiers
+// of the call site are replaced by the width of the captured slot
+size_t AsyncLogger::Format(const LogRecord& r, char* out, size_t n) {
+  const char* p = r.site->fmt;
+  size_t len = 0;
+  int arg = 0;
+  char spec[32];
+  char str[sizeof(r.str) + 1];
+  while (*p != '\0' && len + 1 < n) {
+    if (*p != '%') {
+      out[len++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[len++] = '%';
+      p += 2;
+      continue;
+    }
+    const char* start = p++;
+    size_t s = 0;
+    spec[s++] = '%';
+    while (*p != '\0' && strchr("-+ #0123456789.", *p) != nullptr && s < sizeof(spec) - 4) {
+      spec[s++] = *p++;
+    }
+    while (*p != '\0' && strchr("hlLqjzt", *p) != nullptr) {
+      p++;
+    }
+    char conv = *p;
+    if (conv == '\0' || arg >= r.nargs) {  // malformed or missing arg, keep it literal
+      size_t keep = (conv == '\0') ? p - start : p + 1 - start;
+      keep = keep < n - 1 - len ? keep : n - 1 - len;
+      memcpy(out + len, start, keep);
+      len += keep;
+      p = (conv == '\0') ? p : p + 1;
+      continue;
+    }
+    p++;
+    uint8_t type = r.types[arg];
+    const auto& a = r.args[arg++];
+    int written = 0;
+    switch (conv) {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+      case 'c': {
+        if (conv != 'c') {
+          spec[s++] = 'l';
+          spec[s++] = 'l';
+        }
+        spec[s++] = conv;
+        spec[s] = '\0';
+        long long v = (type == LogArgType::Double) ? static_cast<long long>(a.d) : a.i;
+        written = snprintf(out + len, n - len, spec, v);
+        break;
+      }
+      case 's': {
+        spec[s++] = 's';
+        spec[s] = '\0';
+        if (type == LogArgType::String) {
+          memcpy(str, r.str + a.s.off, a.s.len);
+          str[a.s.len] = '\0';
+        } else {
+          snprintf(str, sizeof(str), "%s", "(nonstr)");
+        }
+        written = snprintf(out + len, n - len, spec, str);
+        break;
+      }
+      case 'p':
+        spec[s++] = 'p';
+        spec[s] = '\0';
+        written = snprintf(out + len, n - len, spec, a.p);
+        break;
+      default: {  // f e g a and friends
+        spec[s++] = conv;
+        spec[s] = '\0';
+        double v = a.d;
+        if (type == LogArgType::Int) {
+          v = static_cast<double>(a.i);
+        } else if (type == LogArgType::Uint) {
+          v = static_cast<double>(a.u);
+        }
+        written = snprintf(out + len, n - len, spec, v);
+        break;
+      }
+    }
+    if (written > 0) {
+      len += (static_cast<size_t>(written) < n - len) ? written : n - 1 - len;
+    }
+  }
+  return len;
+}
@@ -0,0 +1,223 @@
+#ifndef STRATEGY_SRC_UTIL_ASYNC_LOGGER_H_
+#define STRATEGY_SRC_UTIL_ASYNC_LOGGER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct LogLevel {
+  enum Enum {
+    Debug = 0,
+    Info,
+    Warn,
+    Error
+  };
+};
+
+// call sites below this level are compiled out, build with -DSTRAT_LOG_LEVEL=0 to get the tick logs
+#ifndef STRAT_LOG_LEVEL
+#define STRAT_LOG_LEVEL 1
+#endif
+
+// one static instance per call site, its address is the format id
+struct LogSite {
+  const char* fmt;
+  int level;
+};
+
+static const int kMaxLogArgs = 12;
+static const int kLogRecordSize = 256;
+
+struct LogArgType {
+  enum Enum {
+    Int = 0,
+    Uint,
+    Double,
+    String,
+    Pointer
+  };
+};
+
+// printf arguments captured raw, strings are copied into str
+struct LogRecord {
+  const LogSite* site;
+  uint8_t nargs;
+  uint8_t str_used;
+  uint8_t types[kMaxLogArgs];
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const void* p;
+    struct {
+      uint16_t off;
+      uint16_t len;
+    } s;
+  } args[kMaxLogArgs];
+  char str[kLogRecordSize - 24 - 8 * kMaxLogArgs];
+};
+
+// single producer single consumer ring, one per logging thread
+class LogRing {
+ public:
+  LogRing();
+  LogRecord* Claim();
+  void Publish();
+  bool Pop(LogRecord* r);
+  long Dropped() const {
+    return dropped_;
+  }
+
+ private:
+  static const size_t kCapacity = 8192;
+  alignas(64) std::atomic<size_t> head_;
+  size_t tail_cache_;
+  alignas(64) std::atomic<size_t> tail_;
+  size_t head_cache_;
+  long dropped_;
+  LogRecord records_[kCapacity];
+};
+
+namespace logdetail {
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type Put(LogRecord* r, const T& v) {
+  r->types[r->nargs] = LogArgType::Int;
+  r->args[r->nargs++].i = v;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type Put(LogRecord* r, const T& v) {
+  r->types[r->nargs] = LogArgType::Uint;
+  r->args[r->nargs++].u = v;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_enum<T>::value>::type Put(LogRecord* r, const T& v) {
+  r->types[r->nargs] = LogArgType::Int;
+  r->args[r->nargs++].i = static_cast<int64_t>(v);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type Put(LogRecord* r, const T& v) {
+  r->types[r->nargs] = LogArgType::Double;
+  r->args[r->nargs++].d = v;
+}
+
+inline void PutString(LogRecord* r, const char* v, size_t len) {
+  size_t room = sizeof(r->str) - r->str_used;
+  len = len < room ? len : room;
+  memcpy(r->str + r->str_used, v, len);
+  r->types[r->nargs] = LogArgType::String;
+  r->args[r->nargs].s.off = r->str_used;
+  r->args[r->nargs++].s.len = len;
+  r->str_used += len;
+}
+
+inline void Put(LogRecord* r, const char* v) {
+  PutString(r, v ? v : "(null)", v ? strlen(v) : 6);
+}
+
+template <size_t N>
+inline void Put(LogRecord* r, const char (&v)[N]) {
+  PutString(r, v, strnlen(v, N));
+}
+
+inline void Put(LogRecord* r, const std::string& v) {
+  PutString(r, v.data(), v.size());
+}
+
+template <typename T>
+inline void Put(LogRecord* r, T* const& v) {
+  r->types[r->nargs] = LogArgType::Pointer;
+  r->args[r->nargs++].p = v;
+}
+
+inline void Put(LogRecord* r, char* const& v) {
+  Put(r, static_cast<const char*>(v));
+}
+
+}  // namespace logdetail
+
+// the tick thread only copies the site and raw args into its LogRing,
+// a background thread formats and writes them out. a thread's ring is
+// allocated on its first log, call Register on a tick thread at setup so
+// that isn't a tick
+class AsyncLogger {
+ public:
+  static AsyncLogger& Instance();
+
+  template <typename... Args>
+  inline void Log(const LogSite* site, const Args&... args) {
+    static_assert(sizeof...(Args) <= kMaxLogArgs, "too many log args");
+    LogRing* ring = LocalRing();
+    LogRecord* r = ring->Claim();
+    if (r == nullptr) {  // consumer fell behind, never block the caller
+      return;
+    }
+    r->site = site;
+    r->nargs = 0;
+    r->str_used = 0;
+    int expand[] = {0, (logdetail::Put(r, args), 0)...};
+    (void)expand;
+    ring->Publish();
+  }
+
+  // allocate the calling thread's ring now, a no-op once it has one
+  inline void Register() {
+    LocalRing();
+  }
+
+  // default output is stdout
+  bool Open(const std::string & path);
+  // wait until every queued record is written
+  void Flush();
+  long Dropped();
+
+  static size_t Format(const LogRecord& r, char* out, size_t n);
+
+ private:
+  AsyncLogger();
+  ~AsyncLogger();
+
+  inline LogRing* LocalRing() {
+    static thread_local LogRing* ring = nullptr;
+    if (ring == nullptr) {
+      ring = NewRing();
+    }
+    return ring;
+  }
+
+  LogRing* NewRing();
+  bool Drain();
+  void Loop();
+
+  std::mutex mutex_;  // rings_, held only to add or copy the list
+  std::vector<LogRing*> rings_;
+  std::mutex drain_mutex_;  // one consumer per ring at a time, out_ and draining_
+  std::vector<LogRing*> draining_;
+  FILE* out_;
+  std::atomic<bool> running_;
+  std::thread thread_;
+};
+
+#define SLOG(lvl, fmt, ...) do { \
+  if ((lvl) >= STRAT_LOG_LEVEL) { \
+    static const LogSite slog_site = {fmt, lvl}; \
+    AsyncLogger::Instance().Log(&slog_site, ##__VA_ARGS__); \
+  } \
+} while (0)
+
+#define SLOG_DEBUG(fmt, ...) SLOG(LogLevel::Debug, fmt, ##__VA_ARGS__)
+#define SLOG_INFO(fmt, ...) SLOG(LogLevel::Info, fmt, ##__VA_ARGS__)
+#define SLOG_WARN(fmt, ...) SLOG(LogLevel::Warn, fmt, ##__VA_ARGS__)
+#define SLOG_ERROR(fmt, ...) SLOG(LogLevel::Error, fmt, ##__VA_ARGS__)
+
+#endif  // STRATEGY_SRC_UTIL_ASYNC_LOGGER_H_
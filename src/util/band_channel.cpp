@@ -0,0 +1,182 @@
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "util/band_channel.h"
+
+namespace {
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the band layout the UI has always read
+void ToSnapshot(const BandState & s, const char* label, MarketSnapshot* shot) {
+  snprintf(shot->ticker, sizeof(shot->ticker), "%s", label);
+  shot->time = s.time;
+  shot->bids[0] = s.down - s.spread / 2;
+  shot->bids[1] = s.stop_loss_down;
+  shot->bids[2] = s.mean - s.spread / 2;
+  shot->asks[0] = s.up + s.spread / 2;
+  shot->asks[1] = s.stop_loss_up;
+  shot->asks[2] = s.mean + s.spread / 2;
+  shot->bids[3] = s.main_bid;
+  shot->asks[3] = s.main_ask;
+  shot->bids[4] = s.hedge_bid;
+  shot->asks[4] = s.hedge_ask;
+  shot->bid_sizes[3] = s.main_bid_size;
+  shot->ask_sizes[3] = s.main_ask_size;
+  shot->bid_sizes[4] = s.hedge_bid_size;
+  shot->ask_sizes[4] = s.hedge_ask_size;
+  shot->open_interest = s.mean;
+  shot->last_trade = s.mid;
+}
+
+// every Send, from the publisher or the strategy, one at a time
+class SharedSender : public BaseSender<MarketSnapshot> {
+ public:
+  explicit SharedSender(BaseSender<MarketSnapshot>* sender)
+    : sender_(sender) {
+  }
+
+  void Send(const MarketSnapshot & shot) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sender_->Send(shot);
+  }
+
+ private:
+  BaseSender<MarketSnapshot>* sender_;
+  std::mutex mutex_;
+};
+
+}  // namespace
+
+// owns the thread; channels come and go under mutex_, which the trading
+// threads never take
+class BandPublisher {
+ public:
+  static BandPublisher & Instance() {
+    static BandPublisher publisher;
+    return publisher;
+  }
+
+  void Add(BandChannel* c) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels_.emplace_back(c);
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&BandPublisher::Loop, this);
+    }
+    cv_.notify_one();
+  }
+
+  void Remove(BandChannel* c) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels_.erase(std::remove(channels_.begin(), channels_.end(), c), channels_.end());
+  }
+
+  // at setup only, the lock may be held across a publish
+  BaseSender<MarketSnapshot>* Share(BaseSender<MarketSnapshot>* sender) {
+    if (dynamic_cast<SharedSender*>(sender) != nullptr) {
+      return sender;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_ptr<SharedSender> & shared = shared_[sender];
+    if (!shared) {
+      shared.reset(new SharedSender(sender));
+    }
+    return shared.get();
+  }
+
+ private:
+  BandPublisher()
+    : stop_(false) {
+  }
+
+  ~BandPublisher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  void Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    BandState state;
+    MarketSnapshot shot;
+    while (!stop_) {
+      int64_t now = NowNs();
+      int64_t next = now + kIdleNs;
+      for (BandChannel* c : channels_) {
+        if (now >= c->due_ns_) {
+          uint64_t version = c->slot_.Version();
+          if (version != 0 && version != c->sent_version_) {
+            c->sent_version_ = c->slot_.Load(&state);
+            ToSnapshot(state, c->label_, &shot);
+            c->sender_->Send(shot);
+          }
+          c->due_ns_ = now + c->period_ns_;
+        }
+        next = std::min(next, c->due_ns_);
+      }
+      cv_.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>(next - NowNs(), 0)));
+    }
+  }
+
+  static const int64_t kIdleNs = 100000000;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<BandChannel*> channels_;
+  std::unordered_map<BaseSender<MarketSnapshot>*, std::unique_ptr<SharedSender> > shared_;
+  std::thread thread_;
+  bool stop_;
+};
+
+BandChannel::BandChannel()
+  : sender_(nullptr),
+    period_ns_(0),
+    due_ns_(0),
+    sent_version_(0),
+    open_(false) {
+  label_[0] = '\0';
+}
+
+BandChannel::~BandChannel() {
+  Close();
+}
+
+BaseSender<MarketSnapshot>* BandChannel::Share(BaseSender<MarketSnapshot>* sender) {
+  return sender == nullptr ? nullptr : BandPublisher::Instance().Share(sender);
+}
+
+void BandChannel::Open(const std::string & label, BaseSender<MarketSnapshot>* sender, double hz) {
+  Close();
+  if (hz <= 0 || sender == nullptr) {
+    return;
+  }
+  snprintf(label_, sizeof(label_), "%s", label.c_str());
+  sender_ = Share(sender);
+  period_ns_ = static_cast<int64_t>(1e9 / hz);
+  due_ns_ = 0;
+  sent_version_ = 0;
+  open_ = true;
+  BandPublisher::Instance().Add(this);
+}
+
+void BandChannel::Close() {
+  if (open_) {
+    BandPublisher::Instance().Remove(this);
+    open_ = false;
+  }
+}
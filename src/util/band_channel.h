@@ -0,0 +1,56 @@
+#ifndef STRATEGY_SRC_UTIL_BAND_CHANNEL_H_
+#define STRATEGY_SRC_UTIL_BAND_CHANNEL_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "struct/band_state.h"
+#include "struct/market_snapshot.h"
+#include "util/seqlock.h"
+#include "util/zmq_sender.hpp"
+
+// a strategy's UI telemetry. Post only stores into a seqlock'd slot, a
+// single background publisher thread shared by all channels picks up the
+// latest state at most hz times a second and sends it as the band
+// MarketSnapshot the UI reads. states posted in between are conflated.
+// the publisher sends from its own thread, so a channel never sends on a
+// bare sender: Open wraps it in the one shared sender of Share, whose
+// Send holds a mutex. a strategy replaces its m_ui_sender with Share's,
+// so anything it sends itself is serialized with the publisher; nothing
+// may send on the bare sender while a channel on it is open
+class BandChannel {
+ public:
+  BandChannel();
+  ~BandChannel();
+
+  BandChannel(const BandChannel&) = delete;
+  BandChannel& operator=(const BandChannel&) = delete;
+
+  // the locked sender in front of sender, the same one for every caller,
+  // lives as long as the process. sender itself if it is already one
+  static BaseSender<MarketSnapshot>* Share(BaseSender<MarketSnapshot>* sender);
+
+  // start publishing under label through Share(sender), hz <= 0 or no
+  // sender leaves it closed
+  void Open(const std::string & label, BaseSender<MarketSnapshot>* sender, double hz);
+  void Close();
+
+  inline void Post(const BandState & state) {
+    slot_.Store(state);
+  }
+
+ private:
+  friend class BandPublisher;
+
+  SeqLock<BandState> slot_;
+  // below here only the publisher thread touches, under its lock
+  char label_[MAX_TICKER_LENGTH];
+  BaseSender<MarketSnapshot>* sender_;
+  int64_t period_ns_;
+  int64_t due_ns_;
+  uint64_t sent_version_;
+  bool open_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_BAND_CHANNEL_H_
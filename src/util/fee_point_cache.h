@@ -0,0 +1,90 @@
+#ifndef STRATEGY_SRC_UTIL_FEE_POINT_CACHE_H_
+#define STRATEGY_SRC_UTIL_FEE_POINT_CACHE_H_
+
+#include <math.h>
+
+#include <string>
+
+#include "util/contract_worker.h"
+
+// one leg's round-trip (open + close) fee in price points for one lot,
+// modelled as fixed + rate * mid. the two parts are fitted from a pair of
+// CalFeePoint calls around the mid and reused until the mid leaves the
+// tolerance band of the fit, or the schedule is invalidated
+class FeePointCache {
+ public:
+  explicit FeePointCache(double tolerance = 0.05)
+    : cw_(nullptr),
+      no_close_today_(false),
+      tolerance_(tolerance),
+      fit_mid_(0.0),
+      fixed_(0.0),
+      rate_(0.0),
+      fits_(0) {
+  }
+
+  void Bind(ContractWorker* cw, const std::string & name, bool no_close_today) {
+    cw_ = cw;
+    name_ = name;
+    no_close_today_ = no_close_today;
+    Invalidate();
+  }
+
+  // relative mid move that forces a refit
+  void SetTolerance(double tolerance) {
+    tolerance_ = tolerance;
+    Invalidate();
+  }
+
+  // call when the contract's fee schedule is reloaded
+  void Invalidate() {
+    fit_mid_ = 0.0;
+  }
+
+  inline double RoundTrip(double mid) {
+    if (mid <= 0.0) {  // no quote yet, nothing to fit around
+      return Direct(mid);
+    }
+    if (fit_mid_ <= 0.0 || fabs(mid - fit_mid_) > tolerance_ * fit_mid_) {
+      Fit(mid);
+    }
+    return fixed_ + rate_ * mid;
+  }
+
+  int Fits() const {
+    return fits_;
+  }
+
+ private:
+  static constexpr double kMinProbe = 1e-3;
+
+  inline double Direct(double mid) {
+    FeePoint p = cw_->CalFeePoint(name_, mid, 1, mid, 1, no_close_today_);
+    return p.open_fee_point + p.close_fee_point;
+  }
+
+  void Fit(double mid) {
+    double step = tolerance_;
+    if (step < kMinProbe) {
+      step = kMinProbe;
+    }
+    double probe = mid * (1.0 + step);
+    double at_mid = Direct(mid);
+    double at_probe = Direct(probe);
+    rate_ = (at_probe - at_mid) / (probe - mid);
+    fixed_ = at_mid - rate_ * mid;
+    fit_mid_ = mid;
+    fits_++;
+  }
+
+  ContractWorker* cw_;
+  std::string name_;
+  bool no_close_today_;
+  double tolerance_;
+  double fit_mid_;
+  double fixed_;
+  double rate_;
+  int fits_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_FEE_POINT_CACHE_H_
@@ -0,0 +1,144 @@
+#ifndef STRATEGY_SRC_UTIL_LATENCY_HISTOGRAM_H_
+#define STRATEGY_SRC_UTIL_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "util/tsc.h"
+
+// latency probes are compiled in with -DSTRAT_LATENCY=1, otherwise the
+// macros below are empty and the histograms stay empty
+#ifndef STRAT_LATENCY
+#define STRAT_LATENCY 0
+#endif
+
+#if STRAT_LATENCY
+#define LATENCY_STAMP(stamp) ((stamp) = TscNow())
+#define LATENCY_RECORD(hist, stamp) ((hist).Record(TscNow() - (stamp)))
+#else
+#define LATENCY_STAMP(stamp) ((void)0)
+#define LATENCY_RECORD(hist, stamp) ((void)0)
+#endif
+
+// log-linear histogram of tsc deltas, HDR style: values below 32 are
+// exact, above that every power of two is cut into 16 bins, so any
+// percentile is within ~6%. fixed size, Record never allocates
+class LatencyHistogram {
+ public:
+  static const int kSubBits = 4;
+  static const int kSub = 1 << kSubBits;
+  static const int kBins = (64 - kSubBits + 1) * kSub;
+
+  LatencyHistogram() {
+    Reset();
+  }
+
+  void Reset() {
+    memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+  }
+
+  inline void Record(uint64_t ticks) {
+    counts_[Bin(ticks)]++;
+    count_++;
+    sum_ += ticks;
+    if (ticks > max_) {
+      max_ = ticks;
+    }
+  }
+
+  uint64_t Count() const {
+    return count_;
+  }
+
+  double MeanNs() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_) / count_ * TscNsPerTick();
+  }
+
+  double MaxNs() const {
+    return max_ * TscNsPerTick();
+  }
+
+  // upper edge of the bin holding the q quantile, q in [0, 1]
+  double PercentileNs(double q) const {
+    if (count_ == 0) {
+      return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * count_);
+    if (rank >= count_) {
+      rank = count_ - 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < kBins; i++) {
+      seen += counts_[i];
+      if (seen > rank) {
+        uint64_t upper = Lower(i + 1) - 1;
+        return (upper < max_ ? upper : max_) * TscNsPerTick();
+      }
+    }
+    return MaxNs();
+  }
+
+  void Dump(FILE* f, const char* name) const {
+    fprintf(f, "%s: n=%lu mean=%.0lf p50=%.0lf p90=%.0lf p99=%.0lf p99.9=%.0lf max=%.0lf ns\n", name, static_cast<unsigned long>(count_), MeanNs(), PercentileNs(0.5), PercentileNs(0.9), PercentileNs(0.99), PercentileNs(0.999), MaxNs());
+  }
+
+ private:
+  static inline int Bin(uint64_t v) {
+    if (v < 2 * kSub) {
+      return static_cast<int>(v);
+    }
+    int shift = (63 - __builtin_clzll(v)) - kSubBits;
+    return (shift + 1) * kSub + static_cast<int>((v >> shift) - kSub);
+  }
+
+  // smallest value of bin i
+  static inline uint64_t Lower(int i) {
+    if (i < 2 * kSub) {
+      return i;
+    }
+    int shift = i / kSub - 1;
+    if (shift > 63 - kSubBits) {
+      return UINT64_MAX;
+    }
+    return static_cast<uint64_t>(kSub + i % kSub) << shift;
+  }
+
+  uint64_t counts_[kBins];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+};
+
+// where a pair strategy spends its reaction time: snapshot arrival to an
+// order going out on each leg, and main fill to the hedge order
+struct PairLatency {
+  PairLatency()
+    : tick_stamp(0),
+      fill_stamp(0) {
+  }
+
+  // prints the non empty histograms
+  void Dump(FILE* f, const std::string & name) const {
+    static const char* kNames[] = {"tick_to_order main", "tick_to_order hedge", "fill_to_hedge"};
+    const LatencyHistogram* hists[] = {&tick_to_order[0], &tick_to_order[1], &fill_to_hedge};
+    for (int i = 0; i < 3; i++) {
+      if (hists[i]->Count() > 0) {
+        std::string label = "[" + name + "]" + kNames[i];
+        hists[i]->Dump(f, label.c_str());
+      }
+    }
+  }
+
+  uint64_t tick_stamp;
+  uint64_t fill_stamp;
+  LatencyHistogram tick_to_order[2];  // by Leg::Enum
+  LatencyHistogram fill_to_hedge;
+};
+
+#endif  // STRATEGY_SRC_UTIL_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,119 @@
+#ifndef STRATEGY_SRC_UTIL_MMAP_SPILL_H_
+#define STRATEGY_SRC_UTIL_MMAP_SPILL_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+// append-only raw record file written through a sliding mmap window,
+// used to keep the history evicted from a RingBuffer for offline use.
+// each window maps sizeof(T) past its chunk, so a record that straddles
+// the chunk boundary (sizeof(T) need not divide it) is still in the map
+template <typename T>
+class MmapSpill {
+ public:
+  MmapSpill()
+    : fd_(-1),
+      map_(nullptr),
+      map_off_(0),
+      pos_(0),
+      chunk_(kChunkBytes),
+      map_bytes_(kChunkBytes + sizeof(T)) {
+  }
+
+  ~MmapSpill() {
+    Close();
+  }
+
+  bool Open(const std::string & path) {
+    Close();
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+      printf("spill file %s open failed: %s\n", path.c_str(), strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+      printf("spill file %s stat failed: %s\n", path.c_str(), strerror(errno));
+      Close();
+      return false;
+    }
+    pos_ = st.st_size - st.st_size % sizeof(T);  // drop a torn tail record
+    path_ = path;
+    return Remap();
+  }
+
+  inline void Append(const T& v) {
+    if (map_ == nullptr) {
+      return;
+    }
+    if (pos_ + sizeof(T) > map_off_ + map_bytes_ && !Remap()) {
+      return;
+    }
+    memcpy(map_ + (pos_ - map_off_), &v, sizeof(T));
+    pos_ += sizeof(T);
+  }
+
+  void Close() {
+    if (map_ != nullptr) {
+      munmap(map_, map_bytes_);
+      map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      if (ftruncate(fd_, pos_) != 0) {  // cut the unused tail of the last chunk
+        printf("spill file %s truncate failed: %s\n", path_.c_str(), strerror(errno));
+      }
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  bool IsOpen() const {
+    return map_ != nullptr;
+  }
+
+  // records written so far, including those in the file before Open
+  size_t Records() const {
+    return pos_ / sizeof(T);
+  }
+
+ private:
+  static const size_t kChunkBytes = 4 << 20;
+
+  bool Remap() {
+    if (map_ != nullptr) {
+      munmap(map_, map_bytes_);
+      map_ = nullptr;
+    }
+    map_off_ = pos_ - pos_ % chunk_;
+    if (ftruncate(fd_, map_off_ + map_bytes_) != 0) {
+      printf("spill file %s grow failed: %s\n", path_.c_str(), strerror(errno));
+      Close();
+      return false;
+    }
+    void* p = mmap(nullptr, map_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, map_off_);
+    if (p == MAP_FAILED) {
+      printf("spill file %s mmap failed: %s\n", path_.c_str(), strerror(errno));
+      Close();
+      return false;
+    }
+    map_ = static_cast<char*>(p);
+    return true;
+  }
+
+  int fd_;
+  char* map_;
+  size_t map_off_;
+  size_t pos_;
+  size_t chunk_;  // windows start at multiples of this, page aligned
+  size_t map_bytes_;
+  std::string path_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_MMAP_SPILL_H_
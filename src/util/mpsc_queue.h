@@ -0,0 +1,105 @@
+#ifndef STRATEGY_SRC_UTIL_MPSC_QUEUE_H_
+#define STRATEGY_SRC_UTIL_MPSC_QUEUE_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+
+// bounded multi producer single consumer queue (per-cell sequence numbers,
+// one CAS per push, none per pop). producers fill and the consumer reads
+// the cell in place, so a message is copied once on the way in
+template <typename T>
+class MpscQueue {
+  static_assert(std::is_trivially_copyable<T>::value, "MpscQueue holds raw records");
+
+ public:
+  explicit MpscQueue(size_t capacity)
+    : cells_(nullptr),
+      mask_(0),
+      tail_(0),
+      head_(0) {
+    size_t slots = 2;
+    while (slots < capacity) {
+      slots <<= 1;
+    }
+    mask_ = slots - 1;
+    if (posix_memalign(reinterpret_cast<void**>(&cells_), kCacheLine, slots * sizeof(Cell)) != 0) {
+      printf("mpsc queue alloc %zu failed\n", capacity);
+      exit(1);
+    }
+    for (size_t i = 0; i < slots; i++) {
+      new (&cells_[i].seq) std::atomic<size_t>(i);
+    }
+  }
+
+  ~MpscQueue() {
+    free(cells_);
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // fill(T*) writes the message into its cell, false when the queue is full
+  template <typename F>
+  inline bool Push(F fill) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    fill(&cell->data);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer thread only, consume(const T&) runs on the cell before it is
+  // handed back to the producers
+  template <typename F>
+  inline bool Pop(F consume) {
+    Cell* cell = &cells_[head_ & mask_];
+    if (cell->seq.load(std::memory_order_acquire) != head_ + 1) {
+      return false;
+    }
+    consume(static_cast<const T&>(cell->data));
+    cell->seq.store(head_ + mask_ + 1, std::memory_order_release);
+    head_++;
+    return true;
+  }
+
+  size_t Capacity() const {
+    return mask_ + 1;
+  }
+
+ private:
+  static const size_t kCacheLine = 64;
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    T data;
+  };
+
+  // padded rather than alignas, the owner may be heap allocated under c++11
+  Cell* cells_;
+  size_t mask_;
+  char pad0_[kCacheLine];
+  std::atomic<size_t> tail_;
+  char pad1_[kCacheLine];
+  size_t head_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_MPSC_QUEUE_H_
@@ -0,0 +1,26 @@
+#ifndef STRATEGY_SRC_UTIL_NULL_SENDER_H_
+#define STRATEGY_SRC_UTIL_NULL_SENDER_H_
+
+#include "util/zmq_sender.hpp"
+
+// sender for offline drivers: counts and drops everything
+template <typename T>
+class NullSender : public BaseSender<T> {
+ public:
+  NullSender()
+    : sent_(0) {
+  }
+
+  void Send(const T& t) override {
+    sent_++;
+  }
+
+  long Sent() const {
+    return sent_;
+  }
+
+ private:
+  long sent_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_NULL_SENDER_H_
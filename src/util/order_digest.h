@@ -0,0 +1,60 @@
+#ifndef STRATEGY_SRC_UTIL_ORDER_DIGEST_H_
+#define STRATEGY_SRC_UTIL_ORDER_DIGEST_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "struct/order.h"
+#include "util/zmq_sender.hpp"
+
+// order sender for offline drivers: drops every order after folding it
+// into a running FNV-1a digest, so two runs can be checked to have sent
+// the same stream. only what the strategy decided goes in: ticker, side,
+// size, price to 1e-6, status and tag; refs and times are left out
+class OrderDigestSender : public BaseSender<Order> {
+ public:
+  OrderDigestSender()
+    : sent_(0),
+      digest_(kBasis) {
+  }
+
+  void Send(const Order& o) override {
+    sent_++;
+    Fold(o.ticker, strnlen(o.ticker, sizeof(o.ticker)));
+    int32_t side = o.side;
+    int32_t size = o.size;
+    int32_t status = o.status;
+    int64_t price = llround(o.price * 1e6);
+    Fold(&side, sizeof(side));
+    Fold(&size, sizeof(size));
+    Fold(&status, sizeof(status));
+    Fold(&price, sizeof(price));
+    Fold(o.tbd, strnlen(o.tbd, sizeof(o.tbd)));
+  }
+
+  long Sent() const {
+    return sent_;
+  }
+
+  uint64_t Digest() const {
+    return digest_;
+  }
+
+ private:
+  static const uint64_t kBasis = 0xcbf29ce484222325ull;
+  static const uint64_t kPrime = 0x100000001b3ull;
+
+  inline void Fold(const void* p, size_t n) {
+    const unsigned char* b = static_cast<const unsigned char*>(p);
+    for (size_t i = 0; i < n; i++) {
+      digest_ = (digest_ ^ b[i]) * kPrime;
+    }
+    digest_ = (digest_ ^ 0xff) * kPrime;  // field separator
+  }
+
+  long sent_;
+  uint64_t digest_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_ORDER_DIGEST_H_
@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "util/record_journal.h"
+
+namespace {
+
+const int kMaxJournals = 64;
+
+RecordJournal* g_journals[kMaxJournals];
+std::mutex g_register_mutex;  // g_journals and the exit hook
+bool g_exit_hooked = false;
+
+}  // namespace
+
+RecordJournal::RecordJournal(std::ofstream* out, size_t batch_bytes)
+  : out_(nullptr),
+    buf_(static_cast<char*>(malloc(batch_bytes))),
+    capacity_(batch_bytes),
+    used_(0) {
+  if (buf_ == nullptr) {
+    printf("journal buffer alloc %zu failed\n", batch_bytes);
+    exit(1);
+  }
+  Reset(out);
+}
+
+RecordJournal::~RecordJournal() {
+  Unregister(this);
+  Flush();
+  free(buf_);
+}
+
+void RecordJournal::Reset(std::ofstream* out) {
+  bool was_open;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    was_open = (out_ != nullptr);
+    FlushLocked();
+    out_ = out;
+  }
+  if (was_open) {
+    Unregister(this);
+  }
+  if (out != nullptr) {
+    Register(this);
+  }
+}
+
+void RecordJournal::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FlushLocked();
+}
+
+void RecordJournal::FlushLocked() {
+  if (out_ == nullptr) {
+    return;
+  }
+  if (used_ > 0) {
+    out_->write(buf_, used_);
+    used_ = 0;
+  }
+  out_->flush();
+}
+
+void RecordJournal::FlushAll() {
+  std::lock_guard<std::mutex> lock(g_register_mutex);
+  for (int i = 0; i < kMaxJournals; i++) {
+    if (g_journals[i] != nullptr) {
+      g_journals[i]->Flush();
+    }
+  }
+}
+
+void RecordJournal::Register(RecordJournal* j) {
+  std::lock_guard<std::mutex> lock(g_register_mutex);
+  if (!g_exit_hooked) {
+    atexit(&RecordJournal::OnExit);
+    g_exit_hooked = true;
+  }
+  for (int i = 0; i < kMaxJournals; i++) {
+    if (g_journals[i] == nullptr) {
+      g_journals[i] = j;
+      return;
+    }
+  }
+  printf("too many record journals, %p is not flushed on exit\n", static_cast<void*>(j));
+}
+
+void RecordJournal::Unregister(RecordJournal* j) {
+  std::lock_guard<std::mutex> lock(g_register_mutex);
+  for (int i = 0; i < kMaxJournals; i++) {
+    if (g_journals[i] == j) {
+      g_journals[i] = nullptr;
+    }
+  }
+}
+
+void RecordJournal::OnExit() {
+  FlushAll();
+}
@@ -0,0 +1,73 @@
+#ifndef STRATEGY_SRC_UTIL_RECORD_JOURNAL_H_
+#define STRATEGY_SRC_UTIL_RECORD_JOURNAL_H_
+
+#include <string.h>
+
+#include <fstream>
+#include <mutex>
+#include <type_traits>
+
+// raw records staged in a preallocated buffer and written to an ofstream
+// one batch at a time, instead of write+flush per record.
+// a journal is flushed when destroyed or reset, and every open one at
+// exit. signals are the host's: a host that stops on one calls FlushAll
+// from its shutdown path (never from the handler itself)
+class RecordJournal {
+ public:
+  static const size_t kDefaultBatchBytes = 1 << 20;
+
+  explicit RecordJournal(std::ofstream* out = nullptr, size_t batch_bytes = kDefaultBatchBytes);
+  ~RecordJournal();
+
+  RecordJournal(const RecordJournal&) = delete;
+  RecordJournal& operator=(const RecordJournal&) = delete;
+
+  void Reset(std::ofstream* out);
+
+  template <typename T>
+  inline void Append(const T& record) {
+    static_assert(std::is_trivially_copyable<T>::value, "RecordJournal holds raw records");
+    Append(&record, sizeof(T));
+  }
+
+  inline void Append(const void* data, size_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (out_ == nullptr) {
+      return;
+    }
+    if (used_ + n > capacity_) {
+      FlushLocked();
+      if (n > capacity_) {  // bigger than a batch, write through
+        out_->write(static_cast<const char*>(data), n);
+        return;
+      }
+    }
+    memcpy(buf_ + used_, data, n);
+    used_ += n;
+  }
+
+  // write the staged batch and flush the stream
+  void Flush();
+
+  size_t Pending() const {
+    return used_;
+  }
+
+  // flush every live journal, each under its own mutex, so never in the
+  // middle of an Append. also what the exit hook runs
+  static void FlushAll();
+
+ private:
+  void FlushLocked();
+  static void Register(RecordJournal* j);
+  static void Unregister(RecordJournal* j);
+  static void OnExit();
+
+  std::mutex mutex_;  // uncontended but for a FlushAll
+  std::ofstream* out_;
+  char* buf_;
+  size_t capacity_;
+  size_t used_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_RECORD_JOURNAL_H_
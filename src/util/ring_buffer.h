@@ -0,0 +1,133 @@
+#ifndef STRATEGY_SRC_UTIL_RING_BUFFER_H_
+#define STRATEGY_SRC_UTIL_RING_BUFFER_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <string>
+#include <type_traits>
+
+#include "util/mmap_spill.h"
+
+// fixed capacity series keeping the newest `capacity` elements in a
+// cache-line aligned block; evicted elements optionally go to a MmapSpill
+template <typename T>
+class RingBuffer {
+  static_assert(std::is_trivially_copyable<T>::value, "RingBuffer holds raw records");
+
+ public:
+  explicit RingBuffer(size_t capacity = 0)
+    : data_(nullptr),
+      capacity_(0),
+      mask_(0),
+      head_(0),
+      size_(0),
+      total_(0) {
+    Reset(capacity);
+  }
+
+  ~RingBuffer() {
+    free(data_);
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  void Reset(size_t capacity) {
+    free(data_);
+    data_ = nullptr;
+    capacity_ = capacity;
+    size_t slots = 1;
+    while (slots < capacity) {
+      slots <<= 1;
+    }
+    mask_ = slots - 1;
+    if (capacity > 0 && posix_memalign(reinterpret_cast<void**>(&data_), kCacheLine, slots * sizeof(T)) != 0) {
+      printf("ring buffer alloc %zu failed\n", capacity);
+      exit(1);
+    }
+    head_ = 0;
+    size_ = 0;
+    total_ = 0;
+  }
+
+  // extra copy of every evicted element, for offline use
+  bool Spill(const std::string & path) {
+    return spill_.Open(path);
+  }
+
+  inline void push_back(const T& v) {
+    if (size_ == capacity_) {
+      if (capacity_ == 0) {
+        return;
+      }
+      if (spill_.IsOpen()) {
+        spill_.Append(data_[head_]);
+      }
+      data_[(head_ + size_) & mask_] = v;
+      head_ = (head_ + 1) & mask_;
+    } else {
+      data_[(head_ + size_) & mask_] = v;
+      size_++;
+    }
+    total_++;
+  }
+
+  inline const T& front() const {
+    return data_[head_];
+  }
+
+  inline const T& back() const {
+    return data_[(head_ + size_ - 1) & mask_];
+  }
+
+  // i = 0 is the oldest element kept
+  inline const T& operator[](size_t i) const {
+    return data_[(head_ + i) & mask_];
+  }
+
+  // the kept elements oldest first as at most two contiguous runs,
+  // for batch kernels. second is empty unless the ring has wrapped
+  inline void Spans(const T** first, size_t* first_n, const T** second, size_t* second_n) const {
+    size_t slots = mask_ + 1;
+    size_t run = slots - head_ < size_ ? slots - head_ : size_;
+    *first = data_ + head_;
+    *first_n = run;
+    *second = data_;
+    *second_n = size_ - run;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  bool full() const {
+    return size_ == capacity_;
+  }
+
+  // elements pushed since Reset, including the evicted ones
+  long total() const {
+    return total_;
+  }
+
+ private:
+  static const size_t kCacheLine = 64;
+
+  T* data_;
+  size_t capacity_;
+  size_t mask_;
+  size_t head_;
+  size_t size_;
+  long total_;
+  MmapSpill<T> spill_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_RING_BUFFER_H_
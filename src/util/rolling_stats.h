@@ -0,0 +1,103 @@
+#ifndef STRATEGY_SRC_UTIL_ROLLING_STATS_H_
+#define STRATEGY_SRC_UTIL_ROLLING_STATS_H_
+
+#include <cmath>
+
+#include "util/ring_buffer.h"
+#include "util/stat_kernels.h"
+
+// mean/std over the last `window` samples, updated in O(1) per sample.
+// std is the population std, same as BaseStrategy::CalMeanStd.
+// Resync recomputes both exactly from the window, for recalibration
+class RollingStats {
+ public:
+  explicit RollingStats(int window = 0) {
+    Reset(window);
+  }
+
+  void Reset(int window) {
+    buf_.Reset(window > 0 ? window : 0);
+    mean_ = 0.0;
+    m2_ = 0.0;
+  }
+
+  inline void Add(double v) {
+    if (buf_.capacity() == 0) {
+      return;
+    }
+    if (!buf_.full()) {  // still filling, plain welford
+      buf_.push_back(v);
+      double delta = v - mean_;
+      mean_ += delta / buf_.size();
+      m2_ += delta * (v - mean_);
+      return;
+    }
+    // full: replace the oldest sample
+    double old = buf_.front();
+    buf_.push_back(v);
+    double old_mean = mean_;
+    mean_ += (v - old) / buf_.capacity();
+    m2_ += (v - old) * (v - mean_ + old - old_mean);
+    if (m2_ < 0.0) {  // rounding
+      m2_ = 0.0;
+    }
+  }
+
+  // two-pass mean/variance over the window with the batch kernels, drops
+  // the rounding the O(1) updates have piled up since the last resync
+  void Resync() {
+    const double* a;
+    const double* b;
+    size_t na;
+    size_t nb;
+    buf_.Spans(&a, &na, &b, &nb);
+    size_t n = na + nb;
+    if (n == 0) {
+      return;
+    }
+    const StatKernels & k = StatKernels::Best();
+    mean_ = (k.sum(a, na) + k.sum(b, nb)) / n;
+    m2_ = k.sum_sq_dev(a, na, mean_) + k.sum_sq_dev(b, nb, mean_);
+  }
+
+  double Mean() const {
+    return mean_;
+  }
+
+  double Std() const {
+    return buf_.empty() ? 0.0 : sqrt(m2_ / buf_.size());
+  }
+
+  double Back() const {
+    return buf_.back();
+  }
+
+  int Size() const {
+    return static_cast<int>(buf_.size());
+  }
+
+  int Window() const {
+    return static_cast<int>(buf_.capacity());
+  }
+
+  bool Full() const {
+    return !buf_.empty() && buf_.full();
+  }
+
+  // the samples in the window, oldest first
+  const RingBuffer<double> & Samples() const {
+    return buf_;
+  }
+
+  // samples added since Reset, including the evicted ones
+  long Count() const {
+    return buf_.total();
+  }
+
+ private:
+  RingBuffer<double> buf_;
+  double mean_;
+  double m2_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_ROLLING_STATS_H_
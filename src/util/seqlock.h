@@ -0,0 +1,55 @@
+#ifndef STRATEGY_SRC_UTIL_SEQLOCK_H_
+#define STRATEGY_SRC_UTIL_SEQLOCK_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+// single writer, any number of readers, nobody ever blocks the writer:
+// Store bumps the sequence to odd, copies, bumps to even; Load retries
+// until it copied between two equal even sequences
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock copies raw bytes");
+
+ public:
+  SeqLock()
+    : seq_(0) {
+    memset(&data_, 0, sizeof(data_));
+  }
+
+  inline void Store(const T& v) {
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data_, &v, sizeof(T));
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // returns the version copied, 0 if nothing was ever stored
+  uint64_t Load(T* out) const {
+    while (true) {
+      uint64_t before = seq_.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+      memcpy(out, &data_, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == before) {
+        return before;
+      }
+    }
+  }
+
+  uint64_t Version() const {
+    return seq_.load(std::memory_order_acquire);
+  }
+
+ private:
+  std::atomic<uint64_t> seq_;
+  T data_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_SEQLOCK_H_
@@ -0,0 +1,117 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "util/snapshot_tape.h"
+
+const uint32_t SnapshotTape::kNone;
+
+SnapshotFile::SnapshotFile()
+  : fd_(-1),
+    map_(nullptr),
+    bytes_(0),
+    data_(nullptr),
+    size_(0) {
+}
+
+SnapshotFile::~SnapshotFile() {
+  Close();
+}
+
+bool SnapshotFile::Open(const std::string & path) {
+  Close();
+  fd_ = open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    printf("snapshot file %s open failed: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    printf("snapshot file %s stat failed: %s\n", path.c_str(), strerror(errno));
+    Close();
+    return false;
+  }
+  if (st.st_size % sizeof(MarketSnapshot) != 0) {
+    printf("snapshot file %s has a torn tail of %zu bytes, ignored\n", path.c_str(), static_cast<size_t>(st.st_size % sizeof(MarketSnapshot)));
+  }
+  size_ = st.st_size / sizeof(MarketSnapshot);
+  if (size_ == 0) {
+    return true;
+  }
+  bytes_ = st.st_size;
+  map_ = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (map_ == MAP_FAILED) {
+    printf("snapshot file %s mmap failed: %s\n", path.c_str(), strerror(errno));
+    map_ = nullptr;
+    Close();
+    return false;
+  }
+  madvise(map_, bytes_, MADV_SEQUENTIAL);
+  data_ = static_cast<const MarketSnapshot*>(map_);
+  return true;
+}
+
+void SnapshotFile::Close() {
+  if (map_ != nullptr) {
+    munmap(map_, bytes_);
+    map_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  bytes_ = 0;
+  data_ = nullptr;
+  size_ = 0;
+}
+
+bool SnapshotTape::Add(const std::string & path) {
+  std::unique_ptr<SnapshotFile> f(new SnapshotFile);
+  if (!f->Open(path)) {
+    return false;
+  }
+  for (const MarketSnapshot* s = f->begin(); s != f->end(); s++) {
+    order_.push_back(s);
+  }
+  files_.push_back(std::move(f));
+  return true;
+}
+
+void SnapshotTape::Add(std::vector<MarketSnapshot> && records) {
+  std::unique_ptr<std::vector<MarketSnapshot> > v(new std::vector<MarketSnapshot>(std::move(records)));
+  for (const MarketSnapshot & s : *v) {
+    order_.push_back(&s);
+  }
+  owned_.push_back(std::move(v));
+}
+
+void SnapshotTape::Build() {
+  // stable: equal stamps keep file order, and a file's own order
+  std::stable_sort(order_.begin(), order_.end(), [](const MarketSnapshot* a, const MarketSnapshot* b) {
+    return a->time.tv_sec < b->time.tv_sec || (a->time.tv_sec == b->time.tv_sec && a->time.tv_usec < b->time.tv_usec);
+  });
+  std::unordered_map<std::string, uint32_t> ids;
+  ticker_id_.resize(order_.size());
+  for (size_t i = 0; i < order_.size(); i++) {
+    std::string ticker(order_[i]->ticker, strnlen(order_[i]->ticker, sizeof(order_[i]->ticker)));
+    auto it = ids.find(ticker);
+    if (it == ids.end()) {
+      it = ids.emplace(ticker, tickers_.size()).first;
+      tickers_.push_back(ticker);
+    }
+    ticker_id_[i] = it->second;
+  }
+  next_.assign(order_.size(), kNone);
+  std::vector<uint32_t> later(tickers_.size(), kNone);
+  for (size_t i = order_.size(); i-- > 0;) {
+    next_[i] = later[ticker_id_[i]];
+    later[ticker_id_[i]] = i;
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef STRATEGY_SRC_UTIL_SNAPSHOT_TAPE_H_
+#define STRATEGY_SRC_UTIL_SNAPSHOT_TAPE_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "struct/market_snapshot.h"
+
+// read-only mmap of a raw MarketSnapshot recording, records are used in place
+class SnapshotFile {
+ public:
+  SnapshotFile();
+  ~SnapshotFile();
+
+  SnapshotFile(const SnapshotFile&) = delete;
+  SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+  bool Open(const std::string & path);
+  void Close();
+
+  const MarketSnapshot* begin() const {
+    return data_;
+  }
+
+  const MarketSnapshot* end() const {
+    return data_ + size_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  int fd_;
+  void* map_;
+  size_t bytes_;
+  const MarketSnapshot* data_;
+  size_t size_;
+};
+
+// every snapshot of a replay in time order, merged from one or more
+// recordings. only pointers into the mapped files are kept, plus a dense
+// ticker id and the index of the same ticker's next snapshot per record,
+// so a driver needs no hashing per tick
+class SnapshotTape {
+ public:
+  static const uint32_t kNone = UINT32_MAX;
+
+  bool Add(const std::string & path);
+  // snapshots made in memory, e.g. a synthetic feed; the tape keeps them
+  void Add(std::vector<MarketSnapshot> && records);
+  // merge everything added so far, call once after the last Add
+  void Build();
+
+  size_t size() const {
+    return order_.size();
+  }
+
+  inline const MarketSnapshot& operator[](size_t i) const {
+    return *order_[i];
+  }
+
+  inline uint32_t TickerId(size_t i) const {
+    return ticker_id_[i];
+  }
+
+  // the same ticker's next snapshot, nullptr on its last one
+  inline const MarketSnapshot* Next(size_t i) const {
+    return next_[i] == kNone ? nullptr : order_[next_[i]];
+  }
+
+  const std::vector<std::string> & Tickers() const {
+    return tickers_;
+  }
+
+ private:
+  std::vector<std::unique_ptr<SnapshotFile> > files_;
+  std::vector<std::unique_ptr<std::vector<MarketSnapshot> > > owned_;
+  std::vector<const MarketSnapshot*> order_;
+  std::vector<uint32_t> ticker_id_;
+  std::vector<uint32_t> next_;
+  std::vector<std::string> tickers_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_SNAPSHOT_TAPE_H_
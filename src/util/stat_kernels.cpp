@@ -0,0 +1,104 @@
+#include <immintrin.h>
+
+#include "util/stat_kernels.h"
+
+namespace {
+
+double SumScalar(const double* v, size_t n) {
+  double s = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    s += v[i];
+  }
+  return s;
+}
+
+double SumSqDevScalar(const double* v, size_t n, double mean) {
+  double s = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double d = v[i] - mean;
+    s += d * d;
+  }
+  return s;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// compiled for avx2 per function, the rest of the tree keeps the default isa
+
+__attribute__((target("avx2")))
+inline double HorizontalSum(__m256d x) {
+  __m128d s = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+__attribute__((target("avx2")))
+double SumAvx2(const double* v, size_t n) {
+  __m256d a0 = _mm256_setzero_pd();
+  __m256d a1 = _mm256_setzero_pd();
+  __m256d a2 = _mm256_setzero_pd();
+  __m256d a3 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    a0 = _mm256_add_pd(a0, _mm256_loadu_pd(v + i));
+    a1 = _mm256_add_pd(a1, _mm256_loadu_pd(v + i + 4));
+    a2 = _mm256_add_pd(a2, _mm256_loadu_pd(v + i + 8));
+    a3 = _mm256_add_pd(a3, _mm256_loadu_pd(v + i + 12));
+  }
+  for (; i + 4 <= n; i += 4) {
+    a0 = _mm256_add_pd(a0, _mm256_loadu_pd(v + i));
+  }
+  double s = HorizontalSum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+  return s + SumScalar(v + i, n - i);
+}
+
+__attribute__((target("avx2")))
+double SumSqDevAvx2(const double* v, size_t n, double mean) {
+  __m256d m = _mm256_set1_pd(mean);
+  __m256d a0 = _mm256_setzero_pd();
+  __m256d a1 = _mm256_setzero_pd();
+  __m256d a2 = _mm256_setzero_pd();
+  __m256d a3 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(v + i), m);
+    __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(v + i + 4), m);
+    __m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(v + i + 8), m);
+    __m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(v + i + 12), m);
+    a0 = _mm256_add_pd(a0, _mm256_mul_pd(d0, d0));
+    a1 = _mm256_add_pd(a1, _mm256_mul_pd(d1, d1));
+    a2 = _mm256_add_pd(a2, _mm256_mul_pd(d2, d2));
+    a3 = _mm256_add_pd(a3, _mm256_mul_pd(d3, d3));
+  }
+  for (; i + 4 <= n; i += 4) {
+    __m256d d = _mm256_sub_pd(_mm256_loadu_pd(v + i), m);
+    a0 = _mm256_add_pd(a0, _mm256_mul_pd(d, d));
+  }
+  double s = HorizontalSum(_mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+  return s + SumSqDevScalar(v + i, n - i, mean);
+}
+
+#endif
+
+const StatKernels kScalar = {"scalar", &SumScalar, &SumSqDevScalar};
+
+const StatKernels& Pick() {
+#if defined(__x86_64__) || defined(__i386__)
+  static const StatKernels avx2 = {"avx2", &SumAvx2, &SumSqDevAvx2};
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return avx2;
+  }
+#endif
+  return kScalar;
+}
+
+}  // namespace
+
+const StatKernels& StatKernels::Best() {
+  static const StatKernels& best = Pick();
+  return best;
+}
+
+const StatKernels& StatKernels::Scalar() {
+  return kScalar;
+}
@@ -0,0 +1,20 @@
+#ifndef STRATEGY_SRC_UTIL_STAT_KERNELS_H_
+#define STRATEGY_SRC_UTIL_STAT_KERNELS_H_
+
+#include <stddef.h>
+
+// batch statistics over double arrays. Best() picks the AVX2 versions once
+// from cpuid and falls back to the scalar ones, which are always there for
+// cross-checking. vector sums run in a different order, so the two agree
+// to rounding, not bit for bit
+struct StatKernels {
+  const char* isa;
+  double (*sum)(const double* v, size_t n);
+  // sum of (v[i] - mean)^2, the second pass of a two-pass variance
+  double (*sum_sq_dev)(const double* v, size_t n, double mean);
+
+  static const StatKernels& Best();
+  static const StatKernels& Scalar();
+};
+
+#endif  // STRATEGY_SRC_UTIL_STAT_KERNELS_H_
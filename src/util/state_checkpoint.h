@@ -0,0 +1,252 @@
+#ifndef STRATEGY_SRC_UTIL_STATE_CHECKPOINT_H_
+#define STRATEGY_SRC_UTIL_STATE_CHECKPOINT_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "util/rolling_stats.h"
+
+// a strategy's training windows plus its derived bands, kept in one mmap'd
+// file so a restart can trade at once instead of retraining. the layout is
+// fixed by (version, series, capacity, bands): a file written with another
+// layout, for another label, torn by a crash mid-save, or older than the
+// caller's max age is never restored. each series is a ring in the file
+// too, so a save writes only the samples added since the one before; the
+// map is left to the kernel's writeback and synced once, on Close
+class StateCheckpoint {
+ public:
+  static const uint32_t kMagic = 0x504b4353;  // "SCKP"
+  static const uint32_t kVersion = 2;
+  static const int kMaxSeries = 4;
+  static const int kMaxBands = 16;
+
+  StateCheckpoint()
+    : fd_(-1),
+      map_(nullptr),
+      bytes_(0),
+      series_(0),
+      capacity_(0),
+      bands_(0),
+      interval_sec_(60),
+      next_save_sec_(0),
+      saves_(0),
+      synced_(false) {
+  }
+
+  ~StateCheckpoint() {
+    Close();
+  }
+
+  StateCheckpoint(const StateCheckpoint&) = delete;
+  StateCheckpoint& operator=(const StateCheckpoint&) = delete;
+
+  bool Open(const std::string & path, const std::string & label, int series, size_t capacity, int bands) {
+    Close();
+    if (series < 1 || series > kMaxSeries || bands < 0 || bands > kMaxBands || capacity == 0) {
+      printf("checkpoint %s: bad layout %d series x %zu, %d bands\n", path.c_str(), series, capacity, bands);
+      return false;
+    }
+    series_ = series;
+    capacity_ = capacity;
+    bands_ = bands;
+    bytes_ = sizeof(Header) + series * capacity * sizeof(double);
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+      printf("checkpoint %s open failed: %s\n", path.c_str(), strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+      printf("checkpoint %s stat failed: %s\n", path.c_str(), strerror(errno));
+      Close();
+      return false;
+    }
+    bool reshaped = static_cast<size_t>(st.st_size) != bytes_;
+    if (reshaped && ftruncate(fd_, bytes_) != 0) {
+      printf("checkpoint %s resize failed: %s\n", path.c_str(), strerror(errno));
+      Close();
+      return false;
+    }
+    void* p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+      printf("checkpoint %s mmap failed: %s\n", path.c_str(), strerror(errno));
+      Close();
+      return false;
+    }
+    map_ = static_cast<char*>(p);
+    if (reshaped) {  // another layout, or new: nothing to restore
+      memset(map_, 0, sizeof(Header));
+    }
+    path_ = path;
+    snprintf(label_, sizeof(label_), "%s", label.c_str());
+    synced_ = false;
+    return true;
+  }
+
+  void Close() {
+    if (map_ != nullptr) {
+      msync(map_, bytes_, MS_SYNC);
+      munmap(map_, bytes_);
+      map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  bool IsOpen() const {
+    return map_ != nullptr;
+  }
+
+  // market seconds between periodic saves
+  void SetInterval(int64_t sec) {
+    interval_sec_ = sec;
+  }
+
+  inline bool Due(int64_t now_sec) const {
+    return map_ != nullptr && now_sec >= next_save_sec_;
+  }
+
+  // now_sec is market time, stamped as the age of the save. series[i]
+  // must be the same series every call; only its samples added since the
+  // last Save (or Restore) are written, the whole window on the first
+  void Save(int64_t now_sec, const RollingStats* const* series, const double* bands) {
+    if (map_ == nullptr) {
+      return;
+    }
+    Header* h = header();
+    h->seq++;  // odd: a reader after a crash here sees a torn file
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (!synced_) {  // the file holds nothing of these series yet
+      h->magic = kMagic;
+      h->version = kVersion;
+      h->header_bytes = sizeof(Header);
+      memcpy(h->label, label_, sizeof(h->label));
+      h->series = series_;
+      h->capacity = capacity_;
+      h->bands = bands_;
+      for (int i = 0; i < series_; i++) {
+        h->written[i] = 0;
+        h->counts[i] = 0;
+        saved_total_[i] = series[i]->Count() - static_cast<long>(series[i]->Samples().size());
+      }
+      synced_ = true;
+    }
+    h->saved_sec = now_sec;
+    for (int i = 0; i < series_; i++) {
+      const RingBuffer<double> & w = series[i]->Samples();
+      long fresh = series[i]->Count() - saved_total_[i];  // < 0 if the series was Reset
+      size_t n = (fresh < 0 || static_cast<size_t>(fresh) > w.size()) ? w.size() : fresh;
+      n = n < capacity_ ? n : capacity_;
+      double* out = data(i);
+      uint64_t k = h->written[i];
+      for (size_t j = w.size() - n; j < w.size(); j++, k++) {
+        out[k % capacity_] = w[j];
+      }
+      h->written[i] = k;
+      h->counts[i] = k < capacity_ ? k : capacity_;
+      saved_total_[i] = series[i]->Count();
+    }
+    memcpy(h->band, bands, bands_ * sizeof(double));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    h->seq++;
+    next_save_sec_ = now_sec + interval_sec_;
+    saves_++;
+  }
+
+  // refills series[i] (after a Reset) and bands from the file, returns the
+  // number of samples restored per series, 0 when nothing usable is there.
+  // a header that does not add up (counts past the capacity, ...) is
+  // treated as a foreign file
+  size_t Restore(int64_t now_sec, int64_t max_age_sec, RollingStats* const* series, double* bands) {
+    if (map_ == nullptr) {
+      return 0;
+    }
+    const Header* h = header();
+    if (h->magic != kMagic || h->version != kVersion || h->header_bytes != sizeof(Header) || (h->seq & 1) != 0 ||
+        strncmp(h->label, label_, sizeof(label_)) != 0 || h->series != static_cast<uint32_t>(series_) ||
+        h->capacity != capacity_ || h->bands != static_cast<uint32_t>(bands_)) {
+      return 0;
+    }
+    for (int i = 0; i < series_; i++) {
+      if (h->counts[i] > capacity_ || h->counts[i] > h->written[i]) {
+        printf("checkpoint %s: series %d claims %u of %zu samples, not restored\n", path_.c_str(), i, h->counts[i], capacity_);
+        return 0;
+      }
+    }
+    int64_t age = now_sec - h->saved_sec;
+    if (age < 0 || age > max_age_sec) {
+      printf("checkpoint %s is %ld seconds old, not restored\n", path_.c_str(), static_cast<long>(age));
+      return 0;
+    }
+    size_t n = h->counts[0];
+    for (int i = 1; i < series_; i++) {
+      n = h->counts[i] < n ? h->counts[i] : n;
+    }
+    for (int i = 0; i < series_; i++) {
+      const double* in = data(i);
+      for (uint64_t k = h->written[i] - n; k < h->written[i]; k++) {
+        series[i]->Add(in[k % capacity_]);
+      }
+      series[i]->Resync();
+      saved_total_[i] = series[i]->Count();  // what was restored is in the file already
+    }
+    memcpy(bands, h->band, bands_ * sizeof(double));
+    synced_ = true;
+    return n;
+  }
+
+  long Saves() const {
+    return saves_;
+  }
+
+ private:
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_bytes;
+    uint32_t pad;
+    uint64_t seq;
+    char label[64];
+    int64_t saved_sec;
+    uint32_t series;
+    uint32_t capacity;
+    uint32_t bands;
+    uint32_t counts[kMaxSeries];  // valid samples in each ring, at most capacity
+    uint64_t written[kMaxSeries];  // samples ever written, the next slot is this % capacity
+    double band[kMaxBands];
+  };
+
+  Header* header() const {
+    return reinterpret_cast<Header*>(map_);
+  }
+
+  double* data(int i) const {
+    return reinterpret_cast<double*>(map_ + sizeof(Header)) + i * capacity_;
+  }
+
+  std::string path_;
+  char label_[64];
+  int fd_;
+  char* map_;
+  size_t bytes_;
+  int series_;
+  size_t capacity_;
+  int bands_;
+  int64_t interval_sec_;
+  int64_t next_save_sec_;
+  long saves_;
+  bool synced_;  // the file's rings continue the series given to Save
+  long saved_total_[kMaxSeries];  // series' Count() at the last save
+};
+
+#endif  // STRATEGY_SRC_UTIL_STATE_CHECKPOINT_H_
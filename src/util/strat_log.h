@@ -0,0 +1,24 @@
+#ifndef STRATEGY_SRC_UTIL_STRAT_LOG_H_
+#define STRATEGY_SRC_UTIL_STRAT_LOG_H_
+
+#include "struct/market_snapshot.h"
+#include "struct/order.h"
+#include "util/async_logger.h"
+
+// top of book / order summaries replacing Show(stdout) on the tick path
+
+#define SLOG_SHOT(lvl, shot) SLOG(lvl, "%s %ld.%06ld %d@%lf | %lf@%d\n", (shot).ticker, \
+    (shot).time.tv_sec, (shot).time.tv_usec, (shot).bid_sizes[0], (shot).bids[0], (shot).asks[0], (shot).ask_sizes[0])
+
+#define SLOG_ORDER(lvl, o) SLOG(lvl, "order %s %s %s %d@%lf traded=%d status=%s tbd=%s\n", (o)->order_ref, \
+    (o)->ticker, OrderSide::ToString((o)->side), (o)->size, (o)->price, (o)->traded_size, OrderStatus::ToString((o)->status), (o)->tbd)
+
+#define SLOG_ORDERS(lvl, order_map) do { \
+  if ((lvl) >= STRAT_LOG_LEVEL) { \
+    for (auto& slog_it : (order_map)) { \
+      SLOG_ORDER(lvl, slog_it.second); \
+    } \
+  } \
+} while (0)
+
+#endif  // STRATEGY_SRC_UTIL_STRAT_LOG_H_
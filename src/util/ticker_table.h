@@ -0,0 +1,70 @@
+#ifndef STRATEGY_SRC_UTIL_TICKER_TABLE_H_
+#define STRATEGY_SRC_UTIL_TICKER_TABLE_H_
+
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef uint32_t TickerId;
+
+const TickerId kNoTicker = UINT32_MAX;
+
+// process wide ticker name <-> dense id. interning happens at setup
+// (strategy construction, driver setup), never on the tick path; ids
+// start at 0 and are never reused, so they index flat per ticker tables.
+// a driver routing by id hands it to the strategy with the snapshot, see
+// core/routed_strategy.h
+class TickerTable {
+ public:
+  static TickerId Intern(const std::string & ticker) {
+    TickerTable & t = Instance();
+    std::lock_guard<std::mutex> lock(t.mutex_);
+    auto it = t.ids_.find(ticker);
+    if (it != t.ids_.end()) {
+      return it->second;
+    }
+    TickerId id = t.names_.size();
+    t.ids_[ticker] = id;
+    t.names_.push_back(ticker);
+    return id;
+  }
+
+  // kNoTicker if never interned
+  static TickerId Find(const std::string & ticker) {
+    TickerTable & t = Instance();
+    std::lock_guard<std::mutex> lock(t.mutex_);
+    auto it = t.ids_.find(ticker);
+    return it == t.ids_.end() ? kNoTicker : it->second;
+  }
+
+  static std::string Name(TickerId id) {
+    TickerTable & t = Instance();
+    std::lock_guard<std::mutex> lock(t.mutex_);
+    return id < t.names_.size() ? t.names_[id] : std::string();
+  }
+
+  // ids handed out so far, all below this
+  static size_t Size() {
+    TickerTable & t = Instance();
+    std::lock_guard<std::mutex> lock(t.mutex_);
+    return t.names_.size();
+  }
+
+ private:
+  TickerTable() {
+  }
+
+  static TickerTable & Instance() {
+    static TickerTable t;
+    return t;
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, TickerId> ids_;
+  std::vector<std::string> names_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_TICKER_TABLE_H_
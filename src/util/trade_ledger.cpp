@@ -0,0 +1,338 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "util/trade_ledger.h"
+
+const uint32_t TradeLedger::kBlockRounds;
+
+namespace {
+
+#define LEDGER_COLUMN(name, field) {name, offsetof(TradeRound, field), sizeof(TradeRound::field)}
+
+const LedgerColumn kColumns[LedgerColumn::kCount] = {
+  LEDGER_COLUMN("open_usec", open_usec),
+  LEDGER_COLUMN("close_usec", close_usec),
+  LEDGER_COLUMN("size", size),
+  LEDGER_COLUMN("dir", dir),
+  LEDGER_COLUMN("forced", forced),
+  LEDGER_COLUMN("main_open", main_open),
+  LEDGER_COLUMN("main_close", main_close),
+  LEDGER_COLUMN("hedge_open", hedge_open),
+  LEDGER_COLUMN("hedge_close", hedge_close),
+  LEDGER_COLUMN("fee_points", fee_points),
+  LEDGER_COLUMN("pnl", pnl),
+  LEDGER_COLUMN("open_slip", open_slip),
+  LEDGER_COLUMN("close_slip", close_slip),
+  LEDGER_COLUMN("mean", mean),
+  LEDGER_COLUMN("up", up),
+  LEDGER_COLUMN("down", down),
+  LEDGER_COLUMN("stop_up", stop_up),
+  LEDGER_COLUMN("stop_down", stop_down),
+  LEDGER_COLUMN("spread_threshold", spread_threshold)
+};
+
+#undef LEDGER_COLUMN
+
+inline size_t Pad8(size_t n) {
+  return (n + 7) & ~static_cast<size_t>(7);
+}
+
+// bytes of a block of rounds with n_params
+size_t BlockBytes(size_t rounds, size_t n_params) {
+  size_t n = sizeof(LedgerBlockHeader) + Pad8(n_params * kLedgerNameSize);
+  for (int c = 0; c < LedgerColumn::kCount; c++) {
+    n += Pad8(rounds * kColumns[c].width);
+  }
+  return n + n_params * rounds * sizeof(double);
+}
+
+inline bool MagicAt(const char* base, size_t off, size_t bytes) {
+  return off + sizeof(kLedgerMagic) <= bytes && memcmp(base + off, &kLedgerMagic, sizeof(kLedgerMagic)) == 0;
+}
+
+// a whole block of this version starts at off. a torn block's header
+// still claims its full size, which then runs into whatever was appended
+// after it, so a block must also end where the next one (or the file,
+// or a tail too short for a magic) starts
+bool WholeBlock(const char* base, size_t off, size_t bytes) {
+  if (off + sizeof(LedgerBlockHeader) > bytes) {
+    return false;
+  }
+  const LedgerBlockHeader* h = reinterpret_cast<const LedgerBlockHeader*>(base + off);
+  if (h->magic != kLedgerMagic || h->version != kLedgerVersion || h->n_columns != LedgerColumn::kCount
+      || h->bytes != BlockBytes(h->rounds, h->n_params) || off + h->bytes > bytes) {
+    return false;
+  }
+  size_t end = off + h->bytes;
+  return end + sizeof(kLedgerMagic) > bytes || MagicAt(base, end, bytes);
+}
+
+// the next offset from off that holds the block magic, bytes if none
+size_t NextMagic(const char* base, size_t off, size_t bytes) {
+  for (; off + sizeof(kLedgerMagic) <= bytes; off++) {
+    if (MagicAt(base, off, bytes)) {
+      return off;
+    }
+  }
+  return bytes;
+}
+
+}  // namespace
+
+const LedgerColumn & LedgerColumn::Get(int c) {
+  return kColumns[c];
+}
+
+TradeLedger::TradeLedger()
+  : journal_(nullptr),
+    running_(false) {
+}
+
+TradeLedger::~TradeLedger() {
+  StopWriter();
+  Flush();
+}
+
+bool TradeLedger::Open(const std::string & path) {
+  if (IsOpen()) {
+    StopWriter();
+    Flush();
+    journal_.Reset(nullptr);
+    out_.close();
+  }
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0 && st.st_size > 0) {
+    // a writer killed mid block left a torn tail, blocks go after the last whole one
+    size_t end = 0;
+    {
+      TradeLedgerFile f;
+      if (!f.Open(path)) {
+        return false;
+      }
+      end = f.End();
+    }
+    if (end < static_cast<size_t>(st.st_size) && truncate(path.c_str(), end) != 0) {
+      printf("trade ledger %s truncate to %zu failed: %s\n", path.c_str(), end, strerror(errno));
+      return false;
+    }
+  }
+  out_.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+  if (!out_.is_open()) {
+    printf("trade ledger %s open failed: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  journal_.Reset(&out_);
+  StartWriter();
+  return true;
+}
+
+int TradeLedger::AddBook(const std::string & label, const std::vector<std::string> & param_names) {
+  std::lock_guard<std::mutex> lock(io_mutex_);
+  std::unique_ptr<Book> b(new Book);
+  b->label = label;
+  b->param_names = param_names;
+  for (int h = 0; h < 2; h++) {
+    b->rows[h].assign(kBlockRounds, TradeRound());
+    b->params[h].assign(param_names.size() * kBlockRounds, 0.0);
+    b->n[h] = 0;
+    b->ready[h] = false;
+  }
+  b->cur = 0;
+  books_.emplace_back(std::move(b));
+  size_t bytes = BlockBytes(kBlockRounds, param_names.size());
+  if (block_.size() < bytes) {
+    block_.assign(bytes, 0);
+  }
+  return books_.size() - 1;
+}
+
+void TradeLedger::Handoff(Book* b) {
+  b->ready[b->cur].store(true, std::memory_order_release);
+  b->cur ^= 1;
+  if (b->ready[b->cur].load(std::memory_order_acquire)) {
+    // the writer has not got to the other half yet, never overwrite it
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    if (b->ready[b->cur].load(std::memory_order_acquire)) {
+      WriteBlock(b, b->cur);
+    }
+  }
+  wake_.notify_one();
+}
+
+void TradeLedger::Flush() {
+  if (!IsOpen()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(io_mutex_);
+  WriteReady();
+  for (auto & b : books_) {
+    if (b->n[b->cur] > 0) {
+      WriteBlock(b.get(), b->cur);
+    }
+  }
+  journal_.Flush();
+}
+
+void TradeLedger::StartWriter() {
+  std::lock_guard<std::mutex> lock(io_mutex_);
+  running_ = true;
+  writer_ = std::thread(&TradeLedger::Loop, this);
+}
+
+void TradeLedger::StopWriter() {
+  if (!writer_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    running_ = false;
+  }
+  wake_.notify_one();
+  writer_.join();
+}
+
+void TradeLedger::Loop() {
+  std::unique_lock<std::mutex> lock(io_mutex_);
+  while (running_) {
+    WriteReady();
+    // Append notifies without the lock, the timeout covers a missed wake
+    wake_.wait_for(lock, std::chrono::milliseconds(100));
+  }
+  WriteReady();
+}
+
+void TradeLedger::WriteReady() {
+  // cur is the appender's, but at most one half of a book is ever ready
+  // outside io_mutex_ (Handoff writes the other inline), so no order to keep
+  for (auto & b : books_) {
+    for (int h = 0; h < 2; h++) {
+      if (b->ready[h].load(std::memory_order_acquire)) {
+        WriteBlock(b.get(), h);
+      }
+    }
+  }
+}
+
+void TradeLedger::WriteBlock(Book* b, int half) {
+  size_t n_params = b->param_names.size();
+  uint32_t rounds = b->n[half];
+  size_t bytes = BlockBytes(rounds, n_params);
+  char* p = block_.data();
+  memset(p, 0, bytes);
+  LedgerBlockHeader* h = reinterpret_cast<LedgerBlockHeader*>(p);
+  h->magic = kLedgerMagic;
+  h->version = kLedgerVersion;
+  h->bytes = bytes;
+  h->rounds = rounds;
+  h->n_columns = LedgerColumn::kCount;
+  h->n_params = n_params;
+  strncpy(h->label, b->label.c_str(), sizeof(h->label) - 1);
+  p += sizeof(LedgerBlockHeader);
+  for (size_t k = 0; k < n_params; k++) {
+    strncpy(p + k * kLedgerNameSize, b->param_names[k].c_str(), kLedgerNameSize - 1);
+  }
+  p += Pad8(n_params * kLedgerNameSize);
+  for (int c = 0; c < LedgerColumn::kCount; c++) {
+    const LedgerColumn & col = kColumns[c];
+    const char* row = reinterpret_cast<const char*>(b->rows[half].data()) + col.offset;
+    for (uint32_t i = 0; i < rounds; i++, row += sizeof(TradeRound)) {
+      memcpy(p + i * col.width, row, col.width);
+    }
+    p += Pad8(rounds * col.width);
+  }
+  for (size_t k = 0; k < n_params; k++) {
+    memcpy(p, b->params[half].data() + k * kBlockRounds, rounds * sizeof(double));
+    p += rounds * sizeof(double);
+  }
+  journal_.Append(block_.data(), bytes);
+  b->n[half] = 0;
+  b->ready[half].store(false, std::memory_order_release);
+}
+
+TradeLedgerFile::TradeLedgerFile()
+  : fd_(-1),
+    map_(nullptr),
+    bytes_(0),
+    trailing_(0),
+    end_(0) {
+}
+
+TradeLedgerFile::~TradeLedgerFile() {
+  Close();
+}
+
+bool TradeLedgerFile::Open(const std::string & path) {
+  Close();
+  fd_ = open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    printf("trade ledger %s open failed: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    printf("trade ledger %s stat failed: %s\n", path.c_str(), strerror(errno));
+    Close();
+    return false;
+  }
+  if (st.st_size == 0) {
+    return true;
+  }
+  bytes_ = st.st_size;
+  map_ = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (map_ == MAP_FAILED) {
+    printf("trade ledger %s mmap failed: %s\n", path.c_str(), strerror(errno));
+    map_ = nullptr;
+    Close();
+    return false;
+  }
+  madvise(map_, bytes_, MADV_SEQUENTIAL);
+  const char* base = static_cast<const char*>(map_);
+  size_t off = 0;
+  while (off < bytes_) {
+    if (!WholeBlock(base, off, bytes_)) {
+      // torn, later sessions may have appended after it
+      size_t next = NextMagic(base, off + 1, bytes_);
+      printf("trade ledger %s: bad or torn block at %zu, %zu bytes skipped\n", path.c_str(), off, next - off);
+      trailing_ += next - off;
+      off = next;
+      continue;
+    }
+    const LedgerBlockHeader* h = reinterpret_cast<const LedgerBlockHeader*>(base + off);
+    LedgerBlock b;
+    b.header = h;
+    const char* p = base + off + sizeof(LedgerBlockHeader);
+    b.param_names = p;
+    p += Pad8(h->n_params * kLedgerNameSize);
+    for (int c = 0; c < LedgerColumn::kCount; c++) {
+      b.columns[c] = p;
+      p += Pad8(h->rounds * kColumns[c].width);
+    }
+    b.params = reinterpret_cast<const double*>(p);
+    blocks_.emplace_back(b);
+    off += h->bytes;
+    end_ = off;
+  }
+  return true;
+}
+
+void TradeLedgerFile::Close() {
+  blocks_.clear();
+  trailing_ = 0;
+  end_ = 0;
+  if (map_ != nullptr) {
+    munmap(map_, bytes_);
+    map_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  bytes_ = 0;
+}
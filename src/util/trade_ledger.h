@@ -0,0 +1,238 @@
+#ifndef STRATEGY_SRC_UTIL_TRADE_LEDGER_H_
+#define STRATEGY_SRC_UTIL_TRADE_LEDGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/record_journal.h"
+
+// one closed round trip of a pair: opened (possibly over several fills)
+// and closed in one go. prices are the legs' average open and the close.
+// slips are per lot price points, the snapshot the order was decided on
+// against the next one of its leg (positive is in our favour), summed
+// over both legs
+struct TradeRound {
+  int64_t open_usec;  // first open sent
+  int64_t close_usec;  // main leg close filled
+  int32_t size;
+  int8_t dir;  // 1 long main, -1 short main
+  uint8_t forced;  // closed by force flat or stop loss
+  double main_open;
+  double main_close;
+  double hedge_open;
+  double hedge_close;
+  double fee_points;  // both legs, open and close, whole size
+  double pnl;  // net of fees, as ContractWorker::CalNetPnl
+  double open_slip;
+  double close_slip;
+  // the bands in force at the close
+  double mean;
+  double up;
+  double down;
+  double stop_up;
+  double stop_down;
+  double spread_threshold;
+};
+
+// the columns of a ledger block, in file order
+struct LedgerColumn {
+  enum Enum {
+    OpenUsec = 0,
+    CloseUsec,
+    Size,
+    Dir,
+    Forced,
+    MainOpen,
+    MainClose,
+    HedgeOpen,
+    HedgeClose,
+    FeePoints,
+    Pnl,
+    OpenSlip,
+    CloseSlip,
+    Mean,
+    Up,
+    Down,
+    StopUp,
+    StopDown,
+    SpreadThreshold,
+    kCount
+  };
+
+  const char* name;
+  size_t offset;  // in TradeRound
+  size_t width;
+
+  static const LedgerColumn & Get(int c);
+};
+
+// a ledger file is a run of self describing blocks, appended whole:
+//   LedgerBlockHeader
+//   n_params names of kLedgerNameSize chars
+//   each LedgerColumn as rounds values, padded to 8 bytes
+//   each param as rounds doubles
+// a block cut short (a writer killed mid block) is skipped by a reader,
+// which resyncs on the next magic; a writer cuts a torn tail off before
+// it appends
+static const uint32_t kLedgerMagic = 0x424c5254;  // "TRLB"
+static const uint32_t kLedgerVersion = 1;
+static const size_t kLedgerNameSize = 32;
+
+struct LedgerBlockHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t bytes;  // whole block, header included
+  uint32_t rounds;
+  uint32_t n_columns;
+  uint32_t n_params;
+  char label[64];
+};
+
+// round trips of one or more books (a pair each) into a columnar append
+// only file. rounds are staged per book in two halves sized at AddBook;
+// a full half is handed to a writer thread, which builds the block and
+// writes it through a RecordJournal while Append fills the other half,
+// so Append never allocates or touches the file on the tick path (unless
+// the writer is a whole half behind, then that half is written inline).
+// Flush (and the destructor) write the partial blocks; RecordJournal::FlushAll
+// only flushes the blocks already handed to the journal
+class TradeLedger {
+ public:
+  static const uint32_t kBlockRounds = 256;
+
+  TradeLedger();
+  ~TradeLedger();
+
+  TradeLedger(const TradeLedger&) = delete;
+  TradeLedger& operator=(const TradeLedger&) = delete;
+
+  // appends to path after its last whole block, false if it can't be
+  // opened
+  bool Open(const std::string & path);
+
+  bool IsOpen() const {
+    return out_.is_open();
+  }
+
+  // a book per pair, params are extra double columns of its rounds
+  // (knobs in force), named for the reader. returns the book id. all
+  // books are added before the first Append
+  int AddBook(const std::string & label, const std::vector<std::string> & param_names);
+
+  // params holds the book's param count values, may be nullptr if none.
+  // one thread appends (and flushes) a ledger
+  inline void Append(int book, const TradeRound & r, const double* params) {
+    if (!IsOpen()) {
+      return;
+    }
+    Book & b = *books_[book];
+    int h = b.cur;
+    uint32_t i = b.n[h];
+    b.rows[h][i] = r;
+    for (size_t k = 0; k < b.param_names.size(); k++) {
+      b.params[h][k * kBlockRounds + i] = params[k];
+    }
+    if (++b.n[h] == kBlockRounds) {
+      Handoff(&b);
+    }
+  }
+
+  void Flush();
+
+ private:
+  struct Book {
+    std::string label;
+    std::vector<std::string> param_names;
+    std::vector<TradeRound> rows[2];
+    std::vector<double> params[2];  // param k of row i at k * kBlockRounds + i
+    uint32_t n[2];
+    int cur;  // the half Append fills
+    std::atomic<bool> ready[2];  // full, for the writer
+  };
+
+  void Handoff(Book* b);
+  void StartWriter();
+  void StopWriter();
+  void Loop();
+  // io_mutex_ held
+  void WriteReady();
+  void WriteBlock(Book* b, int h);
+
+  std::ofstream out_;
+  RecordJournal journal_;  // after out_, so it is flushed before out_ closes
+  std::vector<std::unique_ptr<Book> > books_;
+  std::vector<char> block_;
+  std::mutex io_mutex_;  // journal_, block_ and the writes of full halves
+  std::condition_variable wake_;
+  bool running_;  // io_mutex_
+  std::thread writer_;
+};
+
+// one block of a mapped ledger, values used in place
+struct LedgerBlock {
+  const LedgerBlockHeader* header;
+  const char* param_names;  // n_params of kLedgerNameSize
+  const char* columns[LedgerColumn::kCount];
+  const double* params;  // param k at params + k * rounds
+
+  template <typename T>
+  inline const T* Column(LedgerColumn::Enum c) const {
+    return reinterpret_cast<const T*>(columns[c]);
+  }
+
+  inline const double* Param(size_t k) const {
+    return params + k * header->rounds;
+  }
+};
+
+// read-only mmap of a ledger file
+class TradeLedgerFile {
+ public:
+  TradeLedgerFile();
+  ~TradeLedgerFile();
+
+  TradeLedgerFile(const TradeLedgerFile&) = delete;
+  TradeLedgerFile& operator=(const TradeLedgerFile&) = delete;
+
+  // false if it can't be mapped
+  bool Open(const std::string & path);
+  void Close();
+
+  const std::vector<LedgerBlock> & Blocks() const {
+    return blocks_;
+  }
+
+  // bytes in no whole block: blocks a writer was killed in the middle
+  // of, skipped, and a torn tail
+  size_t Trailing() const {
+    return trailing_;
+  }
+
+  // just past the last whole block
+  size_t End() const {
+    return end_;
+  }
+
+  size_t Bytes() const {
+    return bytes_;
+  }
+
+ private:
+  int fd_;
+  void* map_;
+  size_t bytes_;
+  std::vector<LedgerBlock> blocks_;
+  size_t trailing_;
+  size_t end_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_TRADE_LEDGER_H_
@@ -0,0 +1,43 @@
+#ifndef STRATEGY_SRC_UTIL_TSC_H_
+#define STRATEGY_SRC_UTIL_TSC_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// raw timestamp counter, a few cycles to read. only differences mean
+// anything, TscNsPerTick() turns them into ns
+inline uint64_t TscNow() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+// measured once against CLOCK_MONOTONIC over ~10ms, on first call
+inline double TscNsPerTick() {
+  static const double ns_per_tick = [] {
+#if defined(__x86_64__) || defined(__i386__)
+    timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    uint64_t t0 = TscNow();
+    timespec wait = {0, 10000000};
+    nanosleep(&wait, nullptr);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    uint64_t t1 = TscNow();
+    double ns = (b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec);
+    return t1 > t0 ? ns / (t1 - t0) : 1.0;
+#else
+    return 1.0;
+#endif
+  }();
+  return ns_per_tick;
+}
+
+#endif  // STRATEGY_SRC_UTIL_TSC_H_
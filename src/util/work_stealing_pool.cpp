@@ -0,0 +1,92 @@
+#include <algorithm>
+
+#include "util/work_stealing_pool.h"
+
+WorkStealingPool::WorkStealingPool(int threads)
+  : next_queue_(0),
+    queued_(0),
+    unfinished_(0),
+    stop_(false) {
+  if (threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < threads; i++) {
+    queues_.emplace_back(new Queue);
+  }
+  for (int i = 0; i < threads; i++) {
+    threads_.emplace_back(&WorkStealingPool::Work, this, i);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto & t : threads_) {
+    t.join();
+  }
+}
+
+void WorkStealingPool::Submit(std::function<void()> job) {
+  unfinished_++;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Queue* q = queues_[next_queue_++ % queues_.size()].get();
+  {
+    std::lock_guard<std::mutex> q_lock(q->mutex);
+    q->jobs.emplace_back(std::move(job));
+  }
+  queued_++;
+  work_cv_.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool WorkStealingPool::Pop(int self, std::function<void()>* job) {
+  size_t n = queues_.size();
+  for (size_t k = 0; k < n; k++) {
+    Queue* q = queues_[(self + k) % n].get();
+    std::lock_guard<std::mutex> lock(q->mutex);
+    if (q->jobs.empty()) {
+      continue;
+    }
+    if (k == 0) {
+      *job = std::move(q->jobs.back());
+      q->jobs.pop_back();
+    } else {
+      *job = std::move(q->jobs.front());
+      q->jobs.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::Work(int self) {
+  std::function<void()> job;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+      if (queued_ == 0) {  // stopping with nothing left
+        return;
+      }
+      queued_--;
+    }
+    // the job counted off above is in some deque until taken, so this finds one
+    while (!Pop(self, &job)) {
+      std::this_thread::yield();
+    }
+    job();
+    job = nullptr;
+    if (--unfinished_ == 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_cv_.notify_all();
+    }
+  }
+}
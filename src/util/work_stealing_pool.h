@@ -0,0 +1,56 @@
+#ifndef STRATEGY_SRC_UTIL_WORK_STEALING_POOL_H_
+#define STRATEGY_SRC_UTIL_WORK_STEALING_POOL_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads, each with its own job deque. a worker runs
+// its own jobs newest first and, once empty, steals the oldest job of the
+// others, so uneven job lengths still keep every core busy
+class WorkStealingPool {
+ public:
+  // threads <= 0 means one per hardware thread
+  explicit WorkStealingPool(int threads = 0);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  void Submit(std::function<void()> job);
+  // block until every submitted job has finished
+  void Wait();
+
+  int Threads() const {
+    return static_cast<int>(threads_.size());
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()> > jobs;
+  };
+
+  void Work(int self);
+  bool Pop(int self, std::function<void()>* job);
+
+  std::vector<std::unique_ptr<Queue> > queues_;
+  std::vector<std::thread> threads_;
+  size_t next_queue_;
+  // jobs submitted but not taken yet, and not finished yet
+  size_t queued_;
+  std::atomic<size_t> unfinished_;
+  bool stop_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+};
+
+#endif  // STRATEGY_SRC_UTIL_WORK_STEALING_POOL_H_
@@ -0,0 +1,84 @@
+#include <stdio.h>
+
+#include <libconfig.h++>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "sweep/sweeper.h"
+#include "util/snapshot_tape.h"
+
+// sweep <config> [result.csv]
+// the day's data is mapped and merged once, every job replays the same tape
+int main(int argc, char** argv) {
+  if (argc != 2 && argc != 3) {
+    printf("usage: %s <sweep.config> [result.csv]\n", argv[0]);
+    return 1;
+  }
+  libconfig::Config cfg;
+  try {
+    cfg.readFile(argv[1]);
+  } catch (const libconfig::FileIOException &) {
+    printf("read %s failed\n", argv[1]);
+    return 1;
+  } catch (const libconfig::ParseException & e) {
+    printf("parse %s failed at line %d: %s\n", e.getFile(), e.getLine(), e.getError());
+    return 1;
+  }
+  const libconfig::Setting & root = cfg.getRoot();
+  if (!root.exists("data")) {
+    printf("no data in %s\n", argv[1]);
+    return 1;
+  }
+  SnapshotTape tape;
+  const libconfig::Setting & data = root["data"];
+  for (int i = 0; i < data.getLength(); i++) {
+    std::string path = data[i];
+    if (!tape.Add(path)) {
+      return 1;
+    }
+  }
+  tape.Build();
+  Sweeper sweeper(root);
+  auto begin = std::chrono::steady_clock::now();
+  std::vector<SweepResult> results = sweeper.Run(tape);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  printf("%zu jobs over %zu snapshots on %d threads in %.3lfs\n", results.size(), tape.size(), sweeper.Threads(), sec);
+
+  std::string header = "job,strategy";
+  for (auto & k : sweeper.Keys()) {
+    header += "," + k;
+  }
+  header += ",pnl,rounds,fills,ticks,seconds\n";
+  std::ofstream csv;
+  if (argc == 3) {
+    csv.open(argv[2], std::ios::out);
+    csv << header;
+  }
+  printf("%s", header.c_str());
+  char buffer[64];
+  for (size_t i = 0; i < results.size(); i++) {
+    const SweepResult & r = results[i];
+    std::string line = std::to_string(i) + "," + std::to_string(r.base);
+    for (double v : r.values) {
+      snprintf(buffer, sizeof(buffer), ",%g", v);
+      line += buffer;
+    }
+    snprintf(buffer, sizeof(buffer), ",%lf,%d,%d,%zu,%.3lf\n", r.stats.pnl, r.stats.rounds, r.stats.fills, r.ticks, r.seconds);
+    line += buffer;
+    printf("%s", line.c_str());
+    if (csv.is_open()) {
+      csv << line;
+    }
+  }
+  auto best = std::max_element(results.begin(), results.end(), [](const SweepResult & a, const SweepResult & b) {
+    return a.stats.pnl < b.stats.pnl;
+  });
+  if (best != results.end()) {
+    printf("best: job %zu, pnl %lf\n", static_cast<size_t>(best - results.begin()), best->stats.pnl);
+  }
+  return 0;
+}
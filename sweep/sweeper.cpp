@@ -0,0 +1,164 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "replay/replayer.h"
+#include "sweep/sweeper.h"
+#include "util/work_stealing_pool.h"
+
+namespace {
+
+// libconfig wrappers are created lazily on first access, even for reads,
+// so every touch of a Config shared between jobs goes through this
+std::mutex g_config_mutex;
+
+double Number(const libconfig::Setting & s) {
+  switch (s.getType()) {
+    case libconfig::Setting::TypeInt:
+      return static_cast<int>(s);
+    case libconfig::Setting::TypeInt64:
+      return static_cast<long long>(s);
+    case libconfig::Setting::TypeFloat:
+      return static_cast<double>(s);
+    default:
+      printf("sweep value %s is not a number\n", s.getName() ? s.getName() : "");
+      exit(1);
+  }
+}
+
+void Assign(const libconfig::Setting & from, libconfig::Setting* to) {
+  switch (from.getType()) {
+    case libconfig::Setting::TypeInt:
+      *to = static_cast<int>(from);
+      break;
+    case libconfig::Setting::TypeInt64:
+      *to = static_cast<long long>(from);
+      break;
+    case libconfig::Setting::TypeFloat:
+      *to = static_cast<double>(from);
+      break;
+    case libconfig::Setting::TypeString:
+      *to = from.c_str();
+      break;
+    case libconfig::Setting::TypeBoolean:
+      *to = static_cast<bool>(from);
+      break;
+    default:  // aggregates
+      for (int i = 0; i < from.getLength(); i++) {
+        const libconfig::Setting & child = from[i];
+        libconfig::Setting & copy = (from.getType() == libconfig::Setting::TypeGroup) ? to->add(child.getName(), child.getType()) : to->add(child.getType());
+        Assign(child, &copy);
+      }
+  }
+}
+
+// set key of group to v, in the type the key already has
+void Override(libconfig::Setting* group, const std::string & key, double v) {
+  libconfig::Setting::Type type = libconfig::Setting::TypeFloat;
+  if (group->exists(key)) {
+    type = (*group)[key.c_str()].getType();
+    group->remove(key.c_str());
+  }
+  libconfig::Setting & s = group->add(key.c_str(), type);
+  if (type == libconfig::Setting::TypeInt) {
+    s = static_cast<int>(lround(v));
+  } else if (type == libconfig::Setting::TypeInt64) {
+    s = static_cast<long long>(llround(v));
+  } else {
+    s = v;
+  }
+}
+
+}  // namespace
+
+Sweeper::Sweeper(const libconfig::Setting & root)
+  : root_(root),
+    threads_(0) {
+  try {
+    if (root.exists("exchange_file")) {
+      printf("sweep jobs can not share an exchange_file, drop it from the config\n");
+      exit(1);
+    }
+    // every job of a base strategy would append to or overwrite the same file
+    const char* job_files[] = {"checkpoint_file", "ledger_file", "spill_file"};
+    const libconfig::Setting & strategies = root["strategy"];
+    for (int i = 0; i < strategies.getLength(); i++) {
+      for (const char* key : job_files) {
+        if (strategies[i].exists(key)) {
+          printf("sweep jobs can not share a %s, drop it from strategy %d\n", key, i);
+          exit(1);
+        }
+      }
+    }
+    const libconfig::Setting & sweep = root["sweep"];
+    if (sweep.exists("threads")) {
+      threads_ = sweep["threads"];
+    }
+    const libconfig::Setting & grid = sweep["grid"];
+    for (int i = 0; i < grid.getLength(); i++) {
+      keys_.emplace_back(grid[i].getName());
+      std::vector<double> axis;
+      for (int j = 0; j < grid[i].getLength(); j++) {
+        axis.emplace_back(Number(grid[i][j]));
+      }
+      if (axis.empty()) {
+        printf("sweep axis %s is empty\n", keys_.back().c_str());
+        exit(1);
+      }
+      axes_.emplace_back(axis);
+    }
+  } catch (const libconfig::SettingException & e) {
+    printf("sweep config error at %s: %s\n", e.getPath(), e.what());
+    exit(1);
+  }
+}
+
+std::vector<SweepResult> Sweeper::Run(const SnapshotTape & tape) {
+  size_t points = 1;
+  for (auto & axis : axes_) {
+    points *= axis.size();
+  }
+  int bases = root_["strategy"].getLength();
+  std::vector<SweepResult> results(bases * points);
+  for (size_t i = 0; i < results.size(); i++) {
+    SweepResult & r = results[i];
+    r.base = i / points;
+    size_t p = i % points;
+    for (auto & axis : axes_) {
+      r.values.emplace_back(axis[p % axis.size()]);
+      p /= axis.size();
+    }
+  }
+  WorkStealingPool pool(threads_);
+  threads_ = pool.Threads();
+  for (auto & r : results) {
+    SweepResult* result = &r;
+    pool.Submit([this, &tape, result] { RunJob(tape, result); });
+  }
+  pool.Wait();
+  return results;
+}
+
+void Sweeper::RunJob(const SnapshotTape & tape, SweepResult* result) {
+  libconfig::Config job;
+  std::unique_ptr<Replayer> replayer;
+  {
+    std::lock_guard<std::mutex> lock(g_config_mutex);
+    libconfig::Setting & strategies = job.getRoot().add("strategy", libconfig::Setting::TypeList);
+    const libconfig::Setting & base = root_["strategy"][result->base];
+    libconfig::Setting & s = strategies.add(libconfig::Setting::TypeGroup);
+    Assign(base, &s);
+    for (size_t k = 0; k < keys_.size(); k++) {
+      Override(&s, keys_[k], result->values[k]);
+    }
+    replayer.reset(new Replayer(root_, strategies));
+  }
+  auto begin = std::chrono::steady_clock::now();
+  result->ticks = replayer->Run(tape);
+  result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  result->stats = *replayer->Stats()[0];
+}
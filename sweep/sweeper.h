@@ -0,0 +1,60 @@
+#ifndef STRATEGY_SWEEP_SWEEPER_H_
+#define STRATEGY_SWEEP_SWEEPER_H_
+
+#include <libconfig.h++>
+
+#include <string>
+#include <vector>
+
+#include "struct/run_stats.h"
+#include "util/snapshot_tape.h"
+
+struct SweepResult {
+  SweepResult()
+    : base(0),
+      ticks(0),
+      seconds(0.0) {
+  }
+
+  int base;  // index into the config's strategy list
+  std::vector<double> values;  // parallel to Sweeper::Keys()
+  RunStats stats;
+  size_t ticks;
+  double seconds;
+};
+
+// runs every point of a parameter grid, for every strategy of a replay
+// config, over one shared SnapshotTape. config is a replay config
+// (see replay/replayer.h) plus
+//   sweep = {
+//     threads = 0;  // optional, 0 for all cores
+//     grid = { range_width = [2.0, 3.0]; train_samples = [1000, 2000]; ... };
+//   };
+// a grid key replaces the strategy's own value, keeping its int/float type.
+// jobs would share any output file, so exchange_file and a strategy's
+// checkpoint_file, ledger_file or spill_file are rejected
+class Sweeper {
+ public:
+  explicit Sweeper(const libconfig::Setting & root);
+
+  // one job per (strategy, grid point), results come back in job order
+  std::vector<SweepResult> Run(const SnapshotTape & tape);
+
+  const std::vector<std::string> & Keys() const {
+    return keys_;
+  }
+
+  int Threads() const {
+    return threads_;
+  }
+
+ private:
+  void RunJob(const SnapshotTape & tape, SweepResult* result);
+
+  const libconfig::Setting & root_;
+  std::vector<std::string> keys_;
+  std::vector<std::vector<double> > axes_;
+  int threads_;
+};
+
+#endif  // STRATEGY_SWEEP_SWEEPER_H_
@@ -0,0 +1,59 @@
+#ifndef STRATEGY_TEST_CHECK_H_
+#define STRATEGY_TEST_CHECK_H_
+
+#include <math.h>
+#include <stdio.h>
+
+#include <vector>
+
+// TEST(name) { ... } registers a test, test/test.cpp runs them all in
+// link order. a failed EXPECT prints where and fails the test, which
+// goes on, so one run shows every broken check
+struct TestCase {
+  const char* name;
+  void (*run)();
+};
+
+class TestRegistry {
+ public:
+  TestRegistry(const char* name, void (*run)()) {
+    Cases().push_back(TestCase{name, run});
+  }
+
+  static std::vector<TestCase> & Cases() {
+    static std::vector<TestCase> cases;
+    return cases;
+  }
+
+  // failed EXPECTs so far
+  static int & Failures() {
+    static int failures = 0;
+    return failures;
+  }
+};
+
+#define TEST(name) \
+  static void Test_##name(); \
+  static TestRegistry test_registry_##name(#name, Test_##name); \
+  static void Test_##name()
+
+#define EXPECT(cond) \
+  do { \
+    if (!(cond)) { \
+      printf("%s:%d: EXPECT(%s) failed\n", __FILE__, __LINE__, #cond); \
+      TestRegistry::Failures()++; \
+    } \
+  } while (0)
+
+// NaNs are near each other, a NaN and a number are not
+#define EXPECT_NEAR(a, b, tol) \
+  do { \
+    double expect_a = (a); \
+    double expect_b = (b); \
+    if (isnan(expect_a) != isnan(expect_b) || (!isnan(expect_a) && !(fabs(expect_a - expect_b) <= (tol)))) { \
+      printf("%s:%d: EXPECT_NEAR(%s, %s) failed: %.17g vs %.17g\n", __FILE__, __LINE__, #a, #b, expect_a, expect_b); \
+      TestRegistry::Failures()++; \
+    } \
+  } while (0)
+
+#endif  // STRATEGY_TEST_CHECK_H_
@@ -0,0 +1,62 @@
+#include <libconfig.h++>
+
+#include <string>
+#include <vector>
+
+#include "bench/synthetic_feed.h"
+#include "replay/replayer.h"
+#include "simplearb2/simplearb2.h"
+#include "util/snapshot_tape.h"
+#include "test/check.h"
+
+namespace {
+
+// one PairEngine strategy on rb, see regress/sessions/synthetic.config
+const char* kSession =
+  "date = \"2019-01-02\";\n"
+  "contract_config = \"regress/contract.config\";\n"
+  "time_controller = {\n"
+  "  sleep_time = [\"10:14:59-10:30:01\", \"11:29:59-13:30:01\"];\n"
+  "  close_time = [\"14:58:00-21:00:00\"];\n"
+  "  force_close_time = \"14:57:00\";\n"
+  "  time_zone_diff = 0;\n"
+  "};\n"
+  "strategy = ({\n"
+  "  type = \"simplearb2\"; unique_name = \"rb\"; main_ticker = \"rb1910\"; hedge_ticker = \"rb1905\";\n"
+  "  max_position = 3; train_samples = 2000; min_range = 2.0; min_profit = 1.0; spread_threshold = 2.0;\n"
+  "  max_holding_sec = 36000; range_width = 2.0; max_round = 100000;\n"
+  "});\n";
+
+void RoundTrips(const char* mode) {
+  libconfig::Config cfg;
+  cfg.readString(kSession);
+  cfg.getRoot().add("mode", libconfig::Setting::TypeString) = mode;
+  SyntheticFeed feed("rb1910", "rb1905", 1.0, 3000.0, 100.0);
+  std::vector<MarketSnapshot> records;
+  for (int i = 0; i < 200000; i++) {
+    records.emplace_back(feed.Next());
+  }
+  SnapshotTape tape;
+  tape.Add(std::move(records));
+  tape.Build();
+  Replayer replayer(cfg.getRoot());
+  replayer.Run(tape);
+  const SimpleArb2* s = dynamic_cast<const SimpleArb2*>(replayer.Strategies()[0]);
+  EXPECT(s != nullptr);
+  if (s == nullptr) {
+    return;
+  }
+  EXPECT(s->Stats().rounds > 0);
+  // every order was filled inside PlaceOrder, none may be left indexed
+  EXPECT(s->Orders().Size() == 0);
+}
+
+}  // namespace
+
+TEST(PairEngineIndexEmptyAfterPlainTest) {
+  RoundTrips("PlainTest");
+}
+
+TEST(PairEngineIndexEmptyAfterNextTest) {
+  RoundTrips("NextTest");
+}
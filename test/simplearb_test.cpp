@@ -0,0 +1,89 @@
+#include <unistd.h>
+
+#include <libconfig.h++>
+
+#include <string>
+#include <vector>
+
+#include "bench/synthetic_feed.h"
+#include "replay/replayer.h"
+#include "simplearb/simplearb.h"
+#include "util/rolling_stats.h"
+#include "util/snapshot_tape.h"
+#include "util/state_checkpoint.h"
+#include "test/check.h"
+
+namespace {
+
+const int kTrainSamples = 2000;
+
+// one SimpleArb on ag, see regress/sessions/synthetic.config
+const char* kSession =
+  "date = \"2019-01-02\";\n"
+  "mode = \"NextTest\";\n"
+  "contract_config = \"regress/contract.config\";\n"
+  "time_controller = {\n"
+  "  sleep_time = [\"10:14:59-10:30:01\", \"11:29:59-13:30:01\"];\n"
+  "  close_time = [\"14:58:00-21:00:00\"];\n"
+  "  force_close_time = \"14:57:00\";\n"
+  "  time_zone_diff = 0;\n"
+  "};\n"
+  "strategy = ({\n"
+  "  type = \"simplearb\"; unique_name = \"ag\"; main_ticker = \"ag1912\"; hedge_ticker = \"ag1906\";\n"
+  "  max_position = 3; train_samples = 2000; min_range = 2.0; min_profit = 1.0; add_margin = 1.0;\n"
+  "  spread_threshold = 2.0; stop_loss_margin = 50.0; max_loss_times = 100; max_holding_sec = 36000;\n"
+  "  range_width = 2.0; split_num = 4;\n"
+  "  checkpoint_interval_sec = 60; checkpoint_max_age_sec = 600;\n"
+  "});\n";
+
+// replays the next n snapshots of feed, max_round 0 keeps it from trading
+void Replay(SyntheticFeed* feed, int n, const std::string & checkpoint_file, int max_round, double* bands) {
+  libconfig::Config cfg;
+  cfg.readString(kSession);
+  libconfig::Setting & s = cfg.getRoot()["strategy"][0];
+  s.add("checkpoint_file", libconfig::Setting::TypeString) = checkpoint_file;
+  s.add("max_round", libconfig::Setting::TypeInt) = max_round;
+  std::vector<MarketSnapshot> records;
+  for (int i = 0; i < n; i++) {
+    records.emplace_back(feed->Next());
+  }
+  SnapshotTape tape;
+  tape.Add(std::move(records));
+  tape.Build();
+  Replayer replayer(cfg.getRoot());
+  replayer.Run(tape);
+  const SimpleArb* arb = dynamic_cast<const SimpleArb*>(replayer.Strategies()[0]);
+  EXPECT(arb != nullptr);
+  if (arb != nullptr) {
+    arb->GetBands(bands);
+  }
+}
+
+}  // namespace
+
+// a restart on a full checkpointed window trades on the saved bands, the
+// first tick must not recalibrate over them
+TEST(SimpleArbWarmStartKeepsBands) {
+  std::string path = "/tmp/simplearb_test_" + std::to_string(getpid()) + ".ckpt";
+  unlink(path.c_str());
+  SyntheticFeed feed("ag1912", "ag1906", 1.0, 3000.0, 100.0);
+  double bands[SimpleArb::kBands];
+  Replay(&feed, 200000, path, 100000, bands);
+
+  double saved[SimpleArb::kBands];
+  {
+    StateCheckpoint checkpoint;
+    EXPECT(checkpoint.Open(path, "ag|ag1912|ag1906", 1, kTrainSamples, SimpleArb::kBands));
+    RollingStats window(kTrainSamples);
+    RollingStats* series[1] = {&window};
+    MarketSnapshot next = feed.Next();
+    size_t n = checkpoint.Restore(next.time.tv_sec, 600, series, saved);
+    EXPECT(n == static_cast<size_t>(kTrainSamples));
+  }
+  // the snapshot read above is skipped, the restart is a tick later
+  Replay(&feed, 2, path, 0, bands);
+  for (int i = 0; i < SimpleArb::kBands; i++) {
+    EXPECT_NEAR(bands[i], saved[i], 0.0);
+  }
+  unlink(path.c_str());
+}
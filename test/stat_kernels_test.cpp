@@ -0,0 +1,72 @@
+#include <float.h>
+#include <math.h>
+
+#include <random>
+#include <vector>
+
+#include "util/stat_kernels.h"
+#include "test/check.h"
+
+namespace {
+
+// a random walk of mids, like the bands are calibrated on
+std::vector<double> Walk(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> step(0.0, 0.5);
+  std::vector<double> v;
+  double mid = 12.5;
+  for (size_t i = 0; i < n; i++) {
+    mid += step(rng);
+    v.push_back(mid);
+  }
+  return v;
+}
+
+// error bound of a reordered sum, relative to the magnitude summed
+double Tolerance(const std::vector<double> & v, double mean) {
+  double scale = 0.0;
+  for (double x : v) {
+    scale += (x - mean) * (x - mean) + fabs(x);
+  }
+  return (v.size() + 1) * DBL_EPSILON * (scale > 1.0 ? scale : 1.0);
+}
+
+void ExpectSame(const std::vector<double> & v, double mean) {
+  const StatKernels & best = StatKernels::Best();
+  const StatKernels & scalar = StatKernels::Scalar();
+  double tolerance = Tolerance(v, mean);
+  EXPECT_NEAR(best.sum(v.data(), v.size()), scalar.sum(v.data(), v.size()), tolerance);
+  EXPECT_NEAR(best.sum_sq_dev(v.data(), v.size(), mean), scalar.sum_sq_dev(v.data(), v.size(), mean), tolerance);
+}
+
+}  // namespace
+
+// every tail length past the 16 and 4 wide loops, and windows that
+// are not a multiple of 4
+TEST(StatKernelsMatchScalar) {
+  std::vector<size_t> lengths = {1001, 2047, 50003};
+  for (size_t n = 0; n <= 40; n++) {
+    lengths.push_back(n);
+  }
+  for (size_t n : lengths) {
+    std::vector<double> v = Walk(n, static_cast<uint32_t>(n) + 1);
+    double mean = n > 0 ? StatKernels::Scalar().sum(v.data(), n) / n : 0.0;
+    ExpectSame(v, mean);
+  }
+}
+
+// a NaN in the unrolled body, the 4 wide loop or the scalar tail must
+// come out of both as NaN
+TEST(StatKernelsNaN) {
+  const size_t n = 23;  // 16 unrolled, 4 wide, 3 scalar
+  for (size_t at : {0, 5, 15, 17, 20, 22}) {
+    std::vector<double> v = Walk(n, 7);
+    v[at] = NAN;
+    ExpectSame(v, 12.5);
+    EXPECT(isnan(StatKernels::Best().sum(v.data(), n)));
+    EXPECT(isnan(StatKernels::Best().sum_sq_dev(v.data(), n, 12.5)));
+  }
+  std::vector<double> v = Walk(n, 7);
+  EXPECT(isnan(StatKernels::Best().sum_sq_dev(v.data(), n, NAN)));
+  EXPECT(isnan(StatKernels::Scalar().sum_sq_dev(v.data(), n, NAN)));
+}
@@ -0,0 +1,25 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test/check.h"
+
+// test [name]
+// runs every registered test, or the one named, from the top of the tree
+// (configs are read by relative path). nonzero if any EXPECT failed
+int main(int argc, char** argv) {
+  int failed = 0;
+  int run = 0;
+  for (const TestCase & t : TestRegistry::Cases()) {
+    if (argc == 2 && strcmp(argv[1], t.name) != 0) {
+      continue;
+    }
+    int before = TestRegistry::Failures();
+    t.run();
+    bool ok = TestRegistry::Failures() == before;
+    printf("%s %s\n", ok ? "ok  " : "FAIL", t.name);
+    failed += !ok;
+    run++;
+  }
+  printf("%d of %d tests failed\n", failed, run);
+  return (failed > 0 || run == 0) ? 1 : 0;
+}